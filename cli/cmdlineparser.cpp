@@ -54,6 +54,16 @@ static void AddFilesToList(const std::string& FileList, std::vector<std::string>
     }
 }
 
+/** Read an unsigned number. A negative number is an error, it is not wrapped around. */
+static bool readUnsigned(const std::string &str, unsigned int &value)
+{
+    std::istringstream iss(str);
+    iss >> std::ws;
+    if (iss.peek() == '-')
+        return false;
+    return bool(iss >> value);
+}
+
 CmdLineParser::CmdLineParser(Settings *settings)
     : _settings(settings)
     , _showHelp(false)
@@ -221,6 +231,36 @@ bool CmdLineParser::ParseFromArgs(int argc, const char* const argv[])
             }
         }
 
+        // --max-paths=10
+        else if (strncmp(argv[i], "--max-paths=", 12) == 0)
+        {
+            if (!readUnsigned(argv[i] + 12, _settings->_maxExecutionPaths) || _settings->_maxExecutionPaths == 0)
+            {
+                PrintMessage("cppcheck: Argument must be a positive integer. Try something like '--max-paths=10'");
+                return false;
+            }
+        }
+
+        // --max-path-time=1000
+        else if (strncmp(argv[i], "--max-path-time=", 16) == 0)
+        {
+            if (!readUnsigned(argv[i] + 16, _settings->_maxExecutionPathTime))
+            {
+                PrintMessage("cppcheck: Argument must be an integer. Try something like '--max-path-time=1000'");
+                return false;
+            }
+        }
+
+        // --config-budget=60
+        else if (strncmp(argv[i], "--config-budget=", 16) == 0)
+        {
+            if (!readUnsigned(argv[i] + 16, _settings->_configBudget) || _settings->_configBudget == 0)
+            {
+                PrintMessage("cppcheck: Argument must be a positive integer. Try something like '--config-budget=60'");
+                return false;
+            }
+        }
+
         // User define
         else if (strncmp(argv[i], "-D", 2) == 0)
         {
@@ -320,8 +360,7 @@ bool CmdLineParser::ParseFromArgs(int argc, const char* const argv[])
                 numberString = numberString.substr(2);
             }
 
-            std::istringstream iss(numberString);
-            if (!(iss >> _settings->_jobs))
+            if (!readUnsigned(numberString, _settings->_jobs))
             {
                 PrintMessage("cppcheck: argument to '-j' is not a number");
                 return false;
@@ -376,6 +415,18 @@ bool CmdLineParser::ParseFromArgs(int argc, const char* const argv[])
             _settings->test_2_pass = true;
         }
 
+        // Store function summaries between runs (implies --test-2-pass)
+        else if (strncmp(argv[i], "--summaries=", 12) == 0)
+        {
+            _settings->summaryFile = 12 + argv[i];
+            if (_settings->summaryFile.empty())
+            {
+                PrintMessage("cppcheck: No file specified for the --summaries option");
+                return false;
+            }
+            _settings->test_2_pass = true;
+        }
+
         // show timing information..
         else if (strncmp(argv[i], "--showtime=", 11) == 0)
         {
@@ -466,6 +517,13 @@ bool CmdLineParser::ParseFromArgs(int argc, const char* const argv[])
         PrintMessage("unusedFunctions check can't be used with -j option, so it was disabled.");
     }
 
+    // The summaries are not analysed with -j, so the summary file would not be written
+    if (!_settings->summaryFile.empty() && _settings->_jobs > 1)
+    {
+        PrintMessage("cppcheck: --summaries can't be used with -j option.");
+        return false;
+    }
+
     // FIXME: Make the _settings.test_2_pass thread safe
     if (_settings->test_2_pass && _settings->_jobs > 1)
     {
@@ -494,10 +552,13 @@ void CmdLineParser::PrintHelp()
     std::cout <<   "Cppcheck - A tool for static C/C++ code analysis\n"
               "\n"
               "Syntax:\n"
-              "    cppcheck [--append=file] [-D<ID>] [--enable=<id>] [--error-exitcode=[n]]\n"
+              "    cppcheck [--append=file] [--config-budget=seconds] [-D<ID>]\n"
+              "             [--enable=<id>] [--error-exitcode=[n]]\n"
               "             [--exitcode-suppressions file] [--file-list=file.txt] [--force]\n"
-              "             [--help] [-Idir] [--inline-suppr] [-j [jobs]] [--quiet]\n"
-              "             [--report-progress] [--style] [--suppressions file.txt]\n"
+              "             [--help] [-Idir] [--inline-suppr] [-j [jobs]]\n"
+              "             [--max-paths=n] [--max-path-time=ms] [--quiet]\n"
+              "             [--report-progress] [--style] [--summaries=file]\n"
+              "             [--suppressions file.txt]\n"
               "             [--verbose] [--version] [--xml] [file or path1] [file or path]\n"
               "\n"
               "If path is given instead of filename, *.cpp, *.cxx, *.cc, *.c++ and *.c files\n"
@@ -505,6 +566,13 @@ void CmdLineParser::PrintHelp()
               "Options:\n"
               "    --append=file        This allows you to provide information about\n"
               "                         functions by providing an implementation for these.\n"
+              "    --config-budget=seconds\n"
+              "                         Time for preprocessing and checking the\n"
+              "                         configurations of a file.\n"
+              "                         The configurations that cover the most lines that\n"
+              "                         are not covered yet are checked first, and the line\n"
+              "                         coverage is reported. Default is to check the 12\n"
+              "                         first configurations.\n"
               "    -D<ID>               By default Cppcheck checks all configurations.\n"
               "                         Use -D to limit the checking. When -D is used the\n"
               "                         checking is limited to the given configuration.\n"
@@ -534,9 +602,18 @@ void CmdLineParser::PrintHelp()
               "                         more comments in the form: // cppcheck-suppress memleak\n"
               "                         on the lines before the warning to suppress.\n"
               "    -j [jobs]            Start [jobs] threads to do the checking simultaneously.\n"
+              "    --max-paths=n        Max number of execution paths that are tracked in a\n"
+              "                         function. When there are more, variables with several\n"
+              "                         paths are not tracked anymore. Default is 10.\n"
+              "    --max-path-time=ms   Max time for tracking the execution paths in a\n"
+              "                         function. Default is no limit.\n"
               "    -q, --quiet          Only print error messages\n"
               "    --report-progress    Report progress messages while checking a file.\n"
               "    -s, --style          deprecated, use --enable=style\n"
+              "    --summaries=file     Analyse all files before checking them and store the\n"
+              "                         function summaries in the given file. Files that are\n"
+              "                         unchanged since the previous run are not analysed again.\n"
+              "                         This option can't be used with -j.\n"
               "    --suppressions file  Suppress warnings listed in the file. Filename and line\n"
               "                         are optional. The format of the single line in file is:\n"
               "                         [error id]:[filename]:[line]\n"
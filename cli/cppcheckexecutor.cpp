@@ -55,6 +55,11 @@ bool CppCheckExecutor::parseFromArgs(CppCheck *cppcheck, int argc, const char* c
             std::exit(0);
         }
     }
+    else
+    {
+        // The error was printed by the parser
+        return false;
+    }
 
     std::vector<std::string> pathnames = parser.GetPathNames();
     std::vector<std::string> filenames;
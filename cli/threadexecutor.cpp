@@ -36,6 +36,7 @@ ThreadExecutor::ThreadExecutor(const std::vector<std::string> &filenames, const
 {
 #if (defined(__GNUC__) || defined(__sun)) && !defined(__MINGW32__)
     _pipe[0] = _pipe[1] = 0;
+    _jobSlots[0] = _jobSlots[1] = 0;
 #endif
 }
 
@@ -123,7 +124,7 @@ unsigned int ThreadExecutor::check()
 {
     _fileCount = 0;
     unsigned int result = 0;
-    if (pipe(_pipe) == -1)
+    if (pipe(_pipe) == -1 || pipe(_jobSlots) == -1)
     {
         perror("pipe");
         exit(1);
@@ -142,12 +143,22 @@ unsigned int ThreadExecutor::check()
         exit(1);
     }
 
+    if ((flags = fcntl(_jobSlots[0], F_GETFL, 0)) < 0 ||
+        fcntl(_jobSlots[0], F_SETFL, flags | O_NONBLOCK) < 0)
+    {
+        perror("fcntl");
+        exit(1);
+    }
+
+    for (unsigned int job = 0; job < _settings._jobs; ++job)
+        returnJobSlot();
+
     unsigned int childCount = 0;
     unsigned int i = 0;
     while (true)
     {
         // Start a new child
-        if (i < _filenames.size() && childCount < _settings._jobs)
+        if (i < _filenames.size() && takeJobSlot())
         {
             pid_t pid = fork();
             if (pid < 0)
@@ -158,21 +169,7 @@ unsigned int ThreadExecutor::check()
             }
             else if (pid == 0)
             {
-                CppCheck fileChecker(*this);
-                fileChecker.settings(_settings);
-
-                if (_fileContents.size() > 0 && _fileContents.find(_filenames[i]) != _fileContents.end())
-                {
-                    // File content was given as a string
-                    fileChecker.addFile(_filenames[i], _fileContents[ _filenames[i] ]);
-                }
-                else
-                {
-                    // Read file from a file
-                    fileChecker.addFile(_filenames[i]);
-                }
-
-                unsigned int resultOfCheck = fileChecker.check();
+                unsigned int resultOfCheck = checkFile(_filenames[i]);
                 std::ostringstream oss;
                 oss << resultOfCheck;
                 writeToPipe('3', oss.str());
@@ -184,14 +181,20 @@ unsigned int ThreadExecutor::check()
         }
         else if (childCount > 0)
         {
-            // Wait for child to quit before stating new processes
-            while (true)
+            // Wait for a child to quit. A job slot can also be freed by a
+            // child that has checked a configuration of its file.
+            int readRes = 1;
+            while (readRes != -1)
             {
-                int readRes = handleRead(result);
-                if (readRes == -1)
-                    break;
-                else if (readRes == 0)
+                readRes = handleRead(result);
+                if (readRes == 0)
                 {
+                    if (i < _filenames.size() && takeJobSlot())
+                    {
+                        returnJobSlot();
+                        break;
+                    }
+
                     struct timespec duration;
                     duration.tv_sec = 0;
                     duration.tv_nsec = 5 * 1000 * 1000;        // 5 ms
@@ -199,9 +202,13 @@ unsigned int ThreadExecutor::check()
                 }
             }
 
-            int stat = 0;
-            waitpid(0, &stat, 0);
-            --childCount;
+            if (readRes == -1)
+            {
+                int stat = 0;
+                waitpid(0, &stat, 0);
+                --childCount;
+                returnJobSlot();
+            }
         }
         else if (childCount == 0)
         {
@@ -210,10 +217,93 @@ unsigned int ThreadExecutor::check()
         }
     }
 
+    close(_jobSlots[0]);
+    close(_jobSlots[1]);
+
+    return result;
+}
+
+unsigned int ThreadExecutor::checkFile(const std::string &filename)
+{
+    CppCheck fileChecker(*this);
+    fileChecker.settings(_settings);
+
+    if (_fileContents.size() > 0 && _fileContents.find(filename) != _fileContents.end())
+    {
+        // File content was given as a string
+        fileChecker.addFile(filename, _fileContents[ filename ]);
+    }
+    else
+    {
+        // Read file from a file
+        fileChecker.addFile(filename);
+    }
+
+    // The time budget for the configurations (--config-budget) is per file
+    if (_settings._configBudget > 0)
+        return fileChecker.check();
+
+    // The file is preprocessed in this process. Its configurations are
+    // checked in new child processes while there are free job slots, and
+    // the children get the code of their configuration when they are forked.
+    const std::list<CppCheck::Configuration> configurations(fileChecker.getConfigurations(filename));
+    unsigned int result = fileChecker.getExitCode();
+    unsigned int helpers = 0;
+    for (std::list<CppCheck::Configuration>::const_iterator it = configurations.begin(); it != configurations.end(); ++it)
+    {
+        // The last configuration is checked in this process
+        std::list<CppCheck::Configuration>::const_iterator next = it;
+        ++next;
+        if (next != configurations.end() && takeJobSlot())
+        {
+            pid_t pid = fork();
+            if (pid == 0)
+                exit(fileChecker.checkConfiguration(filename, *it) ? 1 : 0);
+
+            if (pid > 0)
+            {
+                ++helpers;
+                continue;
+            }
+
+            // fork failed, check the configuration here
+            returnJobSlot();
+        }
+
+        if (fileChecker.checkConfiguration(filename, *it))
+            result = 1;
+    }
+
+    // Merge the results of the configurations
+    for (; helpers > 0; --helpers)
+    {
+        int stat = 0;
+        wait(&stat);
+        if (!WIFEXITED(stat) || WEXITSTATUS(stat) != 0)
+            result = 1;
+        returnJobSlot();
+    }
 
+    fileChecker.reportSkippedConfigurations(filename);
     return result;
 }
 
+bool ThreadExecutor::takeJobSlot()
+{
+    char slot = 0;
+    return (read(_jobSlots[0], &slot, 1) == 1);
+}
+
+void ThreadExecutor::returnJobSlot()
+{
+    const char slot = 'j';
+    if (write(_jobSlots[1], &slot, 1) <= 0)
+    {
+        std::cerr << "#### ThreadExecutor::returnJobSlot, Failed to write to pipe" << std::endl;
+        exit(0);
+    }
+}
+
 void ThreadExecutor::writeToPipe(char type, const std::string &data)
 {
     unsigned int len = data.length() + 1;
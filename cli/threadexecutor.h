@@ -27,7 +27,9 @@
 
 /**
  * This class will take a list of filenames and settings and check then
- * all files using threads.
+ * all files using threads. Each file is preprocessed in a child process,
+ * and its configurations are checked in further child processes while
+ * there are free job slots.
  */
 class ThreadExecutor : public ErrorLogger
 {
@@ -66,8 +68,32 @@ private:
      */
     int handleRead(unsigned int &result);
     void writeToPipe(char type, const std::string &data);
+
+    /**
+     * @brief Check a file. This is called in a child process.
+     * @param filename the file
+     * @return 1 if errors were found in the file, otherwise 0
+     */
+    unsigned int checkFile(const std::string &filename);
+
+    /**
+     * @brief Take a free job slot
+     * @return false if there are no free job slots
+     */
+    bool takeJobSlot();
+
+    /** @brief Give back a job slot, after the child process that used it has quit */
+    void returnJobSlot();
+
     int _pipe[2];
     std::list<std::string> _errorList;
+
+    /**
+     * @brief The free job slots. There is one byte in the pipe for each
+     * free slot. The processes that check files and configurations share
+     * the -j slots through it.
+     */
+    int _jobSlots[2];
 public:
     /**
      * @return true if support for threads exist.
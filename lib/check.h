@@ -68,7 +68,7 @@ public:
     /**
      * analyse code - must be thread safe
      * @param tokens The tokens to analyse
-     * @param result container where results are stored
+     * @param result container where results are stored. Each check has its own container.
      */
     virtual void analyse(const Token *tokens, std::set<std::string> &result) const
     {
@@ -97,6 +97,12 @@ public:
     /** get error messages */
     virtual void getErrorMessages(ErrorLogger *errorLogger, const Settings *settings) = 0;
 
+    /** settings that the check was created with */
+    const Settings *getSettings() const
+    {
+        return _settings;
+    }
+
     /** class name, used to generate documentation */
     virtual std::string name() const = 0;
 
@@ -727,7 +727,7 @@ void CheckBufferOverrun::checkScope(const Token *tok, const std::vector<std::str
     {
         if (Token::Match(tok, "%varid% [ %num% ]", varid))
         {
-            const MathLib::bigint index = MathLib::toLongNumber(tok->strAt(2));
+            const MathLib::bigint index = tok->tokAt(2)->numericValue().getInt();
             if (index >= size)
             {
                 arrayIndexOutOfBounds(tok, size, index);
@@ -736,7 +736,7 @@ void CheckBufferOverrun::checkScope(const Token *tok, const std::vector<std::str
     }
     else if (Token::Match(tok, (varnames + " [ %num% ]").c_str()))
     {
-        const MathLib::bigint index = MathLib::toLongNumber(tok->strAt(2 + varc));
+        const MathLib::bigint index = tok->tokAt(2 + varc)->numericValue().getInt();
         if (index >= size)
         {
             arrayIndexOutOfBounds(tok->tokAt(varc), size, index);
@@ -747,8 +747,18 @@ void CheckBufferOverrun::checkScope(const Token *tok, const std::vector<std::str
     // out of bounds then this flag will be set.
     bool pointerIsOutOfBounds = false;
 
+    // All patterns below start before the variable so the checking can
+    // stop after the last occurrence of the variable.
+    const Token *end = 0;
+    if (varid > 0)
+    {
+        const std::vector<const Token *> &occurrences = _tokenizer->getVarOccurrences(varid);
+        if (!occurrences.empty())
+            end = occurrences.back()->next();
+    }
+
     int indentlevel = 0;
-    for (; tok; tok = tok->next())
+    for (; tok && tok != end; tok = tok->next())
     {
         if (tok->str() == "{")
         {
@@ -773,7 +783,7 @@ void CheckBufferOverrun::checkScope(const Token *tok, const std::vector<std::str
         {
             if (!tok->isName() && !Token::Match(tok, "[.&]") && Token::Match(tok->next(), "%varid% [ %num% ]", varid))
             {
-                const MathLib::bigint index = MathLib::toLongNumber(tok->strAt(3));
+                const MathLib::bigint index = tok->tokAt(3)->numericValue().getInt();
                 if (index < 0 || index >= size)
                 {
                     if (index > size || !Token::Match(tok->previous(), "& ("))
@@ -784,7 +794,7 @@ void CheckBufferOverrun::checkScope(const Token *tok, const std::vector<std::str
             }
             if (Token::Match(tok, "return %varid% [ %num% ]", varid))
             {
-                const MathLib::bigint index = MathLib::toLongNumber(tok->strAt(3));
+                const MathLib::bigint index = tok->tokAt(3)->numericValue().getInt();
                 if (index < 0 || index >= size)
                 {
                     arrayIndexOutOfBounds(tok->next(), size, index);
@@ -793,7 +803,7 @@ void CheckBufferOverrun::checkScope(const Token *tok, const std::vector<std::str
         }
         else if (!tok->isName() && !Token::Match(tok, "[.&]") && Token::Match(tok->next(), (varnames + " [ %num% ]").c_str()))
         {
-            const MathLib::bigint index = MathLib::toLongNumber(tok->strAt(3 + varc));
+            const MathLib::bigint index = tok->tokAt(3 + varc)->numericValue().getInt();
             if (index >= size)
             {
                 arrayIndexOutOfBounds(tok->tokAt(1 + varc), size, index);
@@ -913,7 +923,7 @@ void CheckBufferOverrun::checkScope(const Token *tok, const std::vector<std::str
         const std::string snprintfPattern = varid > 0 ? std::string("snprintf ( %varid% , %num% ,") : ("snprintf ( " + varnames + " , %num% ,");
         if (Token::Match(tok, snprintfPattern.c_str(), varid))
         {
-            const MathLib::bigint n = MathLib::toLongNumber(tok->strAt(4 + varc));
+            const MathLib::bigint n = tok->tokAt(4 + varc)->numericValue().getInt();
             if (n > total_size)
                 outOfBounds(tok->tokAt(4 + varc), "snprintf size");
         }
@@ -927,7 +937,7 @@ void CheckBufferOverrun::checkScope(const Token *tok, const std::vector<std::str
         // undefined behaviour: result of pointer arithmetic is out of bounds
         if (Token::Match(tok, "= %varid% + %num% ;", varid))
         {
-            const MathLib::bigint index = MathLib::toLongNumber(tok->strAt(3));
+            const MathLib::bigint index = tok->tokAt(3)->numericValue().getInt();
             if (index > size && _settings->_checkCodingStyle)
                 pointerOutOfBounds(tok->next(), "buffer");
             if (index >= size && Token::Match(tok->tokAt(-2), "[;{}] %varid% =", varid))
@@ -966,7 +976,7 @@ void CheckBufferOverrun::checkScope(const Token *tok, const ArrayInfo &arrayInfo
             std::vector<MathLib::bigint> indexes;
             for (const Token *tok2 = tok->next(); Token::Match(tok2, "[ %num% ]"); tok2 = tok2->tokAt(3))
             {
-                const MathLib::bigint index = MathLib::toLongNumber(tok2->strAt(1));
+                const MathLib::bigint index = tok2->tokAt(1)->numericValue().getInt();
                 if (index < 0)
                 {
                     indexes.clear();
@@ -1250,7 +1260,7 @@ void CheckBufferOverrun::checkGlobalAndLocalVariable()
 
             // get maximum size from type
             // find where this token is defined
-            const Token *index_type = Token::findmatch(_tokenizer->tokens(), "%varid%", tok->tokAt(varpos + 2)->varId());
+            const Token *index_type = _tokenizer->findVarMatch("%varid%", tok->tokAt(varpos + 2)->varId());
 
             index_type = index_type->previous();
 
@@ -1318,7 +1328,8 @@ void CheckBufferOverrun::checkGlobalAndLocalVariable()
         else if (indentlevel > 0 &&
                  Token::Match(tok, "[;{}] %var% = %str% ;") &&
                  tok->next()->varId() > 0 &&
-                 NULL != Token::findmatch(_tokenizer->tokens(), "[;{}] const| %type% * %varid% ;", tok->next()->varId()))
+                 (NULL != _tokenizer->findVarMatch("[;{}] %type% * %varid% ;", tok->next()->varId(), 3) ||
+                  NULL != _tokenizer->findVarMatch("[;{}] const %type% * %varid% ;", tok->next()->varId(), 4)))
         {
             size = 1 + int(tok->tokAt(3)->strValue().size());
             type = "char";
@@ -1335,7 +1346,7 @@ void CheckBufferOverrun::checkGlobalAndLocalVariable()
             if (varid > 0)
             {
                 // get type of variable
-                const Token *declTok = Token::findmatch(_tokenizer->tokens(), "[;{}] %type% * %varid% ;", varid);
+                const Token *declTok = _tokenizer->findVarMatch("[;{}] %type% * %varid% ;", varid, 3);
                 if (!declTok)
                     continue;
 
@@ -1872,7 +1883,7 @@ void CheckBufferOverrun::negativeIndex()
 
             if (tok2->previous() && tok2->previous()->varId())
             {
-                const Token *tok3 = Token::findmatch(_tokenizer->tokens(), "%varid%", tok2->previous()->varId());
+                const Token *tok3 = _tokenizer->findVarMatch("%varid%", tok2->previous()->varId());
                 if (tok3 && Token::Match(tok3->next(), "[ %any% ] ;|["))
                     negativeIndexError(tok, index);
             }
@@ -2032,6 +2043,12 @@ private:
         return (value == c->value);
     }
 
+    /** @brief hash value for the state */
+    unsigned int hash_value() const
+    {
+        return static_cast<unsigned int>(value);
+    }
+
     /** @brief Buffer information */
     const std::map<unsigned int, CheckBufferOverrun::ArrayInfo> &arrayInfo;
 
@@ -2178,7 +2195,7 @@ void CheckBufferOverrun::executionPaths()
 
     // Perform checking - check how the arrayInfo arrays are used
     ExecutionPathBufferOverrun c(this, arrayInfo);
-    checkExecutionPaths(_tokenizer->tokens(), &c);
+    checkExecutionPaths(_tokenizer, _settings, &c);
 }
 
 
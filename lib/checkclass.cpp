@@ -185,6 +185,19 @@ void CheckClass::operatorEqVarError(const Token *tok, const std::string &classna
 // ClassCheck: Unused private functions
 //---------------------------------------------------------------------------
 
+/** Remove function from list of unused functions */
+static void removeFunction(std::list<const Token *> &FuncList, const std::string &funcname)
+{
+    std::list<const Token *>::iterator it = FuncList.begin();
+    while (it != FuncList.end())
+    {
+        if (funcname == (*it)->str())
+            FuncList.erase(it++);
+        else
+            ++it;
+    }
+}
+
 void CheckClass::privateFunctions()
 {
     if (!_settings->_checkCodingStyle)
@@ -254,87 +267,36 @@ void CheckClass::privateFunctions()
 
         // Check that all private functions are used..
         bool HasFuncImpl = false;
-        bool inclass = false;
-        int indent_level = 0;
-        for (const Token *ftok = _tokenizer->tokens(); ftok; ftok = ftok->next())
+        std::list<SymbolDatabase::SpaceInfo *>::const_iterator j;
+        for (j = symbolDatabase->spaceInfoList.begin(); j != symbolDatabase->spaceInfoList.end(); ++j)
         {
-            if (ftok->str() == "{")
-                ++indent_level;
-            else if (ftok->str() == "}")
-            {
-                if (indent_level > 0)
-                    --indent_level;
-                if (indent_level == 0)
-                    inclass = false;
-            }
+            const SymbolDatabase::SpaceInfo *function = *j;
 
-            else if (ftok->str() == "class" &&
-                     ftok->next()->str() == classname &&
-                     Token::Match(ftok->tokAt(2), ":|{"))
-            {
-                indent_level = 0;
-                inclass = true;
-            }
-
-            // Check member class functions to see what functions are used..
-            else if ((inclass && indent_level == 1 && Token::Match(ftok, "%var% (")) ||
-                     (ftok->str() == classname && Token::Match(ftok->next(), ":: ~| %var% (")))
-            {
-                while (ftok && ftok->str() != ")")
-                    ftok = ftok->next();
-                if (!ftok)
-                    break;
-                if (Token::Match(ftok, ") : %var% ("))
-                {
-                    while (!Token::Match(ftok->next(), "[{};]"))
-                    {
-                        if (Token::Match(ftok, "::|,|( %var% ,|)"))
-                        {
-                            // Remove function from FuncList
-                            std::list<const Token *>::iterator it = FuncList.begin();
-                            while (it != FuncList.end())
-                            {
-                                if (ftok->next()->str() == (*it)->str())
-                                    FuncList.erase(it++);
-                                else
-                                    ++it;
-                            }
-                        }
-                        ftok = ftok->next();
-                    }
-                }
-                if (!Token::Match(ftok, ") const| {"))
-                    continue;
+            // only check the member functions of this class
+            if (function->type != SymbolDatabase::SpaceInfo::Function || function->functionOf != info)
+                continue;
 
-                if (ftok->fileIndex() == 0)
-                    HasFuncImpl = true;
+            if (function->classDef->fileIndex() == 0)
+                HasFuncImpl = true;
 
-                // Parse function..
-                int indentlevel2 = 0;
-                for (const Token *tok2 = ftok; tok2; tok2 = tok2->next())
+            // Function names in the initialization list..
+            const Token *ftok = function->classDef;
+            while (ftok && ftok->str() != ")")
+                ftok = ftok->next();
+            if (Token::Match(ftok, ") : %var% ("))
+            {
+                while (!Token::Match(ftok->next(), "[{};]"))
                 {
-                    if (tok2->str() == "{")
-                        ++indentlevel2;
-                    else if (tok2->str() == "}")
-                    {
-                        --indentlevel2;
-                        if (indentlevel2 < 1)
-                            break;
-                    }
-                    else if (Token::Match(tok2, "%var% ("))
-                    {
-                        // Remove function from FuncList
-                        std::list<const Token *>::iterator it = FuncList.begin();
-                        while (it != FuncList.end())
-                        {
-                            if (tok2->str() == (*it)->str())
-                                FuncList.erase(it++);
-                            else
-                                ++it;
-                        }
-                    }
+                    if (Token::Match(ftok, "::|,|( %var% ,|)"))
+                        removeFunction(FuncList, ftok->next()->str());
+                    ftok = ftok->next();
                 }
             }
+
+            // Functions that are called..
+            const std::vector<SymbolDatabase::CallSite> &calls = symbolDatabase->getCalls(function);
+            for (std::vector<SymbolDatabase::CallSite>::const_iterator call = calls.begin(); call != calls.end(); ++call)
+                removeFunction(FuncList, call->tok->str());
         }
 
         while (HasFuncImpl && !FuncList.empty())
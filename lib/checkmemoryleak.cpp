@@ -21,12 +21,14 @@
 #include "mathlib.h"
 #include "tokenize.h"
 #include "executionpath.h"
+#include "timer.h"
 
 #include <algorithm>
 #include <cstring>
 #include <cstdlib>
 #include <iostream>
 #include <sstream>
+#include <map>
 #include <set>
 #include <stack>
 
@@ -157,8 +159,17 @@ CheckMemoryLeak::AllocType CheckMemoryLeak::getAllocationType(const Token *tok2,
     if (Token::Match(tok2, "open|openat|creat|mkstemp|mkostemp ("))
     {
         // is there a user function with this name?
-        if (tokenizer && Token::findmatch(tokenizer->tokens(), ("%type% *|&| " + tok2->str()).c_str()))
-            return No;
+        if (tokenizer)
+        {
+            std::map<std::string, bool>::const_iterator it = userFunctions.find(tok2->str());
+            if (it == userFunctions.end())
+            {
+                const bool found = (NULL != Token::findmatch(tokenizer->tokens(), ("%type% *|&| " + tok2->str()).c_str()));
+                it = userFunctions.insert(std::make_pair(tok2->str(), found)).first;
+            }
+            if (it->second)
+                return No;
+        }
         return Fd;
     }
 
@@ -320,6 +331,7 @@ void CheckMemoryLeak::reportErr(const std::list<const Token *> &callstack, Sever
 
     const ErrorLogger::ErrorMessage errmsg(locations, severity, msg, id);
 
+    ++reportedErrors;
     if (errorLogger)
         errorLogger->reportErr(errmsg);
     else
@@ -554,6 +566,68 @@ const char *CheckMemoryLeak::functionArgAlloc(const Token *tok, unsigned int tar
 }
 
 
+void CheckMemoryLeakInFunction::analyse(const Token *tokens, std::set<std::string> &result) const
+{
+    for (const Token *tok = tokens; tok; tok = tok->next())
+    {
+        if (tok->str() == "{")
+        {
+            tok = tok->link();
+            continue;
+        }
+
+        // function implementation..
+        if (!Token::Match(tok, "%type% *| %var% ("))
+            continue;
+        const Token *ftok = tok->next()->str() == "*" ? tok->tokAt(2) : tok->next();
+        const Token *body = ftok->next()->link();
+        if (Token::simpleMatch(body, ") const"))
+            body = body->next();
+        if (!Token::simpleMatch(body, ") {"))
+            continue;
+        body = body->next();
+
+        for (const Token *tok2 = body; tok2 != body->link(); tok2 = tok2->next())
+        {
+            if (Token::Match(tok2, "[;{}] exit ("))
+            {
+                result.insert("noreturn " + ftok->str());
+                break;
+            }
+        }
+
+        const AllocType allocType = functionReturnType(ftok);
+        if (allocType != No)
+            result.insert("alloc " + ftok->str() + " " + MathLib::toString<int>(allocType));
+
+        tok = body->link();
+    }
+}
+
+void CheckMemoryLeakInFunction::parse_summaries()
+{
+    const std::map<std::string, std::set<std::string> >::const_iterator summaries = _settings->functionSummaries.find(name());
+    if (summaries == _settings->functionSummaries.end())
+        return;
+
+    const std::set<std::string> &data = summaries->second;
+    for (std::set<std::string>::const_iterator it = data.begin(); it != data.end(); ++it)
+    {
+        std::istringstream istr(*it);
+        std::string type, funcname;
+        istr >> type >> funcname;
+        if (type == "noreturn")
+            noreturn.insert(funcname);
+        else if (type == "alloc")
+        {
+            int allocType = No;
+            istr >> allocType;
+            if (allocType > No && allocType <= Many)
+                analysedAllocFunctions[funcname] = static_cast<AllocType>(allocType);
+        }
+    }
+}
+
 void CheckMemoryLeakInFunction::parse_noreturn()
 {
     noreturn.insert("exit");
@@ -565,33 +639,17 @@ void CheckMemoryLeakInFunction::parse_noreturn()
     noreturn.insert("errx");
     noreturn.insert("verrx");
 
-    std::list<SymbolDatabase::SpaceInfo *>::const_iterator i;
-
-    for (i = symbolDatabase->spaceInfoList.begin(); i != symbolDatabase->spaceInfoList.end(); ++i)
+    // functions that contain an "exit" call..
+    const std::vector<SymbolDatabase::CallSite> &calls = symbolDatabase->getCallSites("exit");
+    for (std::vector<SymbolDatabase::CallSite>::const_iterator call = calls.begin(); call != calls.end(); ++call)
     {
-        SymbolDatabase::SpaceInfo *info = *i;
-
-        // only check functions
-        if (info->type != SymbolDatabase::SpaceInfo::Function)
+        if (!Token::Match(call->tok->previous(), "[;{}]"))
             continue;
 
-        // parse this function to check if it contains an "exit" call..
-        unsigned int indentlevel = 1;
-        for (const Token *tok2 = info->classStart->next(); tok2; tok2 = tok2->next())
+        for (const SymbolDatabase::SpaceInfo *info = call->caller; info; info = info->nestedIn)
         {
-            if (tok2->str() == "{")
-                ++indentlevel;
-            else if (tok2->str() == "}")
-            {
-                --indentlevel;
-                if (indentlevel == 0)
-                    break;
-            }
-            if (Token::Match(tok2, "[;{}] exit ("))
-            {
+            if (info->type == SymbolDatabase::SpaceInfo::Function)
                 noreturn.insert(info->className);
-                break;
-            }
         }
     }
 }
@@ -648,6 +706,33 @@ bool CheckMemoryLeakInFunction::test_white_list(const std::string &funcname)
                          sizeof(call_func_white_list[0]), call_func_white_list_compare) != NULL);
 }
 
+/** Key for the function call summaries that call_func saves */
+static std::string callSummaryKey(const std::string &funcname, unsigned int par, unsigned int sz, CheckMemoryLeak::AllocType alloctype, CheckMemoryLeak::AllocType dealloctype)
+{
+    std::ostringstream ostr;
+    ostr << funcname << " " << par << " " << sz << " " << alloctype << " " << dealloctype;
+    return ostr.str();
+}
+
+bool CheckMemoryLeakInFunction::findCallSummary(const std::map<std::string, CallSummary> &summaries, const std::string &key, AllocType &alloctype, AllocType &dealloctype)
+{
+    const std::map<std::string, CallSummary>::const_iterator it = summaries.find(key);
+    if (it == summaries.end())
+        return false;
+    alloctype = it->second.alloctype;
+    dealloctype = it->second.dealloctype;
+    ++reusedSummaries;
+    return true;
+}
+
+void CheckMemoryLeakInFunction::addCallSummary(std::map<std::string, CallSummary> &summaries, const std::string &key, const char *ret, AllocType alloctype, AllocType dealloctype)
+{
+    CallSummary &summary = summaries[key];
+    summary.ret = ret;
+    summary.alloctype = alloctype;
+    summary.dealloctype = dealloctype;
+}
+
 const char * CheckMemoryLeakInFunction::call_func(const Token *tok, std::list<const Token *> callstack, const unsigned int varid, AllocType &alloctype, AllocType &dealloctype, bool &allocpar, unsigned int sz)
 {
     if (test_white_list(tok->str()))
@@ -695,15 +780,25 @@ const char * CheckMemoryLeakInFunction::call_func(const Token *tok, std::list<co
     }
     callstack.push_back(tok);
 
+    // The result of a top level call only depends on the called function
+    // and the allocation state. These results are saved so the function
+    // is analysed only once.
+    const bool useSummary(callstack.size() == 1);
+
     // lock/unlock..
     if (varid == 0)
     {
+        const std::string key(useSummary ? callSummaryKey(funcname, 0, 1, alloctype, dealloctype) : "");
+        if (useSummary && findCallSummary(callSummaries, key, alloctype, dealloctype))
+            return callSummaries[key].ret;
+
         const Token *ftok = _tokenizer->getFunctionTokenByName(funcname.c_str());
         while (ftok && (ftok->str() != "{"))
             ftok = ftok->next();
         if (!ftok)
             return 0;
 
+        const unsigned int errors = errorCount();
         Token *func = getcode(ftok->tokAt(1), callstack, 0, alloctype, dealloctype, false, 1);
         simplifycode(func);
         const char *ret = 0;
@@ -712,6 +807,10 @@ const char * CheckMemoryLeakInFunction::call_func(const Token *tok, std::list<co
         else if (Token::simpleMatch(func, "; dealloc ; }"))
             ret = "dealloc";
         Tokenizer::deleteTokens(func);
+
+        // errors are reported with the callstack so they can't be reused
+        if (useSummary && errors == errorCount())
+            addCallSummary(callSummaries, key, ret, alloctype, dealloctype);
         return ret;
     }
 
@@ -719,7 +818,20 @@ const char * CheckMemoryLeakInFunction::call_func(const Token *tok, std::list<co
     if (Token::Match(tok->tokAt(-3), "[;{}] %varid% = %var% (", varid))
     {
         const Token *ftok = _tokenizer->getFunctionTokenByName(funcname.c_str());
-        AllocType a = functionReturnType(ftok);
+        AllocType a = No;
+        if (ftok)
+        {
+            const std::map<std::string, AllocType>::const_iterator it = returnTypes.find(funcname);
+            if (it == returnTypes.end())
+                a = returnTypes[funcname] = functionReturnType(ftok);
+            else
+            {
+                a = it->second;
+                ++reusedSummaries;
+            }
+        }
+        else if (analysedAllocFunctions.find(funcname) != analysedAllocFunctions.end())
+            a = analysedAllocFunctions[funcname];
         if (a != No)
         {
             if (alloctype == No)
@@ -782,9 +894,15 @@ const char * CheckMemoryLeakInFunction::call_func(const Token *tok, std::list<co
                 }
                 if (parameterVarid == 0)
                     return "recursive";
+
+                const std::string key(useSummary ? callSummaryKey(funcname, par, sz, alloctype, dealloctype) : "");
+                if (useSummary && findCallSummary(callSummaries, key, alloctype, dealloctype))
+                    return callSummaries[key].ret;
+
                 // Check if the function deallocates the variable..
                 while (ftok && (ftok->str() != "{"))
                     ftok = ftok->next();
+                const unsigned int errors = errorCount();
                 Token *func = getcode(ftok->tokAt(1), callstack, parameterVarid, alloctype, dealloctype, false, sz);
                 //simplifycode(func, all);
                 const Token *func_ = func;
@@ -801,13 +919,25 @@ const char * CheckMemoryLeakInFunction::call_func(const Token *tok, std::list<co
                     ret = "&use";
 
                 Tokenizer::deleteTokens(func);
+
+                if (useSummary && errors == errorCount())
+                    addCallSummary(callSummaries, key, ret, alloctype, dealloctype);
                 return ret;
             }
             if (varid > 0 && Token::Match(tok, "[,()] & %varid% [,()]", varid))
             {
-                const Token *ftok = _tokenizer->getFunctionTokenByName(funcname.c_str());
                 AllocType a;
-                const char *ret = functionArgAlloc(ftok, par, a);
+                const char *ret;
+                const std::string key(callSummaryKey(funcname, par, 0, No, No));
+                AllocType unused;
+                if (findCallSummary(argAllocSummaries, key, a, unused))
+                    ret = argAllocSummaries[key].ret;
+                else
+                {
+                    const Token *ftok = _tokenizer->getFunctionTokenByName(funcname.c_str());
+                    ret = functionArgAlloc(ftok, par, a);
+                    addCallSummary(argAllocSummaries, key, ret, a, No);
+                }
 
                 if (a != No)
                 {
@@ -988,7 +1118,7 @@ Token *CheckMemoryLeakInFunction::getcode(const Token *tok, std::list<const Toke
                     if (alloc != Many && dealloctype != No && dealloctype != Many && dealloctype != alloc)
                     {
                         callstack.push_back(tok);
-                        mismatchAllocDealloc(callstack, Token::findmatch(_tokenizer->tokens(), "%varid%", varid)->str());
+                        mismatchAllocDealloc(callstack, _tokenizer->findVarMatch("%varid%", varid)->str());
                         callstack.pop_back();
                     }
 
@@ -1045,7 +1175,7 @@ Token *CheckMemoryLeakInFunction::getcode(const Token *tok, std::list<const Toke
                     if (dealloc != Many && alloctype != No && alloctype != Many && alloctype != dealloc)
                     {
                         callstack.push_back(tok);
-                        mismatchAllocDealloc(callstack, Token::findmatch(_tokenizer->tokens(), "%varid%", varid)->str());
+                        mismatchAllocDealloc(callstack, _tokenizer->findVarMatch("%varid%", varid)->str());
                         callstack.pop_back();
                     }
                     dealloctype = dealloc;
@@ -1525,89 +1655,694 @@ Token *CheckMemoryLeakInFunction::getcode(const Token *tok, std::list<const Toke
 
 
 
-void CheckMemoryLeakInFunction::simplifycode(Token *tok)
+//---------------------------------------------------------------------------
+// Rewrite rules that are used by simplifycode
+//---------------------------------------------------------------------------
+
+/** Replace "{ }" with ";" */
+static bool simplifyEmptyBlock(Token *&tok, bool)
+{
+    Token::eraseTokens(tok, tok->tokAt(3));
+    tok->insertToken(";");
+    return true;
+}
+
+/** Delete braces around a single instruction.. */
+static bool simplifyBlock1(Token *&tok, bool)
+{
+    tok->deleteNext();
+    Token::eraseTokens(tok->tokAt(2), tok->tokAt(4));
+    return true;
+}
+
+static bool simplifyBlock2(Token *&tok, bool)
+{
+    tok->deleteNext();
+    Token::eraseTokens(tok->tokAt(3), tok->tokAt(5));
+    return true;
+}
+
+/** Reduce "if X ; else X ;" => "X ;" */
+static bool simplifyIfElseSame(Token *&tok, bool)
+{
+    if (tok->strAt(2) != tok->strAt(5))
+        return false;
+    Token::eraseTokens(tok, tok->tokAt(5));
+    return true;
+}
+
+/** "[;{}] if alloc ; else return ;" => "[;{}] alloc ;" */
+static bool simplifyIfAllocElseReturn(Token *&tok, bool)
+{
+    tok->deleteNext();                              // Remove "if"
+    Token::eraseTokens(tok->next(), tok->tokAt(5)); // Remove "; else return"
+    return true;
+}
+
+/** Remove "else" after "if continue|break|return" */
+static bool simplifyElseAfterJump(Token *&tok, bool)
+{
+    tok->tokAt(4)->deleteThis();
+    return true;
+}
+
+/** Delete "if { dealloc|assign|use ; return ; }" */
+static bool simplifyIfBlockReturn(Token *&tok, bool)
 {
+    Token::eraseTokens(tok, tok->tokAt(8));
+    if (Token::simpleMatch(tok->next(), "else"))
+        tok->deleteNext();
+    return true;
+}
+
+/** Reduce "ifv return;" => "if return use;" */
+static bool simplifyIfvReturn(Token *&tok, bool)
+{
+    tok->str("if");
+    tok->next()->insertToken("use");
+    return true;
+}
+
+/** Reduce "; if(!var) alloc ; !!else" => "; dealloc ; alloc ;" */
+static bool simplifyIfNotVarAlloc(Token *&tok, bool)
+{
+    // Remove the "if(!var)"
+    Token::eraseTokens(tok, tok->tokAt(2));
+
+    // Insert "dealloc ;" before the "alloc ;"
+    tok->insertToken(";");
+    tok->insertToken("dealloc");
+    return true;
+}
+
+/** Reduce "if* ;".. */
+static bool simplifyEmptyIf(Token *&tok, bool)
+{
+    // Followed by else..
+    if (Token::simpleMatch(tok->tokAt(3), "else"))
     {
-        // Replace "throw" that is not in a try block with "return"
-        int indentlevel = 0;
-        int trylevel = -1;
-        for (Token *tok2 = tok; tok2; tok2 = tok2->next())
-        {
-            if (tok2->str() == "{")
-                ++indentlevel;
-            else if (tok2->str() == "}")
-            {
-                --indentlevel;
-                if (indentlevel <= trylevel)
-                    trylevel = -1;
-            }
-            else if (trylevel == -1 && tok2->str() == "try")
-                trylevel = indentlevel;
-            else if (trylevel == -1 && tok2->str() == "throw")
-                tok2->str("return");
-        }
-    }
+        tok = tok->next();
+        if (tok->str() == "if(var)")
+            tok->str("if(!var)");
+        else if (tok->str() == "if(!var)")
+            tok->str("if(var)");
 
-    // Insert extra ";"
-    for (Token *tok2 = tok; tok2; tok2 = tok2->next())
+        // remove the "; else"
+        Token::eraseTokens(tok, tok->tokAt(3));
+    }
+    else
     {
-        if (!tok2->previous() || Token::Match(tok2->previous(), "[;{}]"))
-        {
-            if (Token::Match(tok2, "assign|callfunc|use assign|callfunc|use"))
-            {
-                tok2->insertToken(";");
-            }
-        }
+        // remove the "if* ;"
+        Token::eraseTokens(tok, tok->tokAt(3));
     }
+    return true;
+}
 
-    // remove redundant braces..
-    for (Token *start = tok; start; start = start->next())
+/** Reduce "while1 continue| ;" => "use ;" */
+static bool simplifyWhile1(Token *&tok, bool)
+{
+    tok->str("use");
+    while (tok->strAt(1) != ";")
+        tok->deleteNext();
+    return true;
+}
+
+/** Reduce "while1 if break ;" => ";" */
+static bool simplifyWhile1IfBreak(Token *&tok, bool)
+{
+    tok->str(";");
+    Token::eraseTokens(tok, tok->tokAt(3));
+    return true;
+}
+
+/** Delete the current token */
+static bool simplifyDeleteThis(Token *&tok, bool)
+{
+    tok->deleteThis();
+    return true;
+}
+
+/** Remove "if exit ;" */
+static bool simplifyIfExit(Token *&tok, bool)
+{
+    tok->deleteThis();
+    tok->deleteThis();
+    return true;
+}
+
+/** Remove the "if break|continue ;" that follows "dealloc ; alloc ;" */
+static bool simplifyDeallocAllocIfBreak(Token *&tok, bool inconclusive)
+{
+    if (inconclusive)
+        return false;
+    tok = tok->tokAt(3);
+    Token::eraseTokens(tok, tok->tokAt(3));
+    return true;
+}
+
+/** Reduce "do { alloc ; } " => "alloc ;" */
+static bool simplifyDoAlloc(Token *&tok, bool)
+{
+    /** @todo If the loop "do { alloc ; }" can be executed twice, reduce it to "loop alloc ;" */
+    Token::eraseTokens(tok, tok->tokAt(3));
+    Token::eraseTokens(tok->tokAt(2), tok->tokAt(4));
+    return true;
+}
+
+/** Reduce "loop|while1 { dealloc ; alloc ; }" */
+static bool simplifyLoopDeallocAlloc(Token *&tok, bool)
+{
+    // delete "loop|while1"
+    tok->deleteThis();
+    // delete "{"
+    tok->deleteThis();
+
+    // delete "}"
+    Token::eraseTokens(tok->tokAt(3), tok->tokAt(5));
+    return true;
+}
+
+/** loop { use ; callfunc ; }  =>  use ; */
+static bool simplifyLoopUseCallfunc(Token *&tok, bool)
+{
+    // assume that the "callfunc" is not noreturn
+    Token::eraseTokens(tok, tok->tokAt(7));
+    tok->str("use");
+    tok->insertToken(";");
+    return true;
+}
+
+/** use; if| use; => use; */
+static bool simplifyUseUse(Token *&tok, bool)
+{
+    Token *t = tok->tokAt(2);
+    t->deleteNext();
+    t->deleteNext();
+    if (t->strAt(1) == ";")
+        t->deleteNext();
+    return true;
+}
+
+/** try/catch */
+static bool simplifyTryCatchExit(Token *&tok, bool)
+{
+    Token::eraseTokens(tok, tok->tokAt(4));
+    tok->deleteThis();
+    return true;
+}
+
+/** Replace switch with if (if not complicated) */
+static bool simplifySwitch(Token *&tok2, bool)
+{
+    // Right now, I just handle if there are a few case and perhaps a default.
+    bool valid = false;
+    bool incase = false;
+    for (const Token * _tok = tok2->tokAt(2); _tok; _tok = _tok->next())
     {
-        if (Token::simpleMatch(start, "; {"))
+        if (_tok->str() == "{")
+            break;
+
+        else if (_tok->str() == "}")
         {
-            // the "link" doesn't work here. Find the end brace..
-            unsigned int indent = 0;
-            for (Token *end = start; end; end = end->next())
-            {
-                if (end->str() == "{")
-                    ++indent;
-                else if (end->str() == "}")
-                {
-                    if (indent <= 1)
-                    {
-                        // If the start/end braces are redundant, delete them
-                        if (indent == 1 && Token::Match(end->previous(), "[;{}] } %any%"))
-                        {
-                            start->deleteNext();
-                            end->deleteThis();
-                        }
-                        break;
-                    }
-                    --indent;
-                }
-            }
+            valid = true;
+            break;
         }
+
+        else if (_tok->str() == "switch")
+            break;
+
+        else if (_tok->str() == "loop")
+            break;
+
+        else if (incase && _tok->str() == "case")
+            break;
+
+        else if (Token::Match(_tok, "return !!;"))
+            break;
+
+        if (Token::Match(_tok, "if return|break use| ;"))
+            _tok = _tok->tokAt(2);
+
+        incase |= (_tok->str() == "case");
+        incase &= (_tok->str() != "break" && _tok->str() != "return");
     }
 
-    // reduce the code..
-    // it will be reduced in N passes. When a pass completes without any
-    // simplifications the loop is done.
-    bool done = false;
-    while (! done)
-    {
-        //tok->printOut("simplifycode loop..");
-        done = true;
+    if (incase || !valid)
+        return false;
 
-        // reduce callfunc
-        for (Token *tok2 = tok; tok2; tok2 = tok2->next())
+    tok2->str(";");
+    Token::eraseTokens(tok2, tok2->tokAt(2));
+    tok2 = tok2->next();
+    bool first = true;
+    while (Token::Match(tok2, "case|default"))
+    {
+        const bool def(tok2->str() == "default");
+        tok2->str(first ? "if" : "}");
+        if (first)
         {
-            if (tok2->str() == "callfunc")
-            {
-                if (!Token::Match(tok2->previous(), "[;{}] callfunc ; }"))
-                    tok2->deleteThis();
-            }
+            first = false;
+            tok2->insertToken("{");
         }
-
+        else
+        {
+            // Insert "else [if] {
+            tok2->insertToken("{");
+            if (! def)
+                tok2->insertToken("if");
+            tok2->insertToken("else");
+            tok2 = tok2->next();
+        }
+        while (tok2)
+        {
+            if (tok2->str() == "}")
+                break;
+            if (Token::Match(tok2, "break|return ;"))
+                break;
+            if (Token::Match(tok2, "if return|break use| ;"))
+                tok2 = tok2->tokAt(2);
+            else
+                tok2 = tok2->next();
+        }
+        if (Token::simpleMatch(tok2, "break ;"))
+        {
+            tok2->str(";");
+            tok2 = tok2->tokAt(2);
+        }
+        else if (tok2 && tok2->str() == "return")
+        {
+            tok2 = tok2->tokAt(2);
+        }
+    }
+    return true;
+}
+
+namespace
+{
+/**
+ * @brief A rewrite rule for simplifycode.
+ *
+ * The pattern is matched at "tok->tokAt(offset)". When it matches either
+ * the tokens between "tok->tokAt(eraseFrom)" and "tok->tokAt(eraseTo)"
+ * are erased or the rewrite function is called.
+ */
+struct SimplifyRule
+{
+    /** Rule flags */
+    enum
+    {
+        /** Apply the rule as long as it matches */
+        Repeat = 1,
+
+        /** "else": skip the rule if an earlier rule in the chain was applied */
+        Else = 2,
+
+        /** No rewrite. If it matches, the rest of the chain is tried and then the token is done */
+        Guard = 4,
+
+        /**
+         * The rule looks at the code after the pattern. It is tried
+         * at every matching token in every pass.
+         */
+        Scan = 8
+    };
+
+    const char *pattern;
+    int offset;
+    int eraseFrom;
+    int eraseTo;
+
+    /**
+     * Rewrite the code. The token is moved if the matching of the
+     * following rules should continue at another token.
+     * @return false if the rule was not applied after all
+     */
+    bool (*rewrite)(Token *&tok, bool inconclusive);
+
+    unsigned int flags;
+};
+}
+
+/**
+ * The rewrite rules. At each token the rules are tried in this order.
+ */
+static const SimplifyRule simplifyRules[] =
+{
+    // Delete extra ";"
+    { "[;{}] ;", 0, 0, 2, 0, SimplifyRule::Repeat },
+    { "{ }", 1, 0, 0, simplifyEmptyBlock, 0 },
+    { "{ %var% ; }", 1, 0, 0, simplifyBlock1, 0 },
+    { "{ %var% %var% ; }", 1, 0, 0, simplifyBlock2, 0 },
+    // Reduce "if if|callfunc" => "if"
+    { "if if|callfunc", 0, 0, 2, 0, SimplifyRule::Else },
+    { "if", 1, 0, 0, 0, SimplifyRule::Else | SimplifyRule::Guard },
+    // Delete empty if that is not followed by an else
+    { "if ; !!else", 1, 0, 2, 0, SimplifyRule::Else },
+    { "if %var% ; else %var% ;", 1, 0, 0, simplifyIfElseSame, SimplifyRule::Else },
+    // Reduce "if continue ; if continue ;" => "if continue ;"
+    { "if continue ; if continue ;", 1, 0, 4, 0, SimplifyRule::Else },
+    // Reduce "if return ; alloc ;" => "alloc ;"
+    { "[;{}] if return ; alloc|return ;", 0, 0, 4, 0, SimplifyRule::Else },
+    { "[;{}] if alloc ; else return ;", 0, 0, 0, simplifyIfAllocElseReturn, SimplifyRule::Else },
+    // Reduce "if ; else %var% ;" => "if %var% ;"
+    { "if ; else %var% ;", 1, 1, 4, 0, SimplifyRule::Else },
+    // Reduce "if ; else" => "if"
+    { "if ; else", 1, 1, 4, 0, SimplifyRule::Else },
+    // Reduce "if return ; else|if return|continue ;" => "if return ;"
+    { "if return ; else|if return|continue|break ;", 1, 3, 6, 0, SimplifyRule::Else },
+    // Reduce "if continue|break ; else|if return ;" => "if return ;"
+    { "if continue|break ; if|else return ;", 1, 1, 5, 0, SimplifyRule::Else },
+    { "if continue|break|return ; else", 1, 0, 0, simplifyElseAfterJump, SimplifyRule::Else },
+    { "[;{}] if { dealloc|assign|use ; return ; }", 0, 0, 0, simplifyIfBlockReturn, SimplifyRule::Else },
+    // Remove "if { dealloc ; callfunc ; } !!else"
+    { "if { dealloc|assign ; callfunc ; } !!else", 1, 0, 8, 0, SimplifyRule::Else },
+    // Reduce "alloc while(!var) alloc ;" => "alloc ;"
+    { "[;{}] alloc ; while(!var) alloc ;", 0, 0, 4, 0, 0 },
+    { "ifv return ;", 0, 0, 0, simplifyIfvReturn, 0 },
+    // Reduce "if(var) dealloc ;" and "if(var) use ;" that is not followed by an else..
+    { "[;{}] if(var) assign|dealloc|use ; !!else", 0, 0, 2, 0, 0 },
+    { "; if(!var) alloc ; !!else", 0, 0, 0, simplifyIfNotVarAlloc, 0 },
+    // Reduce "; if(!var) exit ;" => ";"
+    { "; if(!var) exit ;", 0, 0, 3, 0, 0 },
+    { "if(var)|if(!var)|ifv ;", 1, 0, 0, simplifyEmptyIf, 0 },
+    // Reduce "else ;" => ";"
+    { "else ;", 1, 0, 2, 0, 0 },
+    { "while1 if| continue| ;", 0, 0, 0, simplifyWhile1, 0 },
+    { "while1 if break ;", 0, 0, 0, simplifyWhile1IfBreak, 0 },
+    // Delete if block: "alloc; if return use ;"
+    { "alloc ; if return use ; !!else", 0, 0, 5, 0, 0 },
+    // Reduce "alloc|dealloc|use|callfunc ; exit ;" => "; exit ;"
+    { "[;{}] alloc|dealloc|use|callfunc ; exit ;", 0, 0, 2, 0, 0 },
+    // Reduce "alloc|dealloc|use ; if(var) exit ;"
+    { "alloc|dealloc|use ; if(var) exit ;", 0, 0, 0, simplifyDeleteThis, 0 },
+    { "if exit ;", 0, 0, 0, simplifyIfExit, 0 },
+    { "dealloc ; alloc ; if break|continue ;", 0, 0, 0, simplifyDeallocAllocIfBreak, 0 },
+    // if break ; break ; => break ;
+    { "[;{}] if break ; break ;", -1, 0, 4, 0, 0 },
+    // Reduce "do { dealloc ; alloc ; } while(var) ;" => ";"
+    { "do { dealloc ; alloc ; } while(var) ;", 1, 0, 9, 0, 0 },
+    { "do { alloc ; }", 1, 0, 0, simplifyDoAlloc, 0 },
+    // Reduce "loop break ; => ";"
+    { "loop break|continue ;", 1, 0, 3, 0, 0 },
+    // Reduce "loop|do ;" => ";"
+    { "loop|do ;", 0, 0, 0, simplifyDeleteThis, 0 },
+    // Reduce "loop if break|continue ; !!else" => ";"
+    { "loop if break|continue ; !!else", 1, 0, 4, 0, 0 },
+    // Reduce "loop { if break|continue ; !!else" => "loop {"
+    { "loop { if break|continue ; !!else", 0, 1, 5, 0, 0 },
+    // Replace "do ; loop ;" with ";"
+    { "; loop ;", 0, 0, 3, 0, 0 },
+    // Replace "loop loop .." with "loop .."
+    { "loop loop", 0, 0, 0, simplifyDeleteThis, 0 },
+    // Replace "loop if return ;" with "if return ;"
+    { "loop if return", 1, 0, 2, 0, 0 },
+    { "loop|while1 { dealloc ; alloc ; }", 0, 0, 0, simplifyLoopDeallocAlloc, 0 },
+    { "loop { use ; callfunc ; }", 0, 0, 0, simplifyLoopUseCallfunc, 0 },
+    // Delete if block in "alloc ; if(!var) return ;"
+    { "alloc ; if(!var) return ;", 0, 0, 4, 0, 0 },
+    // Reduce "[;{}] return use ; %var%" => "[;{}] return use ;"
+    { "[;{}] return use ; %var%", 0, 3, 5, 0, 0 },
+    // Reduce "if(var) return use ;" => "return use ;"
+    { "if(var) return use ; !!else", 1, 0, 2, 0, 0 },
+    // malloc - realloc => alloc ; dealloc ; alloc ;
+    // Reduce "[;{}] alloc ; dealloc ; alloc ;" => "[;{}] alloc ;"
+    { "[;{}] alloc ; dealloc ; alloc ;", 0, 1, 6, 0, 0 },
+    // use; dealloc; => dealloc;
+    { "[;{}] use ; dealloc ;", 0, 0, 3, 0, 0 },
+    // use use => use
+    { "use use", 0, 0, 0, simplifyDeleteThis, 0 },
+    { "[;{}] use ; if| use ;", 0, 0, 0, simplifyUseUse, SimplifyRule::Repeat },
+    // Delete first part in "use ; return use ;"
+    { "[;{}] use ; return use ;", 0, 0, 3, 0, 0 },
+    { "try ; catch exit ;", 0, 0, 0, simplifyTryCatchExit, 0 },
+    // Delete second case in "case ; case ;"
+    { "case ; case ;", 0, 0, 3, 0, SimplifyRule::Repeat },
+    { "switch {", 0, 0, 0, simplifySwitch, SimplifyRule::Scan }
+};
+
+static const unsigned int numberOfSimplifyRules = sizeof(simplifyRules) / sizeof(simplifyRules[0]);
+
+/** Apply rewrite rule. Returns false if the rule was not applied */
+static bool applySimplifyRule(const SimplifyRule &rule, Token *&tok, bool inconclusive)
+{
+    if (rule.rewrite)
+        return rule.rewrite(tok, inconclusive);
+    Token::eraseTokens(tok->tokAt(rule.eraseFrom), tok->tokAt(rule.eraseTo));
+    return true;
+}
+
+namespace
+{
+/**
+ * @brief The rewrite rules compiled into a lookup table.
+ *
+ * The rules are looked up by the first token of the pattern so only the
+ * rules that can match at a token are tried.
+ */
+class SimplifyRuleIndex
+{
+public:
+    SimplifyRuleIndex() : window(0)
+    {
+        unsigned int chain = 0;
+        for (unsigned int i = 0; i < numberOfSimplifyRules; ++i)
+        {
+            const SimplifyRule &rule = simplifyRules[i];
+            if (!(rule.flags & SimplifyRule::Else))
+                chain = i;
+            chainStart.push_back(chain);
+
+            std::istringstream istr(rule.pattern);
+            std::string first;
+            istr >> first;
+
+            std::vector<std::string> keys;
+            if (first.size() > 2 && first[0] == '[' && first[first.size() - 1] == ']')
+            {
+                for (std::string::size_type pos = 1; pos + 1 < first.size(); ++pos)
+                    keys.push_back(first.substr(pos, 1));
+            }
+            else if (first[0] != '%' && first[0] != '!' && first[first.size() - 1] != '|' && first.find("||") == std::string::npos)
+            {
+                std::string::size_type pos = 0;
+                while (pos <= first.size())
+                {
+                    const std::string::size_type end = std::min(first.find("|", pos), first.size());
+                    keys.push_back(first.substr(pos, end - pos));
+                    pos = end + 1;
+                }
+            }
+
+            if (rule.flags & SimplifyRule::Scan)
+                scanTokens.insert(keys.begin(), keys.end());
+
+            if (keys.empty())
+                any[rule.offset + 1].push_back(i);
+            for (std::vector<std::string>::const_iterator it = keys.begin(); it != keys.end(); ++it)
+                byFirstToken[rule.offset + 1][*it].push_back(i);
+
+            // How far from the token can the rule see? A rewrite may
+            // look one token past the pattern and move the token a few
+            // steps forward.
+            unsigned int length = 1 + 1 + 3;
+            std::string s;
+            while (istr >> s)
+                ++length;
+            length += (unsigned int)std::abs(rule.offset);
+            window = std::max(window, length);
+        }
+    }
+
+    /**
+     * Find the first rule that matches at the given token
+     * @param tok the token
+     * @param first the first rule to try
+     * @return index of the matching rule. numberOfSimplifyRules if no rule matches
+     */
+    unsigned int match(const Token *tok, unsigned int first) const
+    {
+        unsigned int best = numberOfSimplifyRules;
+        for (int offset = -1; offset <= 1; ++offset)
+        {
+            const Token *start = tok->tokAt(offset);
+            if (!start)
+                continue;
+            const std::map<std::string, std::vector<unsigned int> >::const_iterator it = byFirstToken[offset + 1].find(start->str());
+            if (it != byFirstToken[offset + 1].end())
+                best = firstMatch(it->second, start, first, best);
+            best = firstMatch(any[offset + 1], start, first, best);
+        }
+        return best;
+    }
+
+    /** Should the rules be tried at the token in every pass? */
+    bool alwaysTry(const Token *tok) const
+    {
+        return scanTokens.find(tok->str()) != scanTokens.end();
+    }
+
+    /** index of the first rule in the "else" chain of each rule */
+    std::vector<unsigned int> chainStart;
+
+    /**
+     * How many tokens around a token the rules look at. When the code is
+     * rewritten, the rules must be tried again at the tokens this close.
+     */
+    unsigned int window;
+
+private:
+    /** First matching rule in the list that is in the range [first,best) */
+    static unsigned int firstMatch(const std::vector<unsigned int> &rules, const Token *start, unsigned int first, unsigned int best)
+    {
+        for (std::vector<unsigned int>::const_iterator it = rules.begin(); it != rules.end() && *it < best; ++it)
+        {
+            if (*it >= first && Token::Match(start, simplifyRules[*it].pattern))
+                return *it;
+        }
+        return best;
+    }
+
+    std::map<std::string, std::vector<unsigned int> > byFirstToken[3];
+    std::vector<unsigned int> any[3];
+
+    /** First tokens of the Scan rules */
+    std::set<std::string> scanTokens;
+};
+}
+
+static const SimplifyRuleIndex simplifyRuleIndex;
+
+/**
+ * Apply rewrite rule and remove the deleted tokens from the sets of
+ * tokens that are tried again. A new token may get the address of a
+ * deleted token.
+ * @return false if the rule was not applied
+ */
+static bool applySimplifyRule(const SimplifyRule &rule, Token *&tok, bool inconclusive,
+                              std::set<const Token *> &revisit, std::set<const Token *> &nextRevisit)
+{
+    // The rules only delete tokens after "tok" that are within the window
+    const Token * const start = tok;
+    std::vector<const Token *> near;
+    const Token *end = start->next();
+    while (end && near.size() <= simplifyRuleIndex.window)
+    {
+        near.push_back(end);
+        end = end->next();
+    }
+
+    if (!applySimplifyRule(rule, tok, inconclusive))
+        return false;
+
+    std::set<const Token *> alive;
+    for (const Token *tok2 = start->next(); tok2 && tok2 != end; tok2 = tok2->next())
+        alive.insert(tok2);
+    for (std::vector<const Token *>::const_iterator it = near.begin(); it != near.end(); ++it)
+    {
+        if (alive.find(*it) == alive.end())
+        {
+            revisit.erase(*it);
+            nextRevisit.erase(*it);
+        }
+    }
+    return true;
+}
+
+void CheckMemoryLeakInFunction::simplifycode(Token *tok)
+{
+    {
+        // Replace "throw" that is not in a try block with "return"
+        int indentlevel = 0;
+        int trylevel = -1;
+        for (Token *tok2 = tok; tok2; tok2 = tok2->next())
+        {
+            if (tok2->str() == "{")
+                ++indentlevel;
+            else if (tok2->str() == "}")
+            {
+                --indentlevel;
+                if (indentlevel <= trylevel)
+                    trylevel = -1;
+            }
+            else if (trylevel == -1 && tok2->str() == "try")
+                trylevel = indentlevel;
+            else if (trylevel == -1 && tok2->str() == "throw")
+                tok2->str("return");
+        }
+    }
+
+    // Insert extra ";"
+    for (Token *tok2 = tok; tok2; tok2 = tok2->next())
+    {
+        if (!tok2->previous() || Token::Match(tok2->previous(), "[;{}]"))
+        {
+            if (Token::Match(tok2, "assign|callfunc|use assign|callfunc|use"))
+            {
+                tok2->insertToken(";");
+            }
+        }
+    }
+
+    // remove redundant braces..
+    for (Token *start = tok; start; start = start->next())
+    {
+        if (Token::simpleMatch(start, "; {"))
+        {
+            // the "link" doesn't work here. Find the end brace..
+            unsigned int indent = 0;
+            for (Token *end = start; end; end = end->next())
+            {
+                if (end->str() == "{")
+                    ++indent;
+                else if (end->str() == "}")
+                {
+                    if (indent <= 1)
+                    {
+                        // If the start/end braces are redundant, delete them
+                        if (indent == 1 && Token::Match(end->previous(), "[;{}] } %any%"))
+                        {
+                            start->deleteNext();
+                            end->deleteThis();
+                        }
+                        break;
+                    }
+                    --indent;
+                }
+            }
+        }
+    }
+
+    // reduce the code..
+    // it will be reduced in N passes. When a pass completes without any
+    // simplifications the loop is done.
+    if (simplifyRulesFired.empty())
+        simplifyRulesFired.resize(numberOfSimplifyRules, 0);
+
+    // After the first pass the rules are only tried at tokens close to
+    // the code that was rewritten in the previous pass. Elsewhere the
+    // code is the same as last time and no rule would match.
+    std::set<const Token *> revisit, nextRevisit;
+    bool fullPass = true;
+
+    bool done = false;
+    while (! done)
+    {
+        //tok->printOut("simplifycode loop..");
+        done = true;
+        ++simplifyPasses;
+
+        // reduce callfunc
+        for (Token *tok2 = tok; tok2; tok2 = tok2->next())
+        {
+            if (tok2->str() == "callfunc")
+            {
+                if (!Token::Match(tok2->previous(), "[;{}] callfunc ; }"))
+                {
+                    tok2->deleteThis();
+                    fullPass = true;
+                }
+            }
+        }
+
         // If the code starts with "if return ;" then remove it
         if (Token::Match(tok, ";| if return ;"))
         {
@@ -1617,6 +2352,7 @@ void CheckMemoryLeakInFunction::simplifycode(Token *tok)
                 tok->deleteThis();
             if (tok->strAt(1) == "else")
                 tok->deleteNext();
+            fullPass = true;
         }
 
         // simplify "while1" contents..
@@ -1640,6 +2376,7 @@ void CheckMemoryLeakInFunction::simplifycode(Token *tok)
                         Token::eraseTokens(tok3, tok3->tokAt(6));
                         if (Token::simpleMatch(tok3->next(), "else"))
                             tok3->deleteNext();
+                        fullPass = true;
                     }
                 }
 
@@ -1648,526 +2385,96 @@ void CheckMemoryLeakInFunction::simplifycode(Token *tok)
                     tok2->str(";");
                     Token::eraseTokens(tok2, tok2->tokAt(4));
                     Token::eraseTokens(tok2->tokAt(4), tok2->tokAt(7));
+                    fullPass = true;
                 }
             }
         }
 
-        // Main inner simplification loop
+        // Main inner simplification loop. The rewrite rules are tried
+        // at each token in the order they are listed in simplifyRules.
+        bool nextFullPass = false;
+        unsigned int forceVisit = 0;
         for (Token *tok2 = tok; tok2; tok2 = tok2 ? tok2->next() : NULL)
         {
-            // Delete extra ";"
-            while (Token::Match(tok2, "[;{}] ;"))
-            {
-                tok2->deleteNext();
-                done = false;
-            }
+            if (forceVisit > 0)
+                --forceVisit;
+            else if (!fullPass && !simplifyRuleIndex.alwaysTry(tok2) && revisit.find(tok2) == revisit.end())
+                continue;
 
-            // Replace "{ }" with ";"
-            if (Token::simpleMatch(tok2->next(), "{ }"))
-            {
-                tok2->eraseTokens(tok2, tok2->tokAt(3));
-                tok2->insertToken(";");
-                done = false;
-            }
+            Token * const start = tok2;
+            bool changed = false;
+            bool scan = false;
 
-            // Delete braces around a single instruction..
-            if (Token::Match(tok2->next(), "{ %var% ; }"))
-            {
-                tok2->deleteNext();
-                Token::eraseTokens(tok2->tokAt(2), tok2->tokAt(4));
-                done = false;
-            }
-            if (Token::Match(tok2->next(), "{ %var% %var% ; }"))
-            {
-                tok2->deleteNext();
-                Token::eraseTokens(tok2->tokAt(3), tok2->tokAt(5));
-                done = false;
-            }
-
-            // Reduce "if if|callfunc" => "if"
-            else if (Token::Match(tok2, "if if|callfunc"))
-            {
-                tok2->deleteNext();
-                done = false;
-            }
+            // state of the current "else" chain
+            int last = -1;
+            bool chainApplied = false;
+            bool stop = false;
 
-            else if (tok2->next() && tok2->next()->str() == "if")
+            unsigned int rule = simplifyRuleIndex.match(tok2, 0);
+            while (rule < numberOfSimplifyRules)
             {
-                // Delete empty if that is not followed by an else
-                if (Token::Match(tok2->next(), "if ; !!else"))
-                {
-                    tok2->deleteNext();
-                    done = false;
-                }
-
-                // Reduce "if X ; else X ;" => "X ;"
-                else if (Token::Match(tok2->next(), "if %var% ; else %var% ;") &&
-                         std::string(tok2->strAt(2)) == std::string(tok2->strAt(5)))
-                {
-                    Token::eraseTokens(tok2, tok2->tokAt(5));
-                    done = false;
-                }
-
-                // Reduce "if continue ; if continue ;" => "if continue ;"
-                else if (Token::Match(tok2->next(), "if continue ; if continue ;"))
-                {
-                    Token::eraseTokens(tok2, tok2->tokAt(4));
-                    done = false;
-                }
-
-                // Reduce "if return ; alloc ;" => "alloc ;"
-                else if (Token::Match(tok2, "[;{}] if return ; alloc|return ;"))
-                {
-                    Token::eraseTokens(tok2, tok2->tokAt(4));
-                    done = false;
-                }
-
-                // "[;{}] if alloc ; else return ;" => "[;{}] alloc ;"
-                else if (Token::Match(tok2, "[;{}] if alloc ; else return ;"))
-                {
-                    tok2->deleteNext();                                // Remove "if"
-                    Token::eraseTokens(tok2->next(), tok2->tokAt(5));  // Remove "; else return"
-                    done = false;
-                }
-
-                // Reduce "if ; else %var% ;" => "if %var% ;"
-                else if (Token::Match(tok2->next(), "if ; else %var% ;"))
-                {
-                    Token::eraseTokens(tok2->next(), tok2->tokAt(4));
-                    done = false;
-                }
-
-                // Reduce "if ; else" => "if"
-                else if (Token::simpleMatch(tok2->next(), "if ; else"))
-                {
-                    Token::eraseTokens(tok2->next(), tok2->tokAt(4));
-                    done = false;
-                }
-
-                // Reduce "if return ; else|if return|continue ;" => "if return ;"
-                else if (Token::Match(tok2->next(), "if return ; else|if return|continue|break ;"))
-                {
-                    Token::eraseTokens(tok2->tokAt(3), tok2->tokAt(6));
-                    done = false;
-                }
-
-                // Reduce "if continue|break ; else|if return ;" => "if return ;"
-                else if (Token::Match(tok2->next(), "if continue|break ; if|else return ;"))
-                {
-                    Token::eraseTokens(tok2->next(), tok2->tokAt(5));
-                    done = false;
-                }
-
-                // Remove "else" after "if continue|break|return"
-                else if (Token::Match(tok2->next(), "if continue|break|return ; else"))
+                const SimplifyRule &r = simplifyRules[rule];
+                if ((int)simplifyRuleIndex.chainStart[rule] > last)
                 {
-                    tok2->tokAt(4)->deleteThis();
-                    done = false;
-                }
-
-                // Delete "if { dealloc|assign|use ; return ; }"
-                else if (Token::Match(tok2, "[;{}] if { dealloc|assign|use ; return ; }"))
-                {
-                    Token::eraseTokens(tok2, tok2->tokAt(8));
-                    if (Token::simpleMatch(tok2->next(), "else"))
-                        tok2->deleteNext();
-                    done = false;
-                }
-
-                // Remove "if { dealloc ; callfunc ; } !!else"
-                else if (Token::Match(tok2->next(), "if { dealloc|assign ; callfunc ; } !!else"))
-                {
-                    Token::eraseTokens(tok2, tok2->tokAt(8));
-                    done = false;
+                    if (stop)
+                        break;
+                    chainApplied = false;
                 }
+                last = (int)rule;
 
-                continue;
-            }
-
-            // Reduce "alloc while(!var) alloc ;" => "alloc ;"
-            if (Token::Match(tok2, "[;{}] alloc ; while(!var) alloc ;"))
-            {
-                Token::eraseTokens(tok2, tok2->tokAt(4));
-                done = false;
-            }
-
-            // Reduce "ifv return;" => "if return use;"
-            if (Token::simpleMatch(tok2, "ifv return ;"))
-            {
-                tok2->str("if");
-                tok2->next()->insertToken("use");
-                done = false;
-            }
-
-            // Reduce "if(var) dealloc ;" and "if(var) use ;" that is not followed by an else..
-            if (Token::Match(tok2, "[;{}] if(var) assign|dealloc|use ; !!else"))
-            {
-                Token::eraseTokens(tok2, tok2->tokAt(2));
-                done = false;
-            }
-
-            // Reduce "; if(!var) alloc ; !!else" => "; dealloc ; alloc ;"
-            if (Token::Match(tok2, "; if(!var) alloc ; !!else"))
-            {
-                // Remove the "if(!var)"
-                Token::eraseTokens(tok2, tok2->tokAt(2));
-
-                // Insert "dealloc ;" before the "alloc ;"
-                tok2->insertToken(";");
-                tok2->insertToken("dealloc");
-
-                done = false;
-            }
-
-            // Reduce "; if(!var) exit ;" => ";"
-            if (Token::Match(tok2, "; if(!var) exit ;"))
-            {
-                Token::eraseTokens(tok2, tok2->tokAt(3));
-                done = false;
-            }
-
-            // Reduce "if* ;"..
-            if (Token::Match(tok2->next(), "if(var)|if(!var)|ifv ;"))
-            {
-                // Followed by else..
-                if (Token::simpleMatch(tok2->tokAt(3), "else"))
+                if ((r.flags & SimplifyRule::Else) && chainApplied)
                 {
-                    tok2 = tok2->next();
-                    if (tok2->str() == "if(var)")
-                        tok2->str("if(!var)");
-                    else if (tok2->str() == "if(!var)")
-                        tok2->str("if(var)");
-
-                    // remove the "; else"
-                    Token::eraseTokens(tok2, tok2->tokAt(3));
+                    // an earlier rule in the chain was applied
                 }
+                else if (r.flags & SimplifyRule::Guard)
+                    stop = true;
                 else
                 {
-                    // remove the "if* ;"
-                    Token::eraseTokens(tok2, tok2->tokAt(3));
+                    while (applySimplifyRule(r, tok2, _settings->inconclusive, revisit, nextRevisit))
+                    {
+                        ++simplifyRulesFired[rule];
+                        chainApplied = changed = true;
+                        if (r.flags & SimplifyRule::Scan)
+                            scan = true;
+                        if (!tok2 || !(r.flags & SimplifyRule::Repeat) || !Token::Match(tok2->tokAt(r.offset), r.pattern))
+                            break;
+                    }
                 }
-                done = false;
-            }
-
-            // Reduce "else ;" => ";"
-            if (Token::simpleMatch(tok2->next(), "else ;"))
-            {
-                Token::eraseTokens(tok2, tok2->tokAt(2));
-                done = false;
-            }
-
-            // Reduce "while1 continue| ;" => "use ;"
-            if (Token::Match(tok2, "while1 if| continue| ;"))
-            {
-                tok2->str("use");
-                while (tok2->strAt(1) != ";")
-                    tok2->deleteNext();
-                done = false;
-            }
-
-            // Reduce "while1 if break ;" => ";"
-            if (Token::simpleMatch(tok2, "while1 if break ;"))
-            {
-                tok2->str(";");
-                Token::eraseTokens(tok2, tok2->tokAt(3));
-                done = false;
-            }
-
-            // Delete if block: "alloc; if return use ;"
-            if (Token::Match(tok2, "alloc ; if return use ; !!else"))
-            {
-                Token::eraseTokens(tok2, tok2->tokAt(5));
-                done = false;
-            }
-
-            // Reduce "alloc|dealloc|use|callfunc ; exit ;" => "; exit ;"
-            if (Token::Match(tok2, "[;{}] alloc|dealloc|use|callfunc ; exit ;"))
-            {
-                tok2->deleteNext();
-                done = false;
-            }
-
-            // Reduce "alloc|dealloc|use ; if(var) exit ;"
-            if (Token::Match(tok2, "alloc|dealloc|use ; if(var) exit ;"))
-            {
-                tok2->deleteThis();
-                done = false;
-            }
-
-            // Remove "if exit ;"
-            if (Token::simpleMatch(tok2, "if exit ;"))
-            {
-                tok2->deleteThis();
-                tok2->deleteThis();
-                done = false;
-            }
-
-            // Remove the "if break|continue ;" that follows "dealloc ; alloc ;"
-            if (! _settings->inconclusive && Token::Match(tok2, "dealloc ; alloc ; if break|continue ;"))
-            {
-                tok2 = tok2->tokAt(3);
-                Token::eraseTokens(tok2, tok2->tokAt(3));
-                done = false;
-            }
-
-            // if break ; break ; => break ;
-            if (Token::Match(tok2->previous(), "[;{}] if break ; break ;"))
-            {
-                Token::eraseTokens(tok2, tok2->tokAt(4));
-                done = false;
-            }
-
-            // Reduce "do { dealloc ; alloc ; } while(var) ;" => ";"
-            if (Token::simpleMatch(tok2->next(), "do { dealloc ; alloc ; } while(var) ;"))
-            {
-                Token::eraseTokens(tok2, tok2->tokAt(9));
-                done = false;
-            }
-
-            // Reduce "do { alloc ; } " => "alloc ;"
-            /** @todo If the loop "do { alloc ; }" can be executed twice, reduce it to "loop alloc ;" */
-            if (Token::simpleMatch(tok2->next(), "do { alloc ; }"))
-            {
-                Token::eraseTokens(tok2, tok2->tokAt(3));
-                Token::eraseTokens(tok2->tokAt(2), tok2->tokAt(4));
-                done = false;
-            }
-
-            // Reduce "loop break ; => ";"
-            if (Token::Match(tok2->next(), "loop break|continue ;"))
-            {
-                Token::eraseTokens(tok2, tok2->tokAt(3));
-                done = false;
-            }
-
-            // Reduce "loop|do ;" => ";"
-            if (Token::Match(tok2, "loop|do ;"))
-            {
-                tok2->deleteThis();
-                done = false;
-            }
-
-            // Reduce "loop if break|continue ; !!else" => ";"
-            if (Token::Match(tok2->next(), "loop if break|continue ; !!else"))
-            {
-                Token::eraseTokens(tok2, tok2->tokAt(4));
-                done = false;
-            }
-
-            // Reduce "loop { if break|continue ; !!else" => "loop {"
-            if (Token::Match(tok2, "loop { if break|continue ; !!else"))
-            {
-                Token::eraseTokens(tok2->next(), tok2->tokAt(5));
-                done = false;
-            }
-
-            // Replace "do ; loop ;" with ";"
-            if (Token::simpleMatch(tok2, "; loop ;"))
-            {
-                Token::eraseTokens(tok2, tok2->tokAt(3));
-                done = false;
-            }
-
-            // Replace "loop loop .." with "loop .."
-            if (Token::simpleMatch(tok2, "loop loop"))
-            {
-                tok2->deleteThis();
-                done = false;
-            }
 
-            // Replace "loop if return ;" with "if return ;"
-            if (Token::simpleMatch(tok2->next(), "loop if return"))
-            {
-                Token::eraseTokens(tok2, tok2->tokAt(2));
-                done = false;
-            }
-
-            // Reduce "loop|while1 { dealloc ; alloc ; }"
-            if (Token::Match(tok2, "loop|while1 { dealloc ; alloc ; }"))
-            {
-                // delete "loop|while1"
-                tok2->deleteThis();
-                // delete "{"
-                tok2->deleteThis();
-
-                // delete "}"
-                Token::eraseTokens(tok2->tokAt(3), tok2->tokAt(5));
-
-                done = false;
-            }
-
-            // loop { use ; callfunc ; }  =>  use ;
-            // assume that the "callfunc" is not noreturn
-            if (Token::simpleMatch(tok2, "loop { use ; callfunc ; }"))
-            {
-                Token::eraseTokens(tok2, tok2->tokAt(7));
-                tok2->str("use");
-                tok2->insertToken(";");
-                done = false;
-            }
-
-            // Delete if block in "alloc ; if(!var) return ;"
-            if (Token::Match(tok2, "alloc ; if(!var) return ;"))
-            {
-                Token::eraseTokens(tok2, tok2->tokAt(4));
-                done = false;
-            }
-
-            // Reduce "[;{}] return use ; %var%" => "[;{}] return use ;"
-            if (Token::Match(tok2, "[;{}] return use ; %var%"))
-            {
-                Token::eraseTokens(tok2->tokAt(3), tok2->tokAt(5));
-                done = false;
-            }
-
-            // Reduce "if(var) return use ;" => "return use ;"
-            if (Token::Match(tok2->next(), "if(var) return use ; !!else"))
-            {
-                Token::eraseTokens(tok2, tok2->tokAt(2));
-                done = false;
-            }
-
-            // malloc - realloc => alloc ; dealloc ; alloc ;
-            // Reduce "[;{}] alloc ; dealloc ; alloc ;" => "[;{}] alloc ;"
-            if (Token::Match(tok2, "[;{}] alloc ; dealloc ; alloc ;"))
-            {
-                Token::eraseTokens(tok2->next(), tok2->tokAt(6));
-                done = false;
-            }
-
-            // use; dealloc; => dealloc;
-            if (Token::Match(tok2, "[;{}] use ; dealloc ;"))
-            {
-                Token::eraseTokens(tok2, tok2->tokAt(3));
-                done = false;
-            }
-
-            // use use => use
-            if (Token::simpleMatch(tok2, "use use"))
-            {
-                tok2->deleteThis();
-                done = false;
-            }
-
-            // use; if| use; => use;
-            while (Token::Match(tok2, "[;{}] use ; if| use ;"))
-            {
-                Token *t = tok2->tokAt(2);
-                t->deleteNext();
-                t->deleteNext();
-                if (t->strAt(1) == ";")
-                    t->deleteNext();
-                done = false;
+                if (!tok2)
+                    break;
+                rule = simplifyRuleIndex.match(tok2, rule + 1);
             }
 
-            // Delete first part in "use ; return use ;"
-            if (Token::Match(tok2, "[;{}] use ; return use ;"))
-            {
-                Token::eraseTokens(tok2, tok2->tokAt(3));
-                done = false;
-            }
+            if (!changed)
+                continue;
+            done = false;
 
-            // try/catch
-            if (Token::simpleMatch(tok2, "try ; catch exit ;"))
+            // Try the rules again at the tokens that can see the
+            // rewritten code.
+            if (scan || !tok2)
             {
-                Token::eraseTokens(tok2, tok2->tokAt(4));
-                tok2->deleteThis();
-                done = false;
+                nextFullPass = true;
+                continue;
             }
-
-            // Delete second case in "case ; case ;"
-            while (Token::simpleMatch(tok2, "case ; case ;"))
+            const Token *tok3 = tok2;
+            while (tok3 != start)
             {
-                Token::eraseTokens(tok2, tok2->tokAt(3));
-                done = false;
+                nextRevisit.insert(tok3);
+                tok3 = tok3->previous();
             }
-
-            // Replace switch with if (if not complicated)
-            if (Token::simpleMatch(tok2, "switch {"))
+            for (unsigned int i = 0; tok3 && i <= simplifyRuleIndex.window; ++i)
             {
-                // Right now, I just handle if there are a few case and perhaps a default.
-                bool valid = false;
-                bool incase = false;
-                for (const Token * _tok = tok2->tokAt(2); _tok; _tok = _tok->next())
-                {
-                    if (_tok->str() == "{")
-                        break;
-
-                    else if (_tok->str() == "}")
-                    {
-                        valid = true;
-                        break;
-                    }
-
-                    else if (_tok->str() == "switch")
-                        break;
-
-                    else if (_tok->str() == "loop")
-                        break;
-
-                    else if (incase && _tok->str() == "case")
-                        break;
-
-                    else if (Token::Match(_tok, "return !!;"))
-                        break;
-
-                    if (Token::Match(_tok, "if return|break use| ;"))
-                        _tok = _tok->tokAt(2);
-
-                    incase |= (_tok->str() == "case");
-                    incase &= (_tok->str() != "break" && _tok->str() != "return");
-                }
-
-                if (!incase && valid)
-                {
-                    done = false;
-                    tok2->str(";");
-                    Token::eraseTokens(tok2, tok2->tokAt(2));
-                    tok2 = tok2->next();
-                    bool first = true;
-                    while (Token::Match(tok2, "case|default"))
-                    {
-                        const bool def(tok2->str() == "default");
-                        tok2->str(first ? "if" : "}");
-                        if (first)
-                        {
-                            first = false;
-                            tok2->insertToken("{");
-                        }
-                        else
-                        {
-                            // Insert "else [if] {
-                            tok2->insertToken("{");
-                            if (! def)
-                                tok2->insertToken("if");
-                            tok2->insertToken("else");
-                            tok2 = tok2->next();
-                        }
-                        while (tok2)
-                        {
-                            if (tok2->str() == "}")
-                                break;
-                            if (Token::Match(tok2, "break|return ;"))
-                                break;
-                            if (Token::Match(tok2, "if return|break use| ;"))
-                                tok2 = tok2->tokAt(2);
-                            else
-                                tok2 = tok2->next();
-                        }
-                        if (Token::simpleMatch(tok2, "break ;"))
-                        {
-                            tok2->str(";");
-                            tok2 = tok2->tokAt(2);
-                        }
-                        else if (tok2 && tok2->str() == "return")
-                        {
-                            tok2 = tok2->tokAt(2);
-                        }
-                    }
-                }
+                nextRevisit.insert(tok3);
+                tok3 = tok3->previous();
             }
+            forceVisit = simplifyRuleIndex.window;
         }
 
+        revisit.swap(nextRevisit);
+        nextRevisit.clear();
+        fullPass = nextFullPass;
+
         // If "--all" is given, remove all "callfunc"..
         if (done && _settings->inconclusive)
         {
@@ -2177,6 +2484,7 @@ void CheckMemoryLeakInFunction::simplifycode(Token *tok)
                 {
                     tok2->deleteThis();
                     done = false;
+                    fullPass = true;
                 }
             }
         }
@@ -2438,11 +2746,34 @@ void CheckMemoryLeakInFunction::checkReallocUsage()
 // Checks for memory leaks inside function..
 //---------------------------------------------------------------------------
 
+/** Is the variable in the set of candidates? Variables without varid are always checked */
+static bool isCandidate(const std::set<unsigned int> &candidates, unsigned int varid)
+{
+    return varid == 0 || candidates.find(varid) != candidates.end();
+}
+
 void CheckMemoryLeakInFunction::parseFunctionScope(const Token *tok, const Token *tok1, const bool classmember)
 {
     // Check locking/unlocking of global resources..
     checkScope(tok->next(), "", 0, classmember, 1);
 
+    // Locate the variables that might be allocated or deallocated in the
+    // function. All variables are classified in one pass through the body
+    // so the getcode pass only needs to be made for these variables.
+    // A variable can only be allocated/deallocated if it is assigned a
+    // value that is not a single token, if it is a function parameter,
+    // if its address is taken or if it is deleted.
+    std::set<unsigned int> candidates;
+    for (const Token *tok2 = tok; tok2 && tok2 != tok->link(); tok2 = tok2->next())
+    {
+        if (tok2->varId() == 0)
+            continue;
+        if (Token::Match(tok2->previous(), "[(,&]") ||
+            Token::Match(tok2->previous(), "delete|]") ||
+            (tok2->strAt(1) == "=" && !Token::Match(tok2->tokAt(2), "%any% ;")))
+            candidates.insert(tok2->varId());
+    }
+
     // Locate parameters and check their usage..
     for (const Token *tok2 = tok1; tok2; tok2 = tok2->next())
     {
@@ -2455,7 +2786,8 @@ void CheckMemoryLeakInFunction::parseFunctionScope(const Token *tok, const Token
             const std::string varname(tok2->strAt(3));
             const unsigned int varid = tok2->tokAt(3)->varId();
             const unsigned int sz = _tokenizer->sizeOfType(tok2->next());
-            checkScope(tok->next(), varname, varid, classmember, sz);
+            if (isCandidate(candidates, varid))
+                checkScope(tok->next(), varname, varid, classmember, sz);
         }
     }
 
@@ -2499,19 +2831,22 @@ void CheckMemoryLeakInFunction::parseFunctionScope(const Token *tok, const Token
         if (Token::Match(tok, "[{};] %type% * const| %var% [;=]"))
         {
             const Token *vartok = tok->tokAt(tok->tokAt(3)->str() != "const" ? 3 : 4);
-            checkScope(tok->next(), vartok->str(), vartok->varId(), classmember, sz);
+            if (isCandidate(candidates, vartok->varId()))
+                checkScope(tok->next(), vartok->str(), vartok->varId(), classmember, sz);
         }
 
         else if (Token::Match(tok, "[{};] %type% %type% * const| %var% [;=]"))
         {
             const Token *vartok = tok->tokAt(tok->tokAt(4)->str() != "const" ? 4 : 5);
-            checkScope(tok->next(), vartok->str(), vartok->varId(), classmember, sz);
+            if (isCandidate(candidates, vartok->varId()))
+                checkScope(tok->next(), vartok->str(), vartok->varId(), classmember, sz);
         }
 
         else if (Token::Match(tok, "[{};] int %var% [;=]"))
         {
             const Token *vartok = tok->tokAt(2);
-            checkScope(tok->next(), vartok->str(), vartok->varId(), classmember, sz);
+            if (isCandidate(candidates, vartok->varId()))
+                checkScope(tok->next(), vartok->str(), vartok->varId(), classmember, sz);
         }
     }
     while (0 != (tok = tok->next()));
@@ -2522,6 +2857,9 @@ void CheckMemoryLeakInFunction::check()
     // fill the "noreturn"
     parse_noreturn();
 
+    // functions in other files (--test-2-pass)
+    parse_summaries();
+
     std::list<SymbolDatabase::SpaceInfo *>::const_iterator i;
 
     for (i = symbolDatabase->spaceInfoList.begin(); i != symbolDatabase->spaceInfoList.end(); ++i)
@@ -2538,6 +2876,17 @@ void CheckMemoryLeakInFunction::check()
 
         parseFunctionScope(tok, tok1, classmember);
     }
+
+    if (_settings->_showtime != SHOWTIME_NONE)
+    {
+        Timer::Count("CheckMemoryLeakInFunction::call_func: reused summaries", reusedSummaries, _settings->_showtime, _tokenizer->getTimerResults());
+        Timer::Count("CheckMemoryLeakInFunction::simplifycode: passes", simplifyPasses, _settings->_showtime, _tokenizer->getTimerResults());
+        for (unsigned int rule = 0; rule < simplifyRulesFired.size(); ++rule)
+        {
+            if (simplifyRulesFired[rule] > 0)
+                Timer::Count(std::string("CheckMemoryLeakInFunction::simplifycode: ") + simplifyRules[rule].pattern, simplifyRulesFired[rule], _settings->_showtime, _tokenizer->getTimerResults());
+        }
+    }
 }
 //---------------------------------------------------------------------------
 
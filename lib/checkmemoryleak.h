@@ -38,6 +38,7 @@
 #include "symboldatabase.h"
 
 #include <list>
+#include <map>
 #include <string>
 #include <vector>
 
@@ -56,6 +57,12 @@ private:
     /** ErrorLogger used to report errors */
     ErrorLogger * const errorLogger;
 
+    /** Number of reported errors */
+    mutable unsigned int reportedErrors;
+
+    /** Is there a user function with the given name? See getAllocationType */
+    mutable std::map<std::string, bool> userFunctions;
+
     /** Disable the default constructors */
     CheckMemoryLeak();
 
@@ -85,11 +92,17 @@ private:
 
 public:
     CheckMemoryLeak(const Tokenizer *t, ErrorLogger *e)
-        : tokenizer(t), errorLogger(e)
+        : tokenizer(t), errorLogger(e), reportedErrors(0)
     {
 
     }
 
+    /** @brief Number of errors that have been reported */
+    unsigned int errorCount() const
+    {
+        return reportedErrors;
+    }
+
     /** @brief What type of allocation are used.. the "Many" means that several types of allocation and deallocation are used */
     enum AllocType { No, Malloc, gMalloc, New, NewArray, File, Fd, Pipe, Dir, Many };
 
@@ -172,12 +185,12 @@ class CheckMemoryLeakInFunction : private Check, public CheckMemoryLeak
 {
 public:
     /** @brief This constructor is used when registering this class */
-    CheckMemoryLeakInFunction() : Check(), CheckMemoryLeak(0, 0), symbolDatabase(NULL)
+    CheckMemoryLeakInFunction() : Check(), CheckMemoryLeak(0, 0), symbolDatabase(NULL), simplifyPasses(0), reusedSummaries(0)
     { }
 
     /** @brief This constructor is used when running checks */
     CheckMemoryLeakInFunction(const Tokenizer *tokenizr, const Settings *settings, ErrorLogger *errLog)
-        : Check(tokenizr, settings, errLog), CheckMemoryLeak(tokenizr, errLog)
+        : Check(tokenizr, settings, errLog), CheckMemoryLeak(tokenizr, errLog), simplifyPasses(0), reusedSummaries(0)
     {
         // get the symbol database
         if (tokenizr)
@@ -204,6 +217,14 @@ public:
     /** @brief Unit testing : testing the white list */
     static bool test_white_list(const std::string &funcname);
 
+    /**
+     * @brief Analyse functions: what functions are "noreturn" and what
+     * functions return allocated memory
+     * @param tokens the token list
+     * @param result the function summaries are written here
+     */
+    void analyse(const Token *tokens, std::set<std::string> &result) const;
+
     /** @brief Perform checking */
     void check();
 
@@ -257,6 +278,20 @@ public:
      */
     const char * call_func(const Token *tok, std::list<const Token *> callstack, const unsigned int varid, AllocType &alloctype, AllocType &dealloctype, bool &allocpar, unsigned int sz);
 
+    /** @brief What a function call does, see call_func */
+    struct CallSummary
+    {
+        const char *ret;
+        AllocType alloctype;
+        AllocType dealloctype;
+    };
+
+    /** @brief Get saved call_func result. Returns true if it was found. */
+    bool findCallSummary(const std::map<std::string, CallSummary> &summaries, const std::string &key, AllocType &alloctype, AllocType &dealloctype);
+
+    /** @brief Save call_func result */
+    void addCallSummary(std::map<std::string, CallSummary> &summaries, const std::string &key, const char *ret, AllocType alloctype, AllocType dealloctype);
+
     /**
      * Extract a new tokens list that is easier to parse than the "_tokenizer->tokens()", the
      * extracted tokens list describes how the given variable is used.
@@ -346,10 +381,38 @@ public:
     /** parse tokens to see what functions are "noreturn" */
     void parse_noreturn();
 
+    /** fill "noreturn" and analysedAllocFunctions with the function summaries of other files (--test-2-pass) */
+    void parse_summaries();
+
     /** Function names for functions that are "noreturn" */
     std::set<std::string> noreturn;
 
     SymbolDatabase *symbolDatabase;
+
+    /** How many times each simplifycode rule has been applied (--showtime) */
+    std::vector<unsigned int> simplifyRulesFired;
+
+    /** Number of simplifycode passes (--showtime) */
+    unsigned int simplifyPasses;
+
+    /**
+     * @brief Summaries of called functions, so each function is only
+     * analysed once per token list. The key is the function name, the
+     * parameter and the allocation state at the call.
+     */
+    std::map<std::string, CallSummary> callSummaries;
+
+    /** @brief Pointer parameters that functions allocate, see functionArgAlloc */
+    std::map<std::string, CallSummary> argAllocSummaries;
+
+    /** @brief Allocation type that functions return, see functionReturnType */
+    std::map<std::string, AllocType> returnTypes;
+
+    /** @brief Allocation type that functions in other files return (--test-2-pass) */
+    std::map<std::string, AllocType> analysedAllocFunctions;
+
+    /** Number of call_func results that were taken from the summaries (--showtime) */
+    unsigned int reusedSummaries;
 };
 
 
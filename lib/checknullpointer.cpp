@@ -33,14 +33,30 @@ CheckNullPointer instance;
 
 
 
+/**
+ * Is there a function summary from the analysis of the files (--test-2-pass)?
+ * @param settings settings with the function summaries
+ * @param summary "1 f" => function f dereferences the first parameter, "2 f" => the second parameter
+ */
+static bool isAnalysedFunction(const Settings *settings, const std::string &summary)
+{
+    if (!settings)
+        return false;
+
+    // the key is the name of the check, see CheckNullPointer::name
+    const std::map<std::string, std::set<std::string> >::const_iterator it = settings->functionSummaries.find("Null pointer");
+    return bool(it != settings->functionSummaries.end() && it->second.find(summary) != it->second.end());
+}
+
 /**
  * @brief parse a function call and extract information about variable usage
  * @param tok first token
  * @param var variables that the function read / write.
  * @param value 0 => invalid with null pointers as parameter.
  *              1-.. => invalid with uninitialized data.
+ * @param settings settings with the function summaries of other files (--test-2-pass), 0 => not used
  */
-void CheckNullPointer::parseFunctionCall(const Token &tok, std::list<const Token *> &var, unsigned char value)
+void CheckNullPointer::parseFunctionCall(const Token &tok, std::list<const Token *> &var, unsigned char value, const Settings *settings)
 {
     // standard functions that dereference first parameter..
     // both uninitialized data and null pointers are invalid.
@@ -88,6 +104,8 @@ void CheckNullPointer::parseFunctionCall(const Token &tok, std::list<const Token
             var.push_back(tok.tokAt(2));
         else if (Token::simpleMatch(&tok, "fflush"))
             var.push_back(tok.tokAt(2));
+        else if (value == 0 && isAnalysedFunction(settings, "1 " + tok.str()))
+            var.push_back(tok.tokAt(2));
     }
 
     // 2nd parameter..
@@ -96,6 +114,8 @@ void CheckNullPointer::parseFunctionCall(const Token &tok, std::list<const Token
     {
         if (functionNames2.find(tok.str()) != functionNames2.end())
             var.push_back(tok.tokAt(4));
+        else if (value == 0 && isAnalysedFunction(settings, "2 " + tok.str()))
+            var.push_back(tok.tokAt(4));
     }
 }
 
@@ -145,10 +165,64 @@ bool CheckNullPointer::isPointerDeRef(const Token *tok, bool &unknown)
     return false;
 }
 
+void CheckNullPointer::analyse(const Token *tokens, std::set<std::string> &result) const
+{
+    for (const Token *tok = tokens; tok; tok = tok->next())
+    {
+        if (tok->str() == "{")
+        {
+            tok = tok->link();
+            continue;
+        }
+
+        // function implementation..
+        if (!Token::Match(tok, "%type% *| %var% ("))
+            continue;
+        const Token *ftok = tok->next()->str() == "*" ? tok->tokAt(2) : tok->next();
+        const Token *end = ftok->next()->link();
+        if (!Token::simpleMatch(end, ") {"))
+            continue;
+        const Token *body = end->next();
+
+        // Only the first two parameters are handled by parseFunctionCall
+        unsigned int par = 1;
+        for (const Token *partok = ftok->tokAt(2); partok && partok != end && par <= 2; partok = partok->next())
+        {
+            if (partok->str() == "(")
+                partok = partok->link();
+            else if (partok->str() == ",")
+                ++par;
+            else if (Token::Match(partok, "%type% * %var% [,)]") && partok->tokAt(2)->varId() > 0)
+            {
+                const unsigned int varid = partok->tokAt(2)->varId();
+
+                // Is the pointer dereferenced before there is any conditional code?
+                for (const Token *tok2 = body->next(); tok2 && tok2 != body->link(); tok2 = tok2->next())
+                {
+                    if (Token::Match(tok2, "{|}|?|if|while|for|do|switch|case|return|goto|break|continue|throw"))
+                        break;
+
+                    if (tok2->varId() == varid)
+                    {
+                        bool unknown = false;
+                        if (isPointerDeRef(tok2, unknown))
+                            result.insert(MathLib::toString<unsigned int>(par) + " " + ftok->str());
+                        break;
+                    }
+                }
+            }
+        }
+
+        tok = body->link();
+    }
+}
+
 bool CheckNullPointer::isPointer(const unsigned int varid)
 {
     // Check if given variable is a pointer
-    const Token *tok = Token::findmatch(_tokenizer->tokens(), "%varid%", varid);
+    const Token *tok = _tokenizer->findVarMatch("%varid%", varid);
+    if (!tok)
+        return false;
     tok = tok->tokAt(-2);
 
     // maybe not a pointer
@@ -444,7 +518,7 @@ void CheckNullPointer::nullPointerByDeRefAndChec()
             if (!isPointer(varid))
                 continue;
 
-            const Token * const decltok = Token::findmatch(_tokenizer->tokens(), "%varid%", varid);
+            const Token * const decltok = _tokenizer->findVarMatch("%varid%", varid);
 
             for (const Token *tok1 = tok->previous(); tok1 && tok1 != decltok; tok1 = tok1->previous())
             {
@@ -639,7 +713,7 @@ void CheckNullPointer::nullConstantDereference()
             else if (indentlevel > 0 && Token::Match(tok, "%var% ("))
             {
                 std::list<const Token *> var;
-                parseFunctionCall(*tok, var, 0);
+                parseFunctionCall(*tok, var, 0, _settings);
 
                 // is one of the var items a NULL pointer?
                 for (std::list<const Token *>::const_iterator it = var.begin(); it != var.end(); ++it)
@@ -696,6 +770,12 @@ private:
         return (varname == c->varname && null == c->null);
     }
 
+    /** hash value for the state */
+    unsigned int hash_value() const
+    {
+        return null ? 1U : 0U;
+    }
+
     /** variable name for this check (empty => dummy check) */
     const std::string varname;
 
@@ -806,7 +886,7 @@ private:
 
             // parse usage..
             std::list<const Token *> var;
-            CheckNullPointer::parseFunctionCall(tok, var, 0);
+            CheckNullPointer::parseFunctionCall(tok, var, 0, owner->getSettings());
             for (std::list<const Token *>::const_iterator it = var.begin(); it != var.end(); ++it)
                 dereference(checks, *it);
         }
@@ -853,7 +933,7 @@ private:
         if (Token::Match(&tok, "!| %var% ("))
         {
             std::list<const Token *> var;
-            CheckNullPointer::parseFunctionCall(tok.str() == "!" ? *tok.next() : tok, var, 0);
+            CheckNullPointer::parseFunctionCall(tok.str() == "!" ? *tok.next() : tok, var, 0, owner->getSettings());
             for (std::list<const Token *>::const_iterator it = var.begin(); it != var.end(); ++it)
                 dereference(checks, *it);
         }
@@ -882,7 +962,7 @@ void CheckNullPointer::executionPaths()
 {
     // Check for null pointer errors..
     Nullpointer c(this);
-    checkExecutionPaths(_tokenizer->tokens(), &c);
+    checkExecutionPaths(_tokenizer, _settings, &c);
 }
 
 void CheckNullPointer::nullPointerError(const Token *tok)
@@ -66,10 +66,12 @@ public:
      * @param var variables that the function read / write.
      * @param value 0 => invalid with null pointers as parameter.
      *              non-zero => invalid with uninitialized data.
+     * @param settings settings with the function summaries of other files (--test-2-pass), 0 => not used
      */
     static void parseFunctionCall(const Token &tok,
                                   std::list<const Token *> &var,
-                                  unsigned char value);
+                                  unsigned char value,
+                                  const Settings *settings = 0);
 
     /**
      * Is there a pointer dereference? Everything that should result in
@@ -82,6 +84,13 @@ public:
      */
     static bool isPointerDeRef(const Token *tok, bool &unknown);
 
+    /**
+     * @brief Analyse functions: what pointer parameters are always dereferenced
+     * @param tokens the token list
+     * @param result the function summaries are written here
+     */
+    void analyse(const Token *tokens, std::set<std::string> &result) const;
+
     /** @brief possible null pointer dereference */
     void nullPointer();
 
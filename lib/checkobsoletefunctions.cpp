@@ -21,6 +21,7 @@
 //---------------------------------------------------------------------------
 
 #include "checkobsoletefunctions.h"
+#include "symboldatabase.h"
 
 //---------------------------------------------------------------------------
 
@@ -40,17 +41,26 @@ void CheckObsoleteFunctions::obsoleteFunctions()
     if (_tokenizer->isJavaOrCSharp())
         return;
 
-    for (const Token *tok = _tokenizer->tokens(); tok; tok = tok->next())
+    std::string funcnames;
+    std::list< std::pair<const std::string, const std::string> >::const_iterator it(_obsoleteFunctions.begin()), itend(_obsoleteFunctions.end());
+    for (; it!=itend; ++it)
+        funcnames += (funcnames.empty() ? "" : "|") + it->first;
+
+    const std::vector<SymbolDatabase::CallSite> calls(_tokenizer->getSymbolDatabase()->findCallSites(funcnames));
+    for (std::vector<SymbolDatabase::CallSite>::const_iterator call = calls.begin(); call != calls.end(); ++call)
     {
-        std::list< std::pair<const std::string, const std::string> >::const_iterator it(_obsoleteFunctions.begin()), itend(_obsoleteFunctions.end());
-        for (; it!=itend; ++it)
+        const Token *tok = call->tok->previous();
+        if (tok && tok->tokAt(1)->varId() == 0 && !tok->tokAt(0)->isName() && !Token::Match(tok, ".|::|:|,"))
         {
-            if (tok->strAt(1) == it->first && tok->strAt(2) == "(" && tok->tokAt(1)->varId() == 0 && !tok->tokAt(0)->isName() && !Token::Match(tok, ".|::|:|,"))
+            for (it = _obsoleteFunctions.begin(); it!=itend; ++it)
             {
-                // If checking an old code base it might be uninteresting to update obsolete functions.
-                // Therefore this is "style"
-                reportError(tok->tokAt(1), Severity::style, "obsoleteFunctions"+it->first, it->second);
-                break;
+                if (tok->strAt(1) == it->first)
+                {
+                    // If checking an old code base it might be uninteresting to update obsolete functions.
+                    // Therefore this is "style"
+                    reportError(tok->tokAt(1), Severity::style, "obsoleteFunctions"+it->first, it->second);
+                    break;
+                }
             }
         }
     }
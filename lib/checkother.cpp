@@ -335,11 +335,13 @@ void CheckOther::checkCatchExceptionByValue()
 
 void CheckOther::invalidFunctionUsage()
 {
+    const SymbolDatabase *symbolDatabase = _tokenizer->getSymbolDatabase();
+
     // strtol and strtoul..
-    for (const Token *tok = _tokenizer->tokens(); tok; tok = tok->next())
+    const std::vector<SymbolDatabase::CallSite> strtolCalls(symbolDatabase->findCallSites("strtol|strtoul"));
+    for (std::vector<SymbolDatabase::CallSite>::const_iterator call = strtolCalls.begin(); call != strtolCalls.end(); ++call)
     {
-        if ((tok->str() != "strtol") && (tok->str() != "strtoul"))
-            continue;
+        const Token *tok = call->tok;
 
         // Locate the third parameter of the function call..
         int parlevel = 0;
@@ -370,8 +372,11 @@ void CheckOther::invalidFunctionUsage()
     }
 
     // sprintf|snprintf overlapping data
-    for (const Token *tok = _tokenizer->tokens(); tok; tok = tok->next())
+    const std::vector<SymbolDatabase::CallSite> sprintfCalls(symbolDatabase->findCallSites("sprintf|snprintf"));
+    for (std::vector<SymbolDatabase::CallSite>::const_iterator call = sprintfCalls.begin(); call != sprintfCalls.end(); ++call)
     {
+        const Token *tok = call->tok;
+
         // Get variable id of target buffer..
         unsigned int varid = 0;
 
@@ -415,8 +420,10 @@ void CheckOther::invalidScanf()
 {
     if (!_settings->_checkCodingStyle)
         return;
-    for (const Token *tok = _tokenizer->tokens(); tok; tok = tok->next())
+    const std::vector<SymbolDatabase::CallSite> calls(_tokenizer->getSymbolDatabase()->findCallSites("scanf|vscanf|fscanf|vfscanf"));
+    for (std::vector<SymbolDatabase::CallSite>::const_iterator call = calls.begin(); call != calls.end(); ++call)
     {
+        const Token *tok = call->tok;
         const Token *formatToken = 0;
         if (Token::Match(tok, "scanf|vscanf ( %str% ,"))
             formatToken = tok->tokAt(2);
@@ -2303,7 +2310,7 @@ void CheckOther::checkCharVariable()
                     }
 
                     // is the result stored in a short|int|long?
-                    if (!Token::findmatch(_tokenizer->tokens(), "short|int|long %varid%", tok2->next()->varId()))
+                    if (!_tokenizer->findVarMatch("short|int|long %varid%", tok2->next()->varId(), 1))
                         continue;
 
                     // This is an error..
@@ -2449,8 +2456,11 @@ void CheckOther::checkZeroDivision()
 
 void CheckOther::checkMathFunctions()
 {
-    for (const Token *tok = _tokenizer->tokens(); tok; tok = tok->next())
+    const std::vector<SymbolDatabase::CallSite> calls(_tokenizer->getSymbolDatabase()->findCallSites("log|log10|acos|asin|sqrt|atan2|fmod|pow"));
+    for (std::vector<SymbolDatabase::CallSite>::const_iterator call = calls.begin(); call != calls.end(); ++call)
     {
+        const Token *tok = call->tok;
+
         // case log(-2)
         if (tok->varId() == 0 &&
             Token::Match(tok, "log|log10 ( %num% )") &&
@@ -73,7 +73,7 @@ void CheckPostfixOperator::postfixOperator()
 
         if (result && tok->previous()->varId())
         {
-            const Token *decltok = Token::findmatch(_tokenizer->tokens(), "%varid%", tok->previous()->varId());
+            const Token *decltok = _tokenizer->findVarMatch("%varid%", tok->previous()->varId());
             if (!Token::Match(decltok->tokAt(-1), "%type%"))
                 continue;
 
@@ -100,7 +100,7 @@ void CheckStl::iterators()
                     // skip error message if container is a set..
                     if (tok2->varId() > 0)
                     {
-                        const Token *decltok = Token::findmatch(_tokenizer->tokens(), "%varid%", tok2->varId());
+                        const Token *decltok = _tokenizer->findVarMatch("%varid%", tok2->varId());
                         while (decltok && !Token::Match(decltok, "[;{},(]"))
                             decltok = decltok->previous();
                         if (Token::Match(decltok, "%any% const| std :: set"))
@@ -289,7 +289,8 @@ public:
         EraseCheckLoop c(checkStl, it->varId());
         std::list<ExecutionPath *> checks;
         checks.push_back(c.copy());
-        ExecutionPath::checkScope(tok->tokAt(2), checks);
+        ExecutionPathBudget budget;
+        ExecutionPath::checkScope(tok->tokAt(2), checks, budget);
 
         c.end(checks, tok->link());
 
@@ -323,6 +324,12 @@ private:
         return (eraseToken == c->eraseToken);
     }
 
+    /** @brief hash value for the state */
+    unsigned int hash_value() const
+    {
+        return eraseToken ? eraseToken->linenr() : 0U;
+    }
+
     /** @brief no implementation => compiler error if used by accident */
     void operator=(const EraseCheckLoop &);
 
@@ -429,7 +436,7 @@ void CheckStl::erase()
                     if (Token::Match(tok2, "; %var% !="))
                     {
                         const unsigned int varid = tok2->next()->varId();
-                        if (varid > 0 && Token::findmatch(_tokenizer->tokens(), "> :: iterator %varid%", varid))
+                        if (varid > 0 && _tokenizer->findVarMatch("> :: iterator %varid%", varid, 3))
                             EraseCheckLoop::checkScope(this, tok2->next());
                     }
                     break;
@@ -448,7 +455,7 @@ void CheckStl::erase()
         if (Token::Match(tok, "while ( %var% !="))
         {
             const unsigned int varid = tok->tokAt(2)->varId();
-            if (varid > 0 && Token::findmatch(_tokenizer->tokens(), "> :: iterator %varid%", varid))
+            if (varid > 0 && _tokenizer->findVarMatch("> :: iterator %varid%", varid, 3))
                 EraseCheckLoop::checkScope(this, tok->tokAt(2));
         }
     }
@@ -730,7 +737,7 @@ void CheckStl::if_find()
             if (varid > 0)
             {
                 // Is the variable a std::string or STL container?
-                const Token * decl = Token::findmatch(_tokenizer->tokens(), "%varid%", varid);
+                const Token * decl = _tokenizer->findVarMatch("%varid%", varid);
                 while (decl && !Token::Match(decl, "[;{}(,]"))
                     decl = decl->previous();
 
@@ -777,7 +784,7 @@ bool CheckStl::isStlContainer(const Token *tok)
     if (tok->varId())
     {
         // find where this token is defined
-        const Token *type = Token::findmatch(_tokenizer->tokens(), "%varid%", tok->varId());
+        const Token *type = _tokenizer->findVarMatch("%varid%", tok->varId());
 
         // find where this tokens type starts
         while (type->previous() && !Token::Match(type->previous(), "[;{,(]"))
@@ -83,6 +83,12 @@ private:
         return (varname == c->varname && pointer == c->pointer && array == c->array && alloc == c->alloc && strncpy_ == c->strncpy_);
     }
 
+    /** hash value for the state */
+    unsigned int hash_value() const
+    {
+        return (pointer ? 1U : 0U) | (array ? 2U : 0U) | (alloc ? 4U : 0U) | (strncpy_ ? 8U : 0U);
+    }
+
     /** variable name for this check */
     const std::string varname;
 
@@ -619,7 +625,7 @@ private:
 
                 // Using uninitialized pointer is bad if using null pointer is bad
                 std::list<const Token *> var2;
-                CheckNullPointer::parseFunctionCall(tok, var2, 0);
+                CheckNullPointer::parseFunctionCall(tok, var2, 0, owner->getSettings());
                 for (std::list<const Token *>::const_iterator it = var2.begin(); it != var2.end(); ++it)
                 {
                     if (std::find(var.begin(), var.end(), *it) == var.end())
@@ -1073,7 +1079,7 @@ void CheckUninitVar::executionPaths()
             UninitVar::analyseFunctions(_tokenizer->tokens(), UninitVar::uvarFunctions);
 
         UninitVar c(this);
-        checkExecutionPaths(_tokenizer->tokens(), &c);
+        checkExecutionPaths(_tokenizer, _settings, &c);
     }
 }
 
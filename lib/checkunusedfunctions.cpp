@@ -21,6 +21,7 @@
 #include "checkunusedfunctions.h"
 #include "tokenize.h"
 #include "token.h"
+#include "symboldatabase.h"
 //---------------------------------------------------------------------------
 
 
@@ -96,56 +97,35 @@ void CheckUnusedFunctions::parseTokens(const Tokenizer &tokenizer)
         }
     }
 
-    // Function usage..
+    // Function calls..
+    const std::map<std::string, std::vector<SymbolDatabase::CallSite> > &calls = tokenizer.getSymbolDatabase()->getAllCallSites();
+    for (std::map<std::string, std::vector<SymbolDatabase::CallSite> >::const_iterator it = calls.begin(); it != calls.end(); ++it)
+        functionUsed(it->first);
+
+    // Other function usage..
     for (const Token *tok = tokenizer.tokens(); tok; tok = tok->next())
     {
-        const Token *funcname = 0;
-
+        // the function calls are handled above
         if (Token::Match(tok->next(), "%var% ("))
-        {
-            funcname = tok->next();
-        }
+            continue;
 
-        else if (Token::Match(tok, "[;{}.,()[=+-/&|!?:] %var% [(),;:}]"))
-            funcname = tok->next();
+        if (Token::Match(tok, "[;{}.,()[=+-/&|!?:] %var% [),;:}]"))
+            functionUsed(tok->next()->str());
 
         else if (Token::Match(tok, "[=(,] & %var% :: %var% [,);]"))
-            funcname = tok->tokAt(4);
-
-        else
-            continue;
-
-        // funcname ( => Assert that the end parenthesis isn't followed by {
-        if (Token::Match(funcname, "%var% ("))
-        {
-            int parlevel = 0;
-            for (const Token *tok2 = funcname; tok2; tok2 = tok2->next())
-            {
-                if (tok2->str() == "(")
-                    ++parlevel;
-
-                else if (tok2->str() == ")")
-                {
-                    --parlevel;
-                    if (parlevel == 0 && (Token::Match(tok2, ") const|{")))
-                        funcname = NULL;
-                    if (parlevel <= 0)
-                        break;
-                }
-            }
-        }
+            functionUsed(tok->strAt(4));
+    }
+}
 
-        if (funcname)
-        {
-            FunctionUsage &func = _functions[ funcname->str()];
+void CheckUnusedFunctions::functionUsed(const std::string &funcname)
+{
+    FunctionUsage &func = _functions[funcname];
 
-            if (func.filename.empty() || func.filename == "+")
-                func.usedOtherFile = true;
+    if (func.filename.empty() || func.filename == "+")
+        func.usedOtherFile = true;
 
-            else
-                func.usedSameFile = true;
-        }
-    }
+    else
+        func.usedSameFile = true;
 }
 
 
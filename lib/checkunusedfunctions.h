@@ -50,6 +50,9 @@ public:
 
 private:
 
+    /** @brief Function is used. Record if it's used in the file it's declared in. */
+    void functionUsed(const std::string &funcname);
+
     void getErrorMessages(ErrorLogger *errorLogger, const Settings *settings)
     {
         CheckUnusedFunctions c(0, settings, errorLogger);
@@ -30,6 +30,9 @@
 #include <fstream>
 #include <stdexcept>
 #include <ctime>
+#include <map>
+#include <set>
+#include <queue>
 #include "timer.h"
 
 #ifndef __BORLANDC__
@@ -39,8 +42,147 @@
 
 static TimerResults S_timerResults;
 
+/** Line numbers of the code lines in preprocessed code */
+static std::vector<unsigned int> getCodeLines(const std::string &code)
+{
+    std::vector<unsigned int> lines;
+    unsigned int linenr = 1;
+    std::string::size_type pos = 0;
+    while (pos < code.size())
+    {
+        std::string::size_type end = code.find('\n', pos);
+        if (end == std::string::npos)
+            end = code.size();
+        if (end > pos && code[pos] != '#' && code.find_first_not_of(" \t", pos) < end)
+            lines.push_back(linenr);
+        ++linenr;
+        pos = end + 1;
+    }
+    return lines;
+}
+
+/**
+ * Order configurations so that each configuration covers as many lines
+ * as possible that the configurations before it don't cover. Only the
+ * configurations that are checked are ranked. The number of uncovered
+ * lines of a configuration can only decrease, so a count from an earlier
+ * step is an upper bound and only the configuration with the highest
+ * bound needs to be counted again.
+ */
+class ConfigurationRanking
+{
+public:
+    /** @param lines the code lines of each configuration */
+    explicit ConfigurationRanking(const std::vector<std::vector<unsigned int> > &lines)
+        : _lines(lines), _coverable(0), _covered(0)
+    {
+        std::vector<bool> coverable;
+        for (unsigned int i = 0; i < _lines.size(); ++i)
+        {
+            for (std::vector<unsigned int>::const_iterator it = _lines[i].begin(); it != _lines[i].end(); ++it)
+            {
+                if (*it >= coverable.size())
+                    coverable.resize(*it + 1, false);
+                if (!coverable[*it])
+                {
+                    coverable[*it] = true;
+                    ++_coverable;
+                }
+            }
+
+            // The lowest index is taken first when the counts are equal
+            _queue.push(std::make_pair((unsigned int)_lines[i].size(), -(int)i));
+        }
+        _isCovered.resize(coverable.size(), false);
+    }
+
+    /** @brief Are all configurations ranked? */
+    bool empty() const
+    {
+        return _queue.empty();
+    }
+
+    /** @brief Rank the next configuration and mark its lines covered */
+    unsigned int next()
+    {
+        for (;;)
+        {
+            const unsigned int index = (unsigned int)(-_queue.top().second);
+            const unsigned int bound = _queue.top().first;
+            _queue.pop();
+
+            // The count is not less than the bounds of the other configurations
+            const unsigned int count = uncovered(index);
+            if (count == bound)
+            {
+                for (std::vector<unsigned int>::const_iterator it = _lines[index].begin(); it != _lines[index].end(); ++it)
+                    _isCovered[*it] = true;
+                _covered += count;
+                return index;
+            }
+            _queue.push(std::make_pair(count, -(int)index));
+        }
+    }
+
+    /** @brief Number of lines that any configuration covers */
+    unsigned int coverable() const
+    {
+        return _coverable;
+    }
+
+    /** @brief Number of lines that the ranked configurations cover */
+    unsigned int covered() const
+    {
+        return _covered;
+    }
+
+private:
+    /** no implementation */
+    void operator=(const ConfigurationRanking &);
+
+    /** Number of lines of a configuration that are not covered yet */
+    unsigned int uncovered(unsigned int index) const
+    {
+        unsigned int count = 0;
+        for (std::vector<unsigned int>::const_iterator it = _lines[index].begin(); it != _lines[index].end(); ++it)
+        {
+            if (!_isCovered[*it])
+                ++count;
+        }
+        return count;
+    }
+
+    const std::vector<std::vector<unsigned int> > &_lines;
+
+    /** Upper bounds of the number of uncovered lines of the configurations that are not ranked */
+    std::priority_queue<std::pair<unsigned int, int> > _queue;
+
+    /** Is the line covered by the ranked configurations? Indexed by line number */
+    std::vector<bool> _isCovered;
+
+    unsigned int _coverable;
+    unsigned int _covered;
+};
+
+/** Message for bailing out from a file that has too many configurations */
+static std::string tooManyConfigurations(const std::string &filename)
+{
+    return "Bailing out from checking " + Path::toNativeSeparators(filename) +
+           ": Too many configurations. Recheck this file with --force if you want to check them all.";
+}
+
+/** Message about configurations that were not checked because their code was checked already */
+static std::string skippedConfigurations(const std::string &filename, unsigned int count)
+{
+    std::ostringstream ostr;
+    ostr << "Skipped " << count << " configuration" << (count > 1 ? "s" : "")
+         << " of " << Path::toNativeSeparators(filename) << " with the same code as a checked configuration";
+    return ostr.str();
+}
+
 CppCheck::CppCheck(ErrorLogger &errorLogger)
-    : _errorLogger(errorLogger)
+    : _errorLogger(errorLogger), _skippedConfigurations(0), _tooManyConfigurations(false),
+      _configDeadline(0), _configBudgetSpent(false)
 {
     exitcode = 0;
 }
@@ -88,6 +230,16 @@ unsigned int CppCheck::check()
     // analysed before any files are checked?
     if (_settings.test_2_pass && _settings._jobs == 1)
     {
+        _settings.functionSummaries.clear();
+
+        // Load the function summaries from the previous run
+        if (!_settings.summaryFile.empty())
+        {
+            std::ifstream fin(_settings.summaryFile.c_str());
+            if (fin.is_open() && !_summaries.load(fin))
+                reportOut("Ignoring invalid summary file " + Path::toNativeSeparators(_settings.summaryFile));
+        }
+
         for (unsigned int c = 0; c < _filenames.size(); c++)
         {
             const std::string fname = _filenames[c];
@@ -100,99 +252,77 @@ unsigned int CppCheck::check()
             std::ifstream f(fname.c_str());
             analyseFile(f, fname);
         }
+
+        if (!_settings.summaryFile.empty() && _summaries.changed())
+        {
+            std::ofstream fout(_settings.summaryFile.c_str());
+            _summaries.save(fout);
+        }
     }
 
+    unsigned int result = 0;
     for (unsigned int c = 0; c < _filenames.size(); c++)
     {
-        _errout.str("");
         const std::string fname = _filenames[c];
 
         if (_settings.terminated())
             break;
 
-        if (_settings._errorsOnly == false)
-        {
-            std::string fixedpath(fname);
-            fixedpath = Path::simplifyPath(fixedpath.c_str());
-            fixedpath = Path::toNativeSeparators(fixedpath);
-            _errorLogger.reportOut(std::string("Checking ") + fixedpath + std::string("..."));
-        }
+        const std::list<Configuration> configurations(getConfigurations(fname));
 
-        try
+        if (_settings._configBudget > 0 && configurations.size() > 1)
         {
-            Preprocessor preprocessor(&_settings, this);
-            std::list<std::string> configurations;
-            std::string filedata = "";
-
-            if (_fileContents.size() > 0 && _fileContents.find(_filenames[c]) != _fileContents.end())
-            {
-                // File content was given as a string
-                std::istringstream iss(_fileContents[ _filenames[c] ]);
-                preprocessor.preprocess(iss, filedata, configurations, fname, _settings._includePaths);
-            }
-            else
-            {
-                // Only file name was given, read the content from file
-                std::ifstream fin(fname.c_str());
-                Timer t("Preprocessor::preprocess", _settings._showtime, &S_timerResults);
-                preprocessor.preprocess(fin, filedata, configurations, fname, _settings._includePaths);
-            }
-
-            _settings.ifcfg = bool(configurations.size() > 1);
-
-            if (!_settings.userDefines.empty())
+            // Check the configurations that cover most lines first until the time budget is spent
+            std::vector<const Configuration *> cfgs;
+            std::vector<std::vector<unsigned int> > configurationLines;
+            for (std::list<Configuration>::const_iterator it = configurations.begin(); it != configurations.end(); ++it)
             {
-                configurations.clear();
-                configurations.push_back(_settings.userDefines);
+                cfgs.push_back(&*it);
+                configurationLines.push_back(getCodeLines(it->code));
             }
 
-            int checkCount = 0;
-            for (std::list<std::string>::const_iterator it = configurations.begin(); it != configurations.end(); ++it)
+            ConfigurationRanking ranking(configurationLines);
+            unsigned int checkCount = 0;
+            while (!ranking.empty())
             {
-                // Check only 12 first configurations, after that bail out, unless --force
-                // was used.
-                if (!_settings._force && checkCount > 11)
+                if (checkCount > 0 && std::clock() > _configDeadline)
                 {
-                    if (_settings._errorsOnly == false)
-                    {
-                        const std::string fixedpath = Path::toNativeSeparators(fname);
-                        _errorLogger.reportOut(std::string("Bailing out from checking ") + fixedpath +
-                                               ": Too many configurations. Recheck this file with --force if you want to check them all.");
-                    }
-
+                    _configBudgetSpent = true;
                     break;
                 }
 
-                cfg = *it;
-                Timer t("Preprocessor::getcode", _settings._showtime, &S_timerResults);
-                const std::string codeWithoutCfg = Preprocessor::getcode(filedata, *it, fname, &_settings, &_errorLogger);
-                t.Stop();
-
-                // If only errors are printed, print filename after the check
-                if (_settings._errorsOnly == false && it != configurations.begin())
-                {
-                    std::string fixedpath = Path::simplifyPath(fname.c_str());
-                    fixedpath = Path::toNativeSeparators(fixedpath);
-                    _errorLogger.reportOut(std::string("Checking ") + fixedpath + ": " + cfg + std::string("..."));
-                }
+                checkConfiguration(fname, *cfgs[ranking.next()]);
+                ++checkCount;
+            }
 
-                std::string appendCode = _settings.append();
-                if (!appendCode.empty())
-                    Preprocessor::preprocessWhitespaces(appendCode);
+            reportSkippedConfigurations(fname);
 
-                checkFile(codeWithoutCfg + appendCode, _filenames[c].c_str());
-                ++checkCount;
+            if (_settings._errorsOnly == false)
+            {
+                std::ostringstream ostr;
+                ostr << "Line coverage of " << Path::toNativeSeparators(fname) << ": "
+                     << ranking.covered() << " of " << ranking.coverable() << " lines";
+                if (ranking.coverable() > 0)
+                    ostr << " (" << (100 * ranking.covered() / ranking.coverable()) << "%)";
+                ostr << " in " << checkCount << " of " << configurations.size() << " configurations";
+                _errorLogger.reportOut(ostr.str());
             }
         }
-        catch (std::runtime_error &e)
+        else
         {
-            // Exception was thrown when checking this file..
-            const std::string fixedpath = Path::toNativeSeparators(fname);
-            _errorLogger.reportOut("Bailing out from checking " + fixedpath + ": " + e.what());
+            for (std::list<Configuration>::const_iterator it = configurations.begin(); it != configurations.end(); ++it)
+                checkConfiguration(fname, *it);
+
+            reportSkippedConfigurations(fname);
         }
 
+        // getConfigurations() resets the exitcode for each file
+        if (exitcode)
+            result = 1;
+
         _errorLogger.reportStatus(c + 1, (unsigned int)_filenames.size());
     }
+    exitcode = result;
 
     // This generates false positives - especially for libraries
     const bool verbose_orig = _settings._verbose;
@@ -211,6 +341,164 @@ unsigned int CppCheck::check()
     return exitcode;
 }
 
+std::list<Preprocessor::Configuration> CppCheck::preprocessFile(const std::string &filename, std::string &filedata)
+{
+    Preprocessor preprocessor(&_settings, this);
+    std::list<Preprocessor::Configuration> configurations;
+
+    if (_fileContents.size() > 0 && _fileContents.find(filename) != _fileContents.end())
+    {
+        // File content was given as a string
+        std::istringstream iss(_fileContents[ filename ]);
+        preprocessor.preprocess(iss, filedata, configurations, filename, _settings._includePaths);
+    }
+    else
+    {
+        // Only file name was given, read the content from file
+        std::ifstream fin(filename.c_str());
+        Timer t("Preprocessor::preprocess", _settings._showtime, &S_timerResults);
+        preprocessor.preprocess(fin, filedata, configurations, filename, _settings._includePaths);
+    }
+
+    _settings.ifcfg = bool(configurations.size() > 1);
+    _locations = preprocessor.getSourceLocations();
+
+    if (!_settings.userDefines.empty())
+    {
+        configurations.clear();
+        configurations.push_back(Preprocessor::Configuration(_settings.userDefines));
+    }
+
+    return configurations;
+}
+
+std::list<CppCheck::Configuration> CppCheck::getConfigurations(const std::string &filename)
+{
+    exitcode = 0;
+    _errout.str("");
+    _skippedConfigurations = 0;
+    _tooManyConfigurations = false;
+    _configBudgetSpent = false;
+
+    // The time budget includes the preprocessing
+    _configDeadline = std::clock() + (std::clock_t)((double)_settings._configBudget * CLOCKS_PER_SEC);
+
+    if (_settings._errorsOnly == false)
+    {
+        std::string fixedpath = Path::simplifyPath(filename.c_str());
+        fixedpath = Path::toNativeSeparators(fixedpath);
+        _errorLogger.reportOut(std::string("Checking ") + fixedpath + std::string("..."));
+    }
+
+    std::list<Configuration> selected;
+    try
+    {
+        std::string filedata;
+        const std::list<Preprocessor::Configuration> configurations(preprocessFile(filename, filedata));
+
+        // Parse the directives once and get the code for each configuration
+        const DirectiveTree directives(filedata, &_settings, _locations);
+
+        // Hashes of the code of the selected configurations. Configurations that
+        // give the same code as a selected configuration are not checked.
+        std::multimap<std::string, const std::string *> selectedCode;
+        for (std::list<Preprocessor::Configuration>::const_iterator it = configurations.begin(); it != configurations.end(); ++it)
+        {
+            // Check only 12 first configurations, after that bail out, unless --force
+            // was used. With a time budget the configurations are ranked instead and
+            // no more configurations are preprocessed when the time budget is spent.
+            if (!_settings._force && _settings._configBudget == 0 && selected.size() > 11)
+            {
+                _tooManyConfigurations = true;
+                break;
+            }
+            if (_settings._configBudget > 0 && !selected.empty() && std::clock() > _configDeadline)
+            {
+                _configBudgetSpent = true;
+                break;
+            }
+
+            cfg = it->name;
+            Timer t("Preprocessor::getcode", _settings._showtime, &S_timerResults);
+            const std::string code = Preprocessor::getcode(directives, *it, filename, &_settings, &_errorLogger);
+            t.Stop();
+
+            // The code is compared only when the hashes are equal
+            const std::string hash(SummaryDatabase::hash(code));
+            bool same = false;
+            typedef std::multimap<std::string, const std::string *>::const_iterator CodeIterator;
+            const std::pair<CodeIterator, CodeIterator> range(selectedCode.equal_range(hash));
+            for (CodeIterator code2 = range.first; code2 != range.second && !same; ++code2)
+                same = (*code2->second == code);
+
+            if (same)
+            {
+                ++_skippedConfigurations;
+                continue;
+            }
+
+            selected.push_back(Configuration(it->name, code));
+            selectedCode.insert(std::make_pair(hash, &selected.back().code));
+        }
+    }
+    catch (std::runtime_error &e)
+    {
+        const std::string fixedpath = Path::toNativeSeparators(filename);
+        _errorLogger.reportOut("Bailing out from checking " + fixedpath + ": " + e.what());
+        selected.clear();
+        _skippedConfigurations = 0;
+        _tooManyConfigurations = false;
+        _configBudgetSpent = false;
+    }
+
+    return selected;
+}
+
+unsigned int CppCheck::checkConfiguration(const std::string &filename, const Configuration &configuration)
+{
+    try
+    {
+        cfg = configuration.name;
+
+        // If only errors are printed, print filename after the check
+        if (_settings._errorsOnly == false && !cfg.empty() && _settings.userDefines.empty())
+        {
+            std::string fixedpath = Path::simplifyPath(filename.c_str());
+            fixedpath = Path::toNativeSeparators(fixedpath);
+            _errorLogger.reportOut(std::string("Checking ") + fixedpath + ": " + cfg + std::string("..."));
+        }
+
+        std::string appendCode = _settings.append();
+        if (!appendCode.empty())
+            Preprocessor::preprocessWhitespaces(appendCode);
+
+        checkFile(configuration.code + appendCode, filename.c_str());
+    }
+    catch (std::runtime_error &e)
+    {
+        const std::string fixedpath = Path::toNativeSeparators(filename);
+        _errorLogger.reportOut("Bailing out from checking " + fixedpath + ": " + e.what());
+    }
+
+    return exitcode;
+}
+
+void CppCheck::reportSkippedConfigurations(const std::string &filename)
+{
+    if (_settings._errorsOnly)
+        return;
+
+    if (_tooManyConfigurations)
+        _errorLogger.reportOut(tooManyConfigurations(filename));
+
+    if (_configBudgetSpent)
+        _errorLogger.reportOut("Bailing out from checking " + Path::toNativeSeparators(filename) +
+                               ": The time budget for the configurations is spent.");
+
+    if (_skippedConfigurations > 0 && _settings._verbose)
+        _errorLogger.reportOut(skippedConfigurations(filename, _skippedConfigurations));
+}
+
 void CppCheck::analyseFile(std::istream &fin, const std::string &filename)
 {
     // Preprocess file..
@@ -218,27 +506,40 @@ void CppCheck::analyseFile(std::istream &fin, const std::string &filename)
     std::list<std::string> configurations;
     std::string filedata = "";
     preprocessor.preprocess(fin, filedata, configurations, filename, _settings._includePaths);
-    const std::string code = Preprocessor::getcode(filedata, "", filename, &_settings, &_errorLogger);
 
-    // Tokenize..
-    Tokenizer tokenizer(&_settings, this);
-    std::istringstream istr(code);
-    tokenizer.tokenize(istr, filename.c_str(), "");
-    tokenizer.simplifyTokenList();
-
-    // Analyse the tokens..
-    std::set<std::string> data;
-    for (std::list<Check *>::const_iterator it = Check::instances().begin(); it != Check::instances().end(); ++it)
+    // Use the stored summaries if the file is unchanged..
+    const std::string hash(SummaryDatabase::hash(filedata));
+    SummaryDatabase::Data data;
+    if (!_summaries.find(filename, hash, data))
     {
-        (*it)->analyse(tokenizer.tokens(), data);
+        const DirectiveTree directives(filedata, &_settings, preprocessor.getSourceLocations());
+        const std::string code = Preprocessor::getcode(directives, "", filename, &_settings, &_errorLogger);
+
+        // Tokenize..
+        Tokenizer tokenizer(&_settings, this);
+        tokenizer.setSourceLocations(&preprocessor.getSourceLocations());
+        std::istringstream istr(code);
+        tokenizer.tokenize(istr, filename.c_str(), "");
+        tokenizer.simplifyTokenList();
+
+        // Analyse the tokens..
+        for (std::list<Check *>::const_iterator it = Check::instances().begin(); it != Check::instances().end(); ++it)
+        {
+            (*it)->analyse(tokenizer.tokens(), data[(*it)->name()]);
+        }
+
+        _summaries.insert(filename, hash, data);
     }
 
     // Save analysis results..
+    for (SummaryDatabase::Data::const_iterator it = data.begin(); it != data.end(); ++it)
+        _settings.functionSummaries[it->first].insert(it->second.begin(), it->second.end());
+
     // TODO: This loop should be protected by a mutex or something like that
     //       The saveAnalysisData must _not_ be called from many threads at the same time.
     for (std::list<Check *>::const_iterator it = Check::instances().begin(); it != Check::instances().end(); ++it)
     {
-        (*it)->saveAnalysisData(data);
+        (*it)->saveAnalysisData(data[(*it)->name()]);
     }
 }
 
@@ -252,6 +553,8 @@ void CppCheck::checkFile(const std::string &code, const char FileName[])
         return;
 
     Tokenizer _tokenizer(&_settings, this);
+    _tokenizer.setTimerResults(&S_timerResults);
+    _tokenizer.setSourceLocations(&_locations);
     bool result;
 
     // Tokenize the file
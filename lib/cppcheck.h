@@ -22,8 +22,11 @@
 #include "settings.h"
 #include "errorlogger.h"
 #include "checkunusedfunctions.h"
+#include "summarydatabase.h"
+#include "preprocessor.h"
 
 #include <string>
+#include <ctime>
 #include <list>
 #include <sstream>
 #include <vector>
@@ -125,7 +128,68 @@ public:
      */
     void analyseFile(std::istream &f, const std::string &filename);
 
+    /** @brief A configuration of a file and the preprocessed code for it */
+    struct Configuration
+    {
+        Configuration(const std::string &name_, const std::string &code_)
+            : name(name_), code(code_)
+        { }
+
+        /** @brief the configuration, e.g. "A;B" */
+        std::string name;
+
+        /** @brief the code of the file in this configuration */
+        std::string code;
+    };
+
+    /**
+     * @brief Preprocess a file and get the configurations that should be
+     * checked. Configurations that give the same code as an earlier
+     * configuration are left out and, unless --force or --config-budget
+     * is used, only the 12 first configurations are returned. With
+     * --config-budget no more configurations are preprocessed when the
+     * time budget is spent. The configurations are checked with checkConfiguration(). ThreadExecutor
+     * checks them in separate processes. The configurations that were
+     * left out are reported with reportSkippedConfigurations().
+     * @param filename the file. Content given with addFile() is used if there is any.
+     * @return configurations to check
+     */
+    std::list<Configuration> getConfigurations(const std::string &filename);
+
+    /**
+     * @brief Check one configuration of a file that has been preprocessed
+     * with getConfigurations().
+     * @param filename the file
+     * @param configuration the configuration to check
+     * @return 1 if errors were found in the file, otherwise 0
+     */
+    unsigned int checkConfiguration(const std::string &filename, const Configuration &configuration);
+
+    /**
+     * @brief Report the configurations that getConfigurations() left out
+     * of the latest file.
+     * @param filename the file
+     */
+    void reportSkippedConfigurations(const std::string &filename);
+
+    /**
+     * @brief Get the result of the latest file
+     * @return 1 if errors were found in the latest file, otherwise 0
+     */
+    unsigned int getExitCode() const
+    {
+        return exitcode;
+    }
+
 private:
+    /**
+     * @brief Preprocess file
+     * @param filename the file
+     * @param filedata the preprocessed file data is written here
+     * @return the configurations of the file
+     */
+    std::list<Preprocessor::Configuration> preprocessFile(const std::string &filename, std::string &filedata);
+
     /** @brief Check file */
     void checkFile(const std::string &code, const char FileName[]);
 
@@ -156,11 +220,29 @@ private:
     /** @brief Key is file name, and value is the content of the file */
     std::map<std::string, std::string> _fileContents;
 
+    /** @brief Function summaries from the analysis of the files (--test-2-pass) */
+    SummaryDatabase _summaries;
+
     CheckUnusedFunctions _checkUnusedFunctions;
     ErrorLogger &_errorLogger;
 
     /** @brief Current preprocessor configuration */
     std::string     cfg;
+
+    /** @brief The files and line numbers of the lines of the latest preprocessed file */
+    SourceLocations _locations;
+
+    /** @brief Number of configurations of the latest file that give the same code as a selected configuration */
+    unsigned int _skippedConfigurations;
+
+    /** @brief Were configurations of the latest file left out because there were too many? */
+    bool _tooManyConfigurations;
+
+    /** @brief When the time budget for the configurations of the latest file is spent (--config-budget) */
+    std::clock_t _configDeadline;
+
+    /** @brief Were configurations of the latest file left out because the time budget was spent? */
+    bool _configBudgetSpent;
 };
 
 /// @}
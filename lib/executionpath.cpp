@@ -19,9 +19,12 @@
 
 #include "executionpath.h"
 #include "token.h"
+#include "tokenize.h"
+#include "settings.h"
+#include "timer.h"
 #include <memory>
 #include <set>
-#include <iterator>
+#include <map>
 #include <iostream>
 
 
@@ -84,20 +87,81 @@ static void printchecks(const std::list<ExecutionPath *> &checks)
 
 
 
+/**
+ * @brief Is the checking within the budget? If there are too many
+ * execution paths they are widened first.
+ * @param checks the execution paths
+ * @param budget the budget for the function body
+ * @return false => the budget is exhausted, bail out
+ */
+static bool withinBudget(std::list<ExecutionPath *> &checks, ExecutionPathBudget &budget)
+{
+    if (budget.maxClocks > 0 && budget.getClock() > budget.deadline)
+    {
+        ++budget.exhausted;
+        return false;
+    }
+
+    if (checks.size() <= budget.maxPaths)
+        return true;
+
+    // Widen: stop tracking variables that have several execution paths
+    std::map<unsigned int, unsigned int> pathsForVar;
+    for (std::list<ExecutionPath *>::const_iterator it = checks.begin(); it != checks.end(); ++it)
+        ++pathsForVar[(*it)->varId];
+    for (std::list<ExecutionPath *>::iterator it = checks.begin(); it != checks.end();)
+    {
+        if ((*it)->varId != 0 && pathsForVar[(*it)->varId] > 1)
+        {
+            delete *it;
+            checks.erase(it++);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+    ++budget.widened;
+
+    if (checks.size() <= budget.maxPaths)
+        return true;
+
+    ++budget.exhausted;
+    return false;
+}
+
+/** Execution paths indexed by hash value */
+typedef std::multimap<unsigned int, const ExecutionPath *> ExecutionPathIndex;
+
+/** Is there an execution path in the index that is equal to the given path? */
+static const ExecutionPath *findEqual(const ExecutionPathIndex &index, const ExecutionPath *c)
+{
+    const unsigned int h = c->hash();
+    for (ExecutionPathIndex::const_iterator it = index.lower_bound(h); it != index.end() && it->first == h; ++it)
+    {
+        if (*(it->second) == *c)
+            return it->second;
+    }
+    return 0;
+}
+
 /**
  * @brief Parse If/Switch body recursively.
  * @param tok First token in body.
  * @param checks The current checks
  * @param newchecks new checks
  * @param countif The countif set - count number of if for each execution path
+ * @param budget The budget for the function body
  */
 static void parseIfSwitchBody(const Token * const tok,
                               const std::list<ExecutionPath *> &checks,
                               std::list<ExecutionPath *> &newchecks,
-                              std::set<unsigned int> &countif)
+                              std::set<unsigned int> &countif,
+                              ExecutionPathBudget &budget)
 {
     std::set<unsigned int> countif2;
     std::list<ExecutionPath *> c;
+    ExecutionPathIndex index;
     if (!checks.empty())
     {
         std::list<ExecutionPath *>::const_iterator it;
@@ -107,30 +171,43 @@ static void parseIfSwitchBody(const Token * const tok,
                 c.push_back((*it)->copy());
             if ((*it)->varId != 0)
                 countif2.insert((*it)->varId);
+            index.insert(std::make_pair((*it)->hash(), *it));
         }
     }
-    ExecutionPath::checkScope(tok, c);
+    ExecutionPath::checkScope(tok, c, budget);
+
+    // The execution paths from the previous bodies. An execution path
+    // that is equal to one of these is merged with it.
+    ExecutionPathIndex newindex;
+    for (std::list<ExecutionPath *>::const_iterator it = newchecks.begin(); it != newchecks.end(); ++it)
+        newindex.insert(std::make_pair((*it)->hash(), *it));
+
     while (!c.empty())
     {
         if (c.back()->varId == 0)
         {
+            delete c.back();
             c.pop_back();
             continue;
         }
 
-        bool duplicate = false;
-        std::list<ExecutionPath *>::const_iterator it;
-        for (it = checks.begin(); it != checks.end(); ++it)
+        const ExecutionPath *equal = findEqual(index, c.back());
+        if (equal)
+        {
+            countif2.erase(equal->varId);
+            delete c.back();
+        }
+        else
         {
-            if (*(*it) == *c.back())
+            const ExecutionPath *merged = findEqual(newindex, c.back());
+            if (merged && merged->numberOfIf == c.back()->numberOfIf)
+                delete c.back();
+            else
             {
-                duplicate = true;
-                countif2.erase((*it)->varId);
-                break;
+                newindex.insert(std::make_pair(c.back()->hash(), c.back()));
+                newchecks.push_back(c.back());
             }
         }
-        if (!duplicate)
-            newchecks.push_back(c.back());
         c.pop_back();
     }
 
@@ -138,8 +215,32 @@ static void parseIfSwitchBody(const Token * const tok,
     countif.insert(countif2.begin(), countif2.end());
 }
 
+/**
+ * @brief Add the execution paths from the if/switch bodies to the current
+ * execution paths. A path that is equal to a current path (e.g. from the
+ * "else" body) is merged with it.
+ * @param checks The current checks
+ * @param newchecks The checks from the bodies. The list is emptied.
+ */
+static void joinExecutionPaths(std::list<ExecutionPath *> &checks, std::list<ExecutionPath *> &newchecks)
+{
+    ExecutionPathIndex index;
+    for (std::list<ExecutionPath *>::const_iterator it = checks.begin(); it != checks.end(); ++it)
+        index.insert(std::make_pair((*it)->hash(), *it));
+
+    for (std::list<ExecutionPath *>::const_iterator it = newchecks.begin(); it != newchecks.end(); ++it)
+    {
+        const ExecutionPath *equal = findEqual(index, *it);
+        if (equal && equal->numberOfIf == (*it)->numberOfIf)
+            delete *it;
+        else
+            checks.push_back(*it);
+    }
+    newchecks.clear();
+}
+
 
-void ExecutionPath::checkScope(const Token *tok, std::list<ExecutionPath *> &checks)
+void ExecutionPath::checkScope(const Token *tok, std::list<ExecutionPath *> &checks, ExecutionPathBudget &budget)
 {
     if (!tok || tok->str() == "}" || checks.empty())
         return;
@@ -163,7 +264,7 @@ void ExecutionPath::checkScope(const Token *tok, std::list<ExecutionPath *> &che
         if (Token::simpleMatch(tok, "while ("))
         {
             // parse condition
-            if (checks.size() > 10 || check->parseCondition(*tok->tokAt(2), checks))
+            if (!withinBudget(checks, budget) || check->parseCondition(*tok->tokAt(2), checks))
             {
                 ExecutionPath::bailOut(checks);
                 return;
@@ -203,7 +304,7 @@ void ExecutionPath::checkScope(const Token *tok, std::list<ExecutionPath *> &che
         if (tok->str() == "switch")
         {
             // parse condition
-            if (checks.size() > 10 || check->parseCondition(*tok->next(), checks))
+            if (!withinBudget(checks, budget) || check->parseCondition(*tok->next(), checks))
             {
                 ExecutionPath::bailOut(checks);
                 return;
@@ -226,12 +327,12 @@ void ExecutionPath::checkScope(const Token *tok, std::list<ExecutionPath *> &che
                     else if (tok2->str() == "case" &&
                              !Token::Match(tok2, "case %num% : ; case"))
                     {
-                        parseIfSwitchBody(tok2, checks, newchecks, countif);
+                        parseIfSwitchBody(tok2, checks, newchecks, countif, budget);
                     }
                 }
 
                 // Add newchecks to checks..
-                std::copy(newchecks.begin(), newchecks.end(), std::back_inserter(checks));
+                joinExecutionPaths(checks, newchecks);
 
                 // Increase numberOfIf
                 std::list<ExecutionPath *>::iterator it;
@@ -270,7 +371,10 @@ void ExecutionPath::checkScope(const Token *tok, std::list<ExecutionPath *> &che
                 for (std::list<ExecutionPath *>::iterator it = checks.begin(); it != checks.end();)
                 {
                     if ((*it)->numberOfIf > 0)
+                    {
+                        delete *it;
                         checks.erase(it++);
+                    }
                     else
                         ++it;
                 }
@@ -369,7 +473,7 @@ void ExecutionPath::checkScope(const Token *tok, std::list<ExecutionPath *> &che
         // ; { ... }
         if (Token::Match(tok->previous(), "[;{}] {"))
         {
-            ExecutionPath::checkScope(tok->next(), checks);
+            ExecutionPath::checkScope(tok->next(), checks, budget);
             tok = tok->link();
             continue;
         }
@@ -386,7 +490,7 @@ void ExecutionPath::checkScope(const Token *tok, std::list<ExecutionPath *> &che
                 tok = tok->next();
 
                 // parse condition
-                if (checks.size() > 10 || check->parseCondition(*tok->next(), checks))
+                if (!withinBudget(checks, budget) || check->parseCondition(*tok->next(), checks))
                 {
                     ExecutionPath::bailOut(checks);
                     ExecutionPath::bailOut(newchecks);
@@ -407,7 +511,7 @@ void ExecutionPath::checkScope(const Token *tok, std::list<ExecutionPath *> &che
                 }
 
                 // Recursively check into the if ..
-                parseIfSwitchBody(tok->next(), checks, newchecks, countif);
+                parseIfSwitchBody(tok->next(), checks, newchecks, countif, budget);
 
                 // goto "}"
                 tok = tok->link();
@@ -422,7 +526,7 @@ void ExecutionPath::checkScope(const Token *tok, std::list<ExecutionPath *> &che
                     continue;
 
                 // there is no "if"..
-                ExecutionPath::checkScope(tok->next(), checks);
+                ExecutionPath::checkScope(tok->next(), checks, budget);
                 tok = tok->link();
                 if (!tok)
                 {
@@ -432,7 +536,7 @@ void ExecutionPath::checkScope(const Token *tok, std::list<ExecutionPath *> &che
             }
 
             // Add newchecks to checks..
-            std::copy(newchecks.begin(), newchecks.end(), std::back_inserter(checks));
+            joinExecutionPaths(checks, newchecks);
 
             // Increase numberOfIf
             std::list<ExecutionPath *>::iterator it;
@@ -475,8 +579,11 @@ void ExecutionPath::checkScope(const Token *tok, std::list<ExecutionPath *> &che
     }
 }
 
-void checkExecutionPaths(const Token *tok, ExecutionPath *c)
+void checkExecutionPaths(const Token *tok, ExecutionPath *c, ExecutionPathBudget *b)
 {
+    ExecutionPathBudget defaultBudget;
+    ExecutionPathBudget &budget = b ? *b : defaultBudget;
+
     for (; tok; tok = tok->next())
     {
         if (tok->str() != ")")
@@ -490,18 +597,28 @@ void checkExecutionPaths(const Token *tok, ExecutionPath *c)
             if (tok->str() == "const")
                 tok = tok->next();
 
+            if (budget.maxClocks > 0)
+                budget.deadline = budget.getClock() + budget.maxClocks;
+
             std::list<ExecutionPath *> checks;
             checks.push_back(c->copy());
-            ExecutionPath::checkScope(tok, checks);
+            ExecutionPath::checkScope(tok, checks, budget);
 
             c->end(checks, tok->link());
 
-            while (!checks.empty())
-            {
-                delete checks.back();
-                checks.pop_back();
-            }
+            ExecutionPath::bailOut(checks);
         }
     }
 }
 
+void checkExecutionPaths(const Tokenizer *tokenizer, const Settings *settings, ExecutionPath *c)
+{
+    ExecutionPathBudget budget;
+    budget.maxPaths = settings->_maxExecutionPaths;
+    budget.maxClocks = (std::clock_t)((double)settings->_maxExecutionPathTime * CLOCKS_PER_SEC / 1000);
+
+    checkExecutionPaths(tokenizer->tokens(), c, &budget);
+
+    Timer::Count("ExecutionPath::checkExecutionPaths: widened", budget.widened, settings->_showtime, tokenizer->getTimerResults());
+    Timer::Count("ExecutionPath::checkExecutionPaths: budget exhausted", budget.exhausted, settings->_showtime, tokenizer->getTimerResults());
+}
@@ -20,9 +20,13 @@
 #define executionpathH
 
 #include <list>
+#include <ctime>
 
 class Token;
+class Tokenizer;
+class Settings;
 class Check;
+class ExecutionPathBudget;
 
 /**
  * Base class for Execution Paths checking
@@ -40,6 +44,16 @@ protected:
     /** Are two execution paths equal? */
     virtual bool is_equal(const ExecutionPath *) const = 0;
 
+    /**
+     * Hash value for the state of the execution path. Equal execution
+     * paths must have the same hash value. Used to find equal execution
+     * paths quickly when the paths are joined after "if" / "switch".
+     */
+    virtual unsigned int hash_value() const
+    {
+        return 0;
+    }
+
 public:
     ExecutionPath(Check *c, unsigned int id) : owner(c), numberOfIf(0), varId(id)
     { }
@@ -132,12 +146,70 @@ public:
         return bool(varId == e.varId && is_equal(&e));
     }
 
-    static void checkScope(const Token *tok, std::list<ExecutionPath *> &checks);
+    /** hash value for the variable and the state, see hash_value() */
+    unsigned int hash() const
+    {
+        return varId * 31U + hash_value();
+    }
+
+    /**
+     * Check the execution paths in a scope
+     * @param tok first token in the scope
+     * @param checks the execution paths
+     * @param budget the budget for the function body
+     */
+    static void checkScope(const Token *tok, std::list<ExecutionPath *> &checks, ExecutionPathBudget &budget);
 };
 
 
-void checkExecutionPaths(const Token *tok, ExecutionPath *c);
-void checkExecutionPaths(const Token *tok, ExecutionPath *c);
+/**
+ * @brief Budget for checking the execution paths of one function body.
+ * When there are too many execution paths they are widened: the variables
+ * that have several different states are not tracked anymore. When that
+ * is not enough, or the time is out, all the execution paths bail out.
+ */
+class ExecutionPathBudget
+{
+public:
+    ExecutionPathBudget() : maxPaths(10), maxClocks(0), widened(0), exhausted(0), deadline(0), getClock(std::clock)
+    { }
+
+    /** max number of execution paths */
+    unsigned int maxPaths;
+
+    /** max time for a function body. 0 => no limit */
+    std::clock_t maxClocks;
+
+    /** number of times the execution paths were widened */
+    unsigned long widened;
 
+    /** number of times the execution paths bailed out because the budget was exhausted */
+    unsigned long exhausted;
+
+    /** when the time for the current function body is out */
+    std::clock_t deadline;
+
+    /** the clock that the time is measured with, std::clock by default */
+    std::clock_t (*getClock)();
+};
+
+/**
+ * Check the execution paths of all function bodies
+ * @param tok first token
+ * @param c startup execution path
+ * @param budget limits for each function body, 0 => default limits
+ */
+void checkExecutionPaths(const Token *tok, ExecutionPath *c, ExecutionPathBudget *budget = 0);
+
+/**
+ * Check the execution paths of all function bodies with the limits from
+ * the settings (--max-paths, --max-path-time). For --showtime it is
+ * counted how many times the paths were widened and how many times the
+ * budget was exhausted.
+ * @param tokenizer the simplified token list
+ * @param settings the settings
+ * @param c startup execution path
+ */
+void checkExecutionPaths(const Tokenizer *tokenizer, const Settings *settings, ExecutionPath *c);
 
 #endif
@@ -25,6 +25,8 @@ HEADERS += $${BASEPATH}check.h \
            $${BASEPATH}path.h \
            $${BASEPATH}preprocessor.h \
            $${BASEPATH}settings.h \
+           $${BASEPATH}sourcelocations.h \
+           $${BASEPATH}summarydatabase.h \
            $${BASEPATH}symboldatabase.h \
            $${BASEPATH}timer.h \
            $${BASEPATH}token.h \
@@ -52,6 +54,8 @@ SOURCES += $${BASEPATH}checkautovariables.cpp \
            $${BASEPATH}path.cpp \
            $${BASEPATH}preprocessor.cpp \
            $${BASEPATH}settings.cpp \
+           $${BASEPATH}sourcelocations.cpp \
+           $${BASEPATH}summarydatabase.cpp \
            $${BASEPATH}symboldatabase.cpp \
            $${BASEPATH}timer.cpp \
            $${BASEPATH}token.cpp \
@@ -67,7 +67,7 @@ double MathLib::toDoubleNumber(const std::string &str)
 {
     if (str.compare(0, 2, "0x") == 0)
     {
-        return std::strtoul(str.c_str(), '\0', 16);
+        return std::strtoul(str.c_str(), 0, 16);
     }
     // nullcheck
     else if (isNullValue(str))
@@ -209,70 +209,93 @@ bool MathLib::isInt(const std::string & s)
 
 }
 
-std::string MathLib::add(const std::string & first, const std::string & second)
+MathLib::Value::Value(const std::string &str)
+    : _isFloat(!isInt(str)), _intValue(toLongNumber(str)), _doubleValue(toDoubleNumber(str))
 {
-    if (MathLib::isInt(first) && MathLib::isInt(second))
-    {
-        return toString<bigint>(toLongNumber(first) + toLongNumber(second));
-    }
-    return toString<double>(toDoubleNumber(first) + toDoubleNumber(second));
 }
 
-std::string MathLib::subtract(const std::string &first, const std::string &second)
+std::string MathLib::Value::str() const
 {
-    if (MathLib::isInt(first) && MathLib::isInt(second))
-    {
-        return toString<bigint>(toLongNumber(first) - toLongNumber(second));
-    }
-    return toString<double>(toDoubleNumber(first) - toDoubleNumber(second));
+    if (_isFloat)
+        return toString<double>(_doubleValue);
+    return toString<bigint>(_intValue);
 }
 
-std::string MathLib::divide(const std::string &first, const std::string &second)
+MathLib::Value MathLib::add(const Value &first, const Value &second)
 {
-    if (MathLib::isInt(first) && MathLib::isInt(second))
-    {
-        return toString<bigint>(toLongNumber(first) / toLongNumber(second));
-    }
-    return toString<double>(toDoubleNumber(first) / toDoubleNumber(second));
+    if (!first.isFloat() && !second.isFloat())
+        return Value(first.getInt() + second.getInt());
+    return Value(first.getDouble() + second.getDouble());
 }
 
-std::string MathLib::multiply(const std::string &first, const std::string &second)
+MathLib::Value MathLib::subtract(const Value &first, const Value &second)
 {
-    if (MathLib::isInt(first) && MathLib::isInt(second))
-    {
-        return toString<bigint>(toLongNumber(first) * toLongNumber(second));
-    }
-    return toString<double>(toDoubleNumber(first) * toDoubleNumber(second));
+    if (!first.isFloat() && !second.isFloat())
+        return Value(first.getInt() - second.getInt());
+    return Value(first.getDouble() - second.getDouble());
 }
 
-std::string MathLib::calculate(const std::string &first, const std::string &second, char action, const Tokenizer *tokenizer)
+MathLib::Value MathLib::divide(const Value &first, const Value &second)
+{
+    if (!first.isFloat() && !second.isFloat())
+        return Value(first.getInt() / second.getInt());
+    return Value(first.getDouble() / second.getDouble());
+}
+
+MathLib::Value MathLib::multiply(const Value &first, const Value &second)
 {
-    std::string result("0");
+    if (!first.isFloat() && !second.isFloat())
+        return Value(first.getInt() * second.getInt());
+    return Value(first.getDouble() * second.getDouble());
+}
 
+MathLib::Value MathLib::calculate(const Value &first, const Value &second, char action, const Tokenizer *tokenizer)
+{
     switch (action)
     {
     case '+':
-        result = MathLib::add(first, second);
-        break;
+        return MathLib::add(first, second);
 
     case '-':
-        result = MathLib::subtract(first, second);
-        break;
+        return MathLib::subtract(first, second);
 
     case '*':
-        result = MathLib::multiply(first, second);
-        break;
+        return MathLib::multiply(first, second);
 
     case '/':
-        result = MathLib::divide(first, second);
-        break;
+        return MathLib::divide(first, second);
 
     default:
         tokenizer->cppcheckError(0);
         break;
     }
 
-    return result;
+    return Value(bigint(0));
+}
+
+std::string MathLib::add(const std::string & first, const std::string & second)
+{
+    return add(Value(first), Value(second)).str();
+}
+
+std::string MathLib::subtract(const std::string &first, const std::string &second)
+{
+    return subtract(Value(first), Value(second)).str();
+}
+
+std::string MathLib::divide(const std::string &first, const std::string &second)
+{
+    return divide(Value(first), Value(second)).str();
+}
+
+std::string MathLib::multiply(const std::string &first, const std::string &second)
+{
+    return multiply(Value(first), Value(second)).str();
+}
+
+std::string MathLib::calculate(const std::string &first, const std::string &second, char action, const Tokenizer *tokenizer)
+{
+    return calculate(Value(first), Value(second), action, tokenizer).str();
 }
 
 std::string MathLib::sin(const std::string &tok)
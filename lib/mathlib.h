@@ -56,6 +56,53 @@ public:
     static bool isFloat(const std::string &str);
     static bool isNegative(const std::string &str);
 
+    /** @brief A parsed number. Use this instead of the string functions when a number is used many times. */
+    class Value
+    {
+    public:
+        Value() : _isFloat(false), _intValue(0), _doubleValue(0.0)
+        { }
+
+        explicit Value(bigint value) : _isFloat(false), _intValue(value), _doubleValue(static_cast<double>(value))
+        { }
+
+        explicit Value(double value) : _isFloat(true), _intValue(static_cast<bigint>(value)), _doubleValue(value)
+        { }
+
+        /** Parse number. getInt() and getDouble() return the same values as toLongNumber() and toDoubleNumber() */
+        explicit Value(const std::string &str);
+
+        /** Is the number a floating point number (not an integer)? */
+        bool isFloat() const
+        {
+            return _isFloat;
+        }
+
+        bigint getInt() const
+        {
+            return _intValue;
+        }
+
+        double getDouble() const
+        {
+            return _doubleValue;
+        }
+
+        /** Get the number as a string */
+        std::string str() const;
+
+    private:
+        bool _isFloat;
+        bigint _intValue;
+        double _doubleValue;
+    };
+
+    static Value add(const Value &first, const Value &second);
+    static Value subtract(const Value &first, const Value &second);
+    static Value multiply(const Value &first, const Value &second);
+    static Value divide(const Value &first, const Value &second);
+    static Value calculate(const Value &first, const Value &second, char action, const Tokenizer *tokenizer);
+
     static std::string add(const std::string & first, const std::string & second);
     static std::string subtract(const std::string & first, const std::string & second);
     static std::string multiply(const std::string & first, const std::string & second);
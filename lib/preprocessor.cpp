@@ -23,6 +23,7 @@
 #include "path.h"
 #include "errorlogger.h"
 #include "settings.h"
+#include "mathlib.h"
 
 #include <algorithm>
 #include <stdexcept>
@@ -33,7 +34,7 @@
 #include <cstring>
 #include <vector>
 #include <set>
-#include <stack>
+#include <limits>
 
 Preprocessor::Preprocessor(Settings *settings, ErrorLogger *errorLogger) : _settings(settings), _errorLogger(errorLogger)
 {
@@ -106,6 +107,151 @@ static std::string join(const std::list<std::string> &list, char separator)
     return s;
 }
 
+/**
+ * Get the file and the line number of a line in the preprocessed code
+ * @param locations the files and line numbers of the lines
+ * @param filename the name of the source file
+ * @param linenr the line in the code. The line number in the file is written here.
+ * @return the name of the file
+ */
+static std::string getLocation(const SourceLocations &locations, const std::string &filename, unsigned int &linenr)
+{
+    unsigned int file;
+    locations.find(linenr, file, linenr);
+    return (file == 0) ? filename : locations.files()[file];
+}
+
+/**
+ * @brief Set of configurations. The macro names are interned and each
+ * configuration is stored as a bitset of macro ids. Defines with a
+ * value ("A=1") are kept in a side table. The "A;B=1;C" strings are only
+ * created by toList() for the names of the configurations.
+ *
+ * This is only used by getcfgs() to de-duplicate the configurations.
+ */
+class ConfigurationSet
+{
+public:
+    /**
+     * Add configuration
+     * @param defs the defines in the configuration, "A" or "A=1"
+     * @return false if a define has some other form. Nothing is added then.
+     */
+    bool insert(const std::list<std::string> &defs)
+    {
+        Configuration cfg;
+        for (std::list<std::string>::const_iterator it = defs.begin(); it != defs.end(); ++it)
+        {
+            const std::string::size_type eq = it->find("=");
+            const std::string name(it->substr(0, eq));
+            if (!isName(name))
+                return false;
+
+            if (eq == std::string::npos)
+            {
+                const unsigned int id = getId(name);
+                const unsigned int bits = 8 * sizeof(unsigned long);
+                if (cfg.macros.size() <= id / bits)
+                    cfg.macros.resize(id / bits + 1, 0);
+                cfg.macros[id / bits] |= 1UL << (id % bits);
+            }
+            else
+            {
+                const std::string value(it->substr(eq + 1));
+                if (value.find_first_not_of("0123456789") != std::string::npos)
+                    return false;
+                cfg.values.insert(std::make_pair(getId(name), value));
+            }
+        }
+        _configurations.insert(cfg);
+        return true;
+    }
+
+    /** Get the configurations, sorted by name */
+    std::list<Preprocessor::Configuration> toList() const
+    {
+        std::map<std::string, Preprocessor::Configuration> ret;
+        for (std::set<Configuration>::const_iterator cfg = _configurations.begin(); cfg != _configurations.end(); ++cfg)
+        {
+            std::map<std::string, std::string> defines;
+            std::list<std::string> defs;
+            const unsigned int bits = 8 * sizeof(unsigned long);
+            for (unsigned int id = 0; id < bits * cfg->macros.size(); ++id)
+            {
+                if (cfg->macros[id / bits] & (1UL << (id % bits)))
+                {
+                    defines[_names[id]] = "";
+                    defs.push_back(_names[id]);
+                }
+            }
+            for (std::set<std::pair<unsigned int, std::string> >::const_iterator it = cfg->values.begin(); it != cfg->values.end(); ++it)
+            {
+                defines[_names[it->first]] = it->second;
+                defs.push_back(_names[it->first] + "=" + it->second);
+            }
+
+            defs.sort();
+            const std::string name(join(defs, ';'));
+            Preprocessor::Configuration &c = ret[name];
+            c.name = name;
+            c.defines.swap(defines);
+        }
+
+        std::list<Preprocessor::Configuration> list;
+        for (std::map<std::string, Preprocessor::Configuration>::const_iterator it = ret.begin(); it != ret.end(); ++it)
+            list.push_back(it->second);
+        return list;
+    }
+
+private:
+    /** @brief a configuration */
+    struct Configuration
+    {
+        /** bitset of defined macros */
+        std::vector<unsigned long> macros;
+
+        /** macros with values */
+        std::set<std::pair<unsigned int, std::string> > values;
+
+        bool operator<(const Configuration &other) const
+        {
+            if (macros != other.macros)
+                return macros < other.macros;
+            return values < other.values;
+        }
+    };
+
+    static bool isName(const std::string &str)
+    {
+        if (str.empty() || !(std::isalpha(static_cast<unsigned char>(str[0])) || str[0] == '_'))
+            return false;
+        for (std::string::size_type pos = 1; pos < str.size(); ++pos)
+        {
+            if (!std::isalnum(static_cast<unsigned char>(str[pos])) && str[pos] != '_')
+                return false;
+        }
+        return true;
+    }
+
+    unsigned int getId(const std::string &name)
+    {
+        const std::map<std::string, unsigned int>::const_iterator it = _ids.find(name);
+        if (it != _ids.end())
+            return it->second;
+        _ids[name] = _names.size();
+        _names.push_back(name);
+        return _names.size() - 1;
+    }
+
+    /** macro names. index is id */
+    std::vector<std::string> _names;
+
+    /** macro ids */
+    std::map<std::string, unsigned int> _ids;
+
+    std::set<Configuration> _configurations;
+};
+
 /** Just read the code into a string. Perform simple cleanup of the code */
 std::string Preprocessor::read(std::istream &istr, const std::string &filename, Settings *settings)
 {
@@ -565,11 +711,12 @@ void Preprocessor::removeAsm(std::string &str)
 
 void Preprocessor::preprocess(std::istream &istr, std::map<std::string, std::string> &result, const std::string &filename, const std::list<std::string> &includePaths)
 {
-    std::list<std::string> configs;
+    std::list<Configuration> configs;
     std::string data;
     preprocess(istr, data, configs, filename, includePaths);
-    for (std::list<std::string>::const_iterator it = configs.begin(); it != configs.end(); ++it)
-        result[ *it ] = Preprocessor::getcode(data, *it, filename, _settings, _errorLogger);
+    const DirectiveTree directives(data, _settings, _locations);
+    for (std::list<Configuration>::const_iterator it = configs.begin(); it != configs.end(); ++it)
+        result[ it->name ] = Preprocessor::getcode(directives, *it, filename, _settings, _errorLogger);
 }
 
 std::string Preprocessor::removeSpaceNearNL(const std::string &str)
@@ -662,6 +809,14 @@ void Preprocessor::preprocessWhitespaces(std::string &processedFile)
 }
 
 void Preprocessor::preprocess(std::istream &srcCodeStream, std::string &processedFile, std::list<std::string> &resultConfigurations, const std::string &filename, const std::list<std::string> &includePaths)
+{
+    std::list<Configuration> configurations;
+    preprocess(srcCodeStream, processedFile, configurations, filename, includePaths);
+    for (std::list<Configuration>::const_iterator it = configurations.begin(); it != configurations.end(); ++it)
+        resultConfigurations.push_back(it->name);
+}
+
+void Preprocessor::preprocess(std::istream &srcCodeStream, std::string &processedFile, std::list<Configuration> &resultConfigurations, const std::string &filename, const std::list<std::string> &includePaths)
 {
     if (file0.empty())
         file0 = filename;
@@ -700,13 +855,18 @@ void Preprocessor::preprocess(std::istream &srcCodeStream, std::string &processe
     }
 
     std::set<std::string> systemIncludes;
-    handleIncludes(processedFile, filename, includePaths, systemIncludes);
+    std::set<std::string> handledFiles;
+    _includeGuards.clear();
+    _undefinedMacros.clear();
+    _includeFiles.clear();
+    _locations.clear();
+    handleIncludes(processedFile, filename, includePaths, systemIncludes, handledFiles, _locations);
 
     processedFile = replaceIfDefined(processedFile);
 
     // Get all possible configurations..
     if (!_settings || (_settings && _settings->userDefines.empty()))
-        resultConfigurations = getcfgs(processedFile, filename);
+        resultConfigurations = getcfgs(processedFile, filename, _locations);
 }
 
 
@@ -750,22 +910,22 @@ std::string Preprocessor::getdef(std::string line, bool def)
 
 
 
-std::list<std::string> Preprocessor::getcfgs(const std::string &filedata, const std::string &filename)
+std::list<Preprocessor::Configuration> Preprocessor::getcfgs(const std::string &filedata, const std::string &filename, const SourceLocations &locations)
 {
-    std::list<std::string> ret;
-    ret.push_back("");
+    // the configurations, as ';' separated conditions
+    std::set<std::string> cfgs;
+    cfgs.insert("");
 
     std::list<std::string> deflist, ndeflist;
 
     // constants defined through "#define" in the code..
     std::set<std::string> defines;
 
-    // How deep into included files are we currently parsing?
-    // 0=>Source file, 1=>Included by source file, 2=>included by header that was included by source file, etc
-    int filelevel = 0;
-
     bool includeguard = false;
 
+    // the ranges of lines from the included files
+    std::vector<SourceLocations::Range>::const_iterator range = locations.ranges().begin();
+
     unsigned int linenr = 0;
     std::istringstream istr(filedata);
     std::string line;
@@ -776,21 +936,9 @@ std::list<std::string> Preprocessor::getcfgs(const std::string &filedata, const
         if (_errorLogger)
             _errorLogger->reportProgress(filename, "Preprocessing (get configurations 1)", 0);
 
-
-        if (line.compare(0, 6, "#file ") == 0)
-        {
-            includeguard = true;
-            ++filelevel;
-            continue;
-        }
-
-        else if (line == "#endfile")
-        {
-            includeguard = false;
-            if (filelevel > 0)
-                --filelevel;
-            continue;
-        }
+        // At the start of an included file, the first #if is the include guard
+        for (; range != locations.ranges().end() && range->line <= linenr; ++range)
+            includeguard = (range->line > 1 && range->fileLine == 1);
 
         if (line.compare(0, 8, "#define ") == 0)
         {
@@ -842,15 +990,14 @@ std::list<std::string> Preprocessor::getcfgs(const std::string &filedata, const
 
                 ErrorLogger::ErrorMessage errmsg;
                 ErrorLogger::ErrorMessage::FileLocation loc;
-                loc.setfile(filename);
                 loc.line = linenr;
+                loc.setfile(getLocation(locations, filename, loc.line));
                 errmsg._callStack.push_back(loc);
                 errmsg._severity = Severity::fromString("error");
                 errmsg.setmsg("mismatching number of '(' and ')' in this line: " + def);
                 errmsg._id  = "preprocessor" + lineStream.str();
                 _errorLogger->reportErr(errmsg);
-                ret.clear();
-                return ret;
+                return std::list<Configuration>();
             }
 
             // Replace defined constants
@@ -898,10 +1045,7 @@ std::list<std::string> Preprocessor::getcfgs(const std::string &filedata, const
                 deflist.push_back(nmark);
             }
 
-            if (std::find(ret.begin(), ret.end(), def) == ret.end())
-            {
-                ret.push_back(def);
-            }
+            cfgs.insert(def);
         }
 
         else if (line.find("#else") == 0 && ! deflist.empty())
@@ -928,58 +1072,33 @@ std::list<std::string> Preprocessor::getcfgs(const std::string &filedata, const
         }
     }
 
-    // Remove defined constants from ifdef configurations..
+    // Names of defined constants..
+    std::set<std::string> defineNames;
+    for (std::set<std::string>::const_iterator it = defines.begin(); it != defines.end(); ++it)
+        defineNames.insert(it->substr(0, it->find("=")));
+
+    ConfigurationSet configurations;
+    std::set<std::string> unhandled;
+
     unsigned int count = 0;
-    for (std::list<std::string>::iterator it = ret.begin(); it != ret.end(); ++it)
+    for (std::set<std::string>::const_iterator it = cfgs.begin(); it != cfgs.end(); ++it)
     {
         if (_errorLogger)
-            _errorLogger->reportProgress(filename, "Preprocessing (get configurations 2)", (100 * count++) / ret.size());
+            _errorLogger->reportProgress(filename, "Preprocessing (get configurations 2)", (100 * count++) / cfgs.size());
 
-        std::string cfg(*it);
-        for (std::set<std::string>::const_iterator it2 = defines.begin(); it2 != defines.end(); ++it2)
-        {
-            std::string::size_type pos = 0;
-
-            // Get name of define
-            std::string defineName(*it2);
-            if (defineName.find("=") != std::string::npos)
-                defineName.erase(defineName.find("="));
+        std::list<std::string> defs = split(*it, ';');
 
-            // Remove ifdef configurations that match the defineName
-            while ((pos = cfg.find(defineName, pos)) != std::string::npos)
-            {
-                std::string::size_type pos1 = pos;
-                ++pos;
-                if (pos1 > 0 && cfg[pos1-1] != ';')
-                    continue;
-                std::string::size_type pos2 = pos1 + defineName.length();
-                if (pos2 < cfg.length() && cfg[pos2] != ';')
-                    continue;
-                --pos;
-                cfg.erase(pos, defineName.length());
-            }
-        }
-        if (cfg.length() != it->length())
+        // Remove defined constants from ifdef configurations..
+        for (std::list<std::string>::iterator def = defs.begin(); def != defs.end();)
         {
-            while (cfg.length() > 0 && cfg[0] == ';')
-                cfg.erase(0, 1);
-
-            while (cfg.length() > 0 && cfg[cfg.length()-1] == ';')
-                cfg.erase(cfg.length() - 1);
-
-            std::string::size_type pos = 0;
-            while ((pos = cfg.find(";;", pos)) != std::string::npos)
-                cfg.erase(pos, 1);
-
-            *it = cfg;
+            if (defineNames.find(*def) != defineNames.end())
+                defs.erase(def++);
+            else
+                ++def;
         }
-    }
-
-    // convert configurations: "defined(A) && defined(B)" => "A;B"
-    for (std::list<std::string>::iterator it = ret.begin(); it != ret.end(); ++it)
-    {
-        std::string s(*it);
 
+        // convert configurations: "defined(A) && defined(B)" => "A;B"
+        const std::string s(join(defs, ';'));
         if (s.find("&&") != std::string::npos)
         {
             Tokenizer tokenizer(_settings, _errorLogger);
@@ -1025,92 +1144,29 @@ std::list<std::string> Preprocessor::getcfgs(const std::string &filedata, const
                 }
             }
 
-            varList.sort();
-            s = join(varList, ';');
-
-            if (!s.empty())
-                *it = s;
+            if (!varList.empty())
+                defs = varList;
         }
-    }
 
-    // Convert configurations into a canonical form: B;C;A or C;A;B => A;B;C
-    for (std::list<std::string>::iterator it = ret.begin(); it != ret.end(); ++it)
-    {
-        // Split the configuration into a list of defines
-        std::list<std::string> defs = split(*it, ';');
-
-        // Re-constitute the configuration after sorting the defines
-        defs.sort();
-        *it = join(defs, ';');
+        if (!configurations.insert(defs))
+        {
+            defs.sort();
+            unhandled.insert(join(defs, ';'));
+        }
     }
 
-    // Remove duplicates from the ret list..
-    ret.sort();
-    ret.unique();
-
     // cleanup unhandled configurations..
-    for (std::list<std::string>::iterator it = ret.begin(); it != ret.end();)
+    if (_errorLogger && _settings && _settings->debugwarnings)
     {
-        const std::string s(*it + ";");
-
-        bool unhandled = false;
-
-        for (std::string::size_type pos = 0; pos < s.length(); ++pos)
-        {
-            const unsigned char c = static_cast<unsigned char>(s[pos]);
-
-            // ok with ";"
-            if (c == ';')
-                continue;
-
-            // identifier..
-            if (std::isalpha(c) || c == '_')
-            {
-                while (std::isalnum(s[pos]) || s[pos] == '_')
-                    ++pos;
-                if (s[pos] == '=')
-                {
-                    ++pos;
-                    while (std::isdigit(s[pos]))
-                        ++pos;
-                    if (s[pos] != ';')
-                    {
-                        unhandled = true;
-                        break;
-                    }
-                }
-
-                --pos;
-                continue;
-            }
-
-            // not ok..
-            else
-            {
-                unhandled = true;
-                break;
-            }
-        }
-
-        if (unhandled)
-        {
-            // unhandled ifdef configuration..
-            if (_errorLogger && _settings && _settings->debugwarnings)
-            {
-                std::list<ErrorLogger::ErrorMessage::FileLocation> locationList;
-                const ErrorLogger::ErrorMessage errmsg(locationList, Severity::debug, "unhandled configuration: " + *it, "debug");
-                _errorLogger->reportErr(errmsg);
-            }
-
-            ret.erase(it++);
-        }
-        else
+        for (std::set<std::string>::const_iterator it = unhandled.begin(); it != unhandled.end(); ++it)
         {
-            ++it;
+            std::list<ErrorLogger::ErrorMessage::FileLocation> locationList;
+            const ErrorLogger::ErrorMessage errmsg(locationList, Severity::debug, "unhandled configuration: " + *it, "debug");
+            _errorLogger->reportErr(errmsg);
         }
     }
 
-    return ret;
+    return configurations.toList();
 }
 
 
@@ -1219,218 +1275,727 @@ void Preprocessor::simplifyCondition(const std::map<std::string, std::string> &v
         condition = "0";
 }
 
-bool Preprocessor::match_cfg_def(const std::map<std::string, std::string> &cfg, std::string def)
+/**
+ * @brief A #if/#elif condition compiled into postfix code.
+ *
+ * The condition is parsed once and can then be evaluated against any
+ * number of configurations without tokenizing it again. Conditions with
+ * unsupported syntax, and configurations where a used macro doesn't have
+ * a plain integer value, are handled by Preprocessor::simplifyCondition.
+ */
+class PreprocessorCondition
 {
-    //std::cout << "cfg: \"" << cfg << "\"  ";
-    //std::cout << "def: \"" << def << "\"";
-
-    simplifyCondition(cfg, def, true);
-
-    if (cfg.find(def) != cfg.end())
-        return true;
-
-    if (def == "0")
-        return false;
+public:
+    explicit PreprocessorCondition(const std::string &condition)
+        : _compiled(false), _isDefined(false), _isNotDefined(false)
+    {
+        std::vector<std::string> tokens;
+        if (!tokenize(condition, tokens) || tokens.empty())
+            return;
 
-    if (def == "1")
-        return true;
+        // "#if A" and "#if !A" only check if A is defined
+        std::vector<std::string>::size_type first = 0, last = tokens.size();
+        while (last - first > 2 && tokens[first] == "(" && tokens[last-1] == ")")
+        {
+            ++first;
+            --last;
+        }
+        if (last - first == 1 && isName(tokens[first]))
+            _isDefined = true;
+        else if (last - first == 2 && tokens[first] == "!" && isName(tokens[first+1]))
+            _isNotDefined = true;
 
-    return false;
-}
+        std::vector<std::string>::size_type pos = 0;
+        _compiled = parse(tokens, pos, 1) && pos == tokens.size();
+    }
 
+    /**
+     * Evaluate the condition
+     * @param cfg configuration
+     * @param result the value of the condition is written here
+     * @return false if the condition can't be evaluated for this configuration
+     */
+    bool evaluate(const std::map<std::string, std::string> &cfg, bool &result) const
+    {
+        if (!_compiled)
+            return false;
 
-std::string Preprocessor::getcode(const std::string &filedata, std::string cfg, const std::string &filename, const Settings *settings, ErrorLogger *errorLogger)
-{
-    // For the error report
-    unsigned int lineno = 0;
+        if (_isDefined || _isNotDefined)
+        {
+            result = (cfg.find(_code.front().str) != cfg.end()) == _isDefined;
+            return true;
+        }
 
-    std::ostringstream ret;
+        std::vector<Value> stack;
+        for (std::vector<Op>::const_iterator op = _code.begin(); op != _code.end(); ++op)
+        {
+            if (op->type == Number)
+                stack.push_back(Value(op->value));
 
-    bool match = true;
-    std::list<bool> matching_ifdef;
-    std::list<bool> matched_ifdef;
+            else if (op->type == Defined)
+                stack.push_back(Value(cfg.find(op->str) != cfg.end() ? 1 : 0));
 
-    // Create a map for the cfg for faster access to defines
-    std::map<std::string, std::string> cfgmap;
-    {
-        std::string::size_type pos = 0;
-        for (;;)
-        {
-            std::string::size_type pos2 = cfg.find_first_of(";=", pos);
-            if (pos2 == std::string::npos)
+            else if (op->type == Macro)
             {
-                cfgmap[cfg.substr(pos)] = "";
-                break;
+                const std::map<std::string, std::string>::const_iterator it = cfg.find(op->str);
+                if (it == cfg.end())
+                    stack.push_back(Value());
+                else if (it->second.empty() && op->boolContext)
+                    stack.push_back(Value(1));
+                else if (!it->second.empty() && MathLib::isInt(it->second))
+                    stack.push_back(Value(MathLib::toLongNumber(it->second)));
+                else
+                    return false;
             }
-            if (cfg[pos2] == ';')
+
+            else if (op->type == Unary)
             {
-                cfgmap[cfg.substr(pos, pos2-pos)] = "";
+                MathLib::bigint &value = stack.back().value;
+                if (op->str == "!")
+                    value = !value;
+                else if (op->str == "~")
+                    value = ~value;
+                else if (op->str == "-")
+                    value = -value;
             }
+
             else
             {
-                std::string::size_type pos3 = pos2;
-                pos2 = cfg.find(";", pos2);
-                if (pos2 == std::string::npos)
-                {
-                    cfgmap[cfg.substr(pos, pos3-pos)] = cfg.substr(pos3 + 1);
-                    break;
-                }
-                else
+                const Value value2 = stack.back();
+                stack.pop_back();
+                Value &value1 = stack.back();
+
+                // "0 && X" and "1 || X" are known even if X is unknown
+                if (op->str == "&&" || op->str == "||")
                 {
-                    cfgmap[cfg.substr(pos, pos3-pos)] = cfg.substr(pos3 + 1, pos2 - pos3 - 1);
+                    const MathLib::bigint shortcut = (op->str == "||") ? 1 : 0;
+                    if ((value1.known && (value1.value != 0) == shortcut) ||
+                        (value2.known && (value2.value != 0) == shortcut))
+                    {
+                        value1 = Value(shortcut);
+                        continue;
+                    }
                 }
+
+                if (!value2.known)
+                    value1.known = false;
+                else if (value1.known && !calculate(op->str, value1.value, value2.value))
+                    return false;
             }
-            pos = pos2 + 1;
         }
+
+        result = (stack.back().known && stack.back().value != 0);
+        return true;
     }
 
-    std::istringstream istr(filedata);
-    std::string line;
-    while (getline(istr, line))
+private:
+    enum OpType { Number, Macro, Defined, Unary, Binary };
+
+    /** @brief value on the evaluation stack. macros that are not defined have unknown values */
+    struct Value
     {
-        ++lineno;
+        Value() : value(0), known(false)
+        { }
 
-        if (line.compare(0, 11, "#pragma asm") == 0)
-        {
-            ret << "\n";
-            bool found_end = false;
-            while (getline(istr, line))
-            {
-                if (line.compare(0, 14, "#pragma endasm") == 0)
-                {
-                    found_end = true;
-                    break;
-                }
+        explicit Value(MathLib::bigint v) : value(v), known(true)
+        { }
 
-                ret << "\n";
-            }
-            if (!found_end)
-                break;
+        MathLib::bigint value;
+        bool known;
+    };
 
-            if (line.find("=") != std::string::npos)
-            {
-                Tokenizer tokenizer(settings, NULL);
-                line.erase(0, sizeof("#pragma endasm"));
-                std::istringstream tempIstr(line.c_str());
-                tokenizer.tokenize(tempIstr, "");
-                if (Token::Match(tokenizer.tokens(), "( %var% = %any% )"))
-                {
-                    ret << "asm(" << tokenizer.tokens()->strAt(1) << ");";
-                }
-            }
+    /** @brief instruction in the postfix code */
+    struct Op
+    {
+        Op(OpType t, const std::string &s, MathLib::bigint v = 0, bool b = false)
+            : type(t), str(s), value(v), boolContext(b)
+        { }
 
-            ret << "\n";
+        OpType type;
 
-            continue;
-        }
+        /** macro name or operator */
+        std::string str;
 
-        std::string def = getdef(line, true);
-        std::string ndef = getdef(line, false);
+        /** value of number */
+        MathLib::bigint value;
 
-        if (line.compare(0, 8, "#define ") == 0)
+        /** macro is used as a boolean, a macro without value is then true */
+        bool boolContext;
+    };
+
+    /** postfix code */
+    std::vector<Op> _code;
+
+    /** was the condition compiled? */
+    bool _compiled;
+
+    /** condition is "A" */
+    bool _isDefined;
+
+    /** condition is "!A" */
+    bool _isNotDefined;
+
+    static bool isName(const std::string &str)
+    {
+        return (std::isalpha(static_cast<unsigned char>(str[0])) || str[0] == '_') && str != "defined";
+    }
+
+    /** split condition into tokens. returns false if there are unsupported characters */
+    static bool tokenize(const std::string &condition, std::vector<std::string> &tokens)
+    {
+        std::string::size_type pos = 0;
+        while (pos < condition.size())
         {
-            match = true;
-            for (std::list<bool>::const_iterator it = matching_ifdef.begin(); it != matching_ifdef.end(); ++it)
-                match &= bool(*it);
+            const unsigned char ch = static_cast<unsigned char>(condition[pos]);
+            std::string::size_type end = pos + 1;
 
-            if (match)
+            if (std::isspace(ch))
             {
-                std::string::size_type pos = line.find_first_of(" (", 8);
-                if (pos == std::string::npos)
-                    cfgmap[line.substr(8)] = "";
-                else if (line[pos] == ' ')
-                    cfgmap[line.substr(8, pos - 8)] = line.substr(pos + 1);
-                else
-                    cfgmap[line.substr(8, pos - 8)] = "";
+                ++pos;
+                continue;
             }
-        }
-
-        else if (line.find("#elif ") == 0)
-        {
-            if (matched_ifdef.back())
+            else if (std::isalnum(ch) || ch == '_')
             {
-                matching_ifdef.back() = false;
+                while (end < condition.size() && (std::isalnum(static_cast<unsigned char>(condition[end])) || condition[end] == '_'))
+                    ++end;
             }
-            else
+            else if (pos + 1 < condition.size() && precedence(condition.substr(pos, 2)) > 0)
             {
-                if (match_cfg_def(cfgmap, def))
-                {
-                    matching_ifdef.back() = true;
-                    matched_ifdef.back() = true;
-                }
+                end = pos + 2;
+            }
+            else if (ch == '=' || !std::strchr("()!~+-*/%<>&|^", ch))
+            {
+                return false;
             }
-        }
 
-        else if (! def.empty())
-        {
-            matching_ifdef.push_back(match_cfg_def(cfgmap, def));
-            matched_ifdef.push_back(matching_ifdef.back());
+            tokens.push_back(condition.substr(pos, end - pos));
+            pos = end;
         }
+        return true;
+    }
 
-        else if (! ndef.empty())
+    /** precedence of binary operator. 0 => not a binary operator */
+    static unsigned int precedence(const std::string &op)
+    {
+        static const char * const operators[] =
         {
-            matching_ifdef.push_back(! match_cfg_def(cfgmap, ndef));
-            matched_ifdef.push_back(matching_ifdef.back());
-        }
+            "||", "&&", "|", "^", "&", "== !=", "< <= > >=", "<< >>", "+ -", "* / %"
+        };
 
-        else if (line == "#else")
+        for (unsigned int i = 0; i < sizeof(operators) / sizeof(*operators); ++i)
         {
-            if (! matched_ifdef.empty())
-                matching_ifdef.back() = ! matched_ifdef.back();
+            std::istringstream istr(operators[i]);
+            std::string s;
+            while (istr >> s)
+            {
+                if (s == op)
+                    return i + 1;
+            }
         }
+        return 0;
+    }
 
-        else if (line.compare(0, 6, "#endif") == 0)
-        {
-            if (! matched_ifdef.empty())
-                matched_ifdef.pop_back();
-            if (! matching_ifdef.empty())
-                matching_ifdef.pop_back();
-        }
+    /** parse binary operators with at least the given precedence */
+    bool parse(const std::vector<std::string> &tokens, std::vector<std::string>::size_type &pos, unsigned int minPrecedence)
+    {
+        if (!parseUnary(tokens, pos))
+            return false;
 
-        if (!line.empty() && line[0] == '#')
+        while (pos < tokens.size())
         {
-            match = true;
-            for (std::list<bool>::const_iterator it = matching_ifdef.begin(); it != matching_ifdef.end(); ++it)
-                match &= bool(*it);
+            const unsigned int prec = precedence(tokens[pos]);
+            if (prec == 0 || prec < minPrecedence)
+                break;
+            const std::string op(tokens[pos++]);
+            if (!parse(tokens, pos, prec + 1))
+                return false;
+            _code.push_back(Op(Binary, op));
         }
+        return true;
+    }
 
-        // #error => return ""
-        if (match && line.compare(0, 6, "#error") == 0)
+    bool parseUnary(const std::vector<std::string> &tokens, std::vector<std::string>::size_type &pos)
+    {
+        if (pos >= tokens.size())
+            return false;
+
+        const std::string &tok = tokens[pos];
+
+        if (tok == "!" || tok == "~" || tok == "-" || tok == "+")
         {
-            if (settings && !settings->userDefines.empty())
+            ++pos;
+            if (!parseUnary(tokens, pos))
+                return false;
+            if (tok != "+")
+                _code.push_back(Op(Unary, tok));
+            return true;
+        }
+
+        if (tok == "(")
+        {
+            ++pos;
+            if (!parse(tokens, pos, 1) || pos >= tokens.size() || tokens[pos] != ")")
+                return false;
+            ++pos;
+            return true;
+        }
+
+        if (tok == "defined")
+        {
+            if (pos + 1 < tokens.size() && isName(tokens[pos+1]))
             {
-                Settings settings2(*settings);
-                Preprocessor preprocessor(&settings2, errorLogger);
-                preprocessor.error(filename, lineno, line);
+                _code.push_back(Op(Defined, tokens[pos+1]));
+                pos += 2;
+                return true;
             }
-            return "";
+            if (pos + 3 < tokens.size() && tokens[pos+1] == "(" && isName(tokens[pos+2]) && tokens[pos+3] == ")")
+            {
+                _code.push_back(Op(Defined, tokens[pos+2]));
+                pos += 4;
+                return true;
+            }
+            return false;
+        }
+
+        if (std::isdigit(static_cast<unsigned char>(tok[0])))
+        {
+            if (!MathLib::isInt(tok))
+                return false;
+            _code.push_back(Op(Number, tok, MathLib::toLongNumber(tok)));
+            ++pos;
+            return true;
+        }
+
+        if (isName(tok))
+        {
+            // function-like macros are not handled
+            if (pos + 1 < tokens.size() && tokens[pos+1] == "(")
+                return false;
+
+            const std::string prev(pos > 0 ? tokens[pos-1] : "(");
+            const std::string next(pos + 1 < tokens.size() ? tokens[pos+1] : ")");
+            const bool boolContext = (prev == "(" || prev == "&&" || prev == "||") &&
+                                     (next == ")" || next == "&&" || next == "||");
+            _code.push_back(Op(Macro, tok, 0, boolContext));
+            ++pos;
+            return true;
+        }
+
+        return false;
+    }
+
+    /** calculate "value1 op value2". returns false if the result is undefined */
+    static bool calculate(const std::string &op, MathLib::bigint &value1, MathLib::bigint value2)
+    {
+        if ((op == "/" || op == "%") && value2 == 0)
+            return false;
+        if ((op == "/" || op == "%") && value2 == -1 && value1 == std::numeric_limits<MathLib::bigint>::min())
+            return false;
+        if ((op == "<<" || op == ">>") && (value2 < 0 || value2 >= 64))
+            return false;
+
+        if (op == "||")
+            value1 = (value1 || value2);
+        else if (op == "&&")
+            value1 = (value1 && value2);
+        else if (op == "|")
+            value1 |= value2;
+        else if (op == "^")
+            value1 ^= value2;
+        else if (op == "&")
+            value1 &= value2;
+        else if (op == "==")
+            value1 = (value1 == value2);
+        else if (op == "!=")
+            value1 = (value1 != value2);
+        else if (op == "<")
+            value1 = (value1 < value2);
+        else if (op == "<=")
+            value1 = (value1 <= value2);
+        else if (op == ">")
+            value1 = (value1 > value2);
+        else if (op == ">=")
+            value1 = (value1 >= value2);
+        else if (op == "<<")
+            value1 <<= value2;
+        else if (op == ">>")
+            value1 >>= value2;
+        else if (op == "+")
+            value1 += value2;
+        else if (op == "-")
+            value1 -= value2;
+        else if (op == "*")
+            value1 *= value2;
+        else if (op == "/")
+            value1 /= value2;
+        else if (op == "%")
+            value1 %= value2;
+        return true;
+    }
+};
+
+/**
+ * Evaluate condition. The compiled code is used if possible, otherwise
+ * the condition is simplified with Preprocessor::simplifyCondition.
+ */
+static bool matchCondition(const PreprocessorCondition &condition, const std::map<std::string, std::string> &cfg, std::string def)
+{
+    bool result = false;
+    if (condition.evaluate(cfg, result))
+        return result;
+
+    Preprocessor::simplifyCondition(cfg, def, true);
+
+    if (cfg.find(def) != cfg.end())
+        return true;
+
+    if (def == "0")
+        return false;
+
+    if (def == "1")
+        return true;
+
+    return false;
+}
+
+bool Preprocessor::match_cfg_def(const std::map<std::string, std::string> &cfg, std::string def)
+{
+    return matchCondition(PreprocessorCondition(def), cfg, def);
+}
+
+
+DirectiveTree::DirectiveTree(const std::string &filedata, const Settings *settings, const SourceLocations &locations)
+    : _code(filedata), _locations(locations)
+{
+    // open #if blocks. index of the last #if / #elif / #else node
+    std::vector<unsigned int> branches;
+
+    unsigned int linenr = 0;
+    std::string::size_type pos = 0;
+    while (pos < _code.size())
+    {
+        std::string::size_type end = _code.find('\n', pos);
+        if (end == std::string::npos)
+            end = _code.size();
+
+        ++linenr;
+
+        Node node;
+        node.type = Directive;
+        node.pos = pos;
+        node.len = end - pos;
+        node.lines = 1;
+        node.linenr = linenr;
+        node.next = 0;
+        node.condition = 0;
+        node.endasm = true;
+
+        // code line => append to the text node
+        if (_code[pos] != '#')
+        {
+            if (!_nodes.empty() && _nodes.back().type == Text)
+            {
+                _nodes.back().len = end - _nodes.back().pos;
+                ++_nodes.back().lines;
+            }
+            else
+            {
+                node.type = Text;
+                _nodes.push_back(node);
+            }
+            pos = end + 1;
+            continue;
         }
 
-        if (!match && line.compare(0, 8, "#define ") == 0)
+        const std::string line(_code, pos, end - pos);
+        pos = end + 1;
+
+        if (line.compare(0, 11, "#pragma asm") == 0)
         {
-            // Remove define that is not part of this configuration
-            line = "";
+            node.type = Asm;
+            node.endasm = false;
+            node.str = "\n";
+            std::string endline;
+            while (pos < _code.size())
+            {
+                end = _code.find('\n', pos);
+                if (end == std::string::npos)
+                    end = _code.size();
+                endline = _code.substr(pos, end - pos);
+                pos = end + 1;
+                if (endline.compare(0, 14, "#pragma endasm") == 0)
+                {
+                    node.endasm = true;
+                    break;
+                }
+                node.str += "\n";
+            }
+
+            if (node.endasm)
+            {
+                if (endline.find("=") != std::string::npos)
+                {
+                    Tokenizer tokenizer(settings, NULL);
+                    endline.erase(0, sizeof("#pragma endasm"));
+                    std::istringstream tempIstr(endline.c_str());
+                    tokenizer.tokenize(tempIstr, "");
+                    if (Token::Match(tokenizer.tokens(), "( %var% = %any% )"))
+                        node.str += "asm(" + tokenizer.tokens()->strAt(1) + ");";
+                }
+                node.str += "\n";
+            }
+
+            _nodes.push_back(node);
+            if (!node.endasm)
+                break;
+            continue;
+        }
+
+        const std::string def = Preprocessor::getdef(line, true);
+        const std::string ndef = Preprocessor::getdef(line, false);
+
+        if (line.compare(0, 8, "#define ") == 0)
+        {
+            node.type = Define;
+            const std::string::size_type pos2 = line.find_first_of(" (", 8);
+            if (pos2 == std::string::npos)
+                node.str = line.substr(8);
+            else if (line[pos2] == ' ')
+            {
+                node.str = line.substr(8, pos2 - 8);
+                node.value = line.substr(pos2 + 1);
+            }
+            else
+                node.str = line.substr(8, pos2 - 8);
+        }
+        else if (line.find("#elif ") == 0)
+        {
+            node.type = Elif;
+            node.str = def;
         }
-        else if (line.compare(0, 7, "#file \"") == 0 ||
-                 line.compare(0, 8, "#endfile") == 0 ||
-                 line.compare(0, 8, "#define ") == 0 ||
-                 line.compare(0, 6, "#undef") == 0)
+        else if (!def.empty())
         {
-            // We must not remove #file tags or line numbers
-            // are corrupted. File tags are removed by the tokenizer.
+            node.type = If;
+            node.str = def;
         }
-        else if (!match || line.compare(0, 1, "#") == 0)
+        else if (!ndef.empty())
         {
-            // Remove #if, #else, #pragma etc, leaving only
-            // #define, #undef, #file and #endfile. and also lines
-            // which are not part of this configuration.
-            line = "";
+            node.type = Ifndef;
+            node.str = ndef;
         }
+        else if (line == "#else")
+            node.type = Else;
+        else if (line.compare(0, 6, "#endif") == 0)
+            node.type = Endif;
+        else if (line.compare(0, 6, "#error") == 0)
+            node.type = Error;
+        else if (line.compare(0, 6, "#undef") == 0)
+            node.type = Keep;
 
-        ret << line << "\n";
+        if (node.type == If || node.type == Ifndef || node.type == Elif)
+        {
+            std::map<std::string, PreprocessorCondition *>::const_iterator it = _conditions.find(node.str);
+            if (it == _conditions.end())
+                it = _conditions.insert(std::make_pair(node.str, new PreprocessorCondition(node.str))).first;
+            node.condition = it->second;
+        }
+
+        // link the branches of #if blocks
+        const unsigned int index = static_cast<unsigned int>(_nodes.size());
+        if (node.type == If || node.type == Ifndef)
+            branches.push_back(index);
+        else if ((node.type == Elif || node.type == Else || node.type == Endif) && !branches.empty())
+        {
+            _nodes[branches.back()].next = index;
+            if (node.type == Endif)
+                branches.pop_back();
+            else
+                branches.back() = index;
+        }
+
+        _nodes.push_back(node);
+    }
+
+    // blocks without #endif
+    for (std::vector<unsigned int>::const_iterator it = branches.begin(); it != branches.end(); ++it)
+        _nodes[*it].next = static_cast<unsigned int>(_nodes.size());
+}
+
+DirectiveTree::~DirectiveTree()
+{
+    for (std::map<std::string, PreprocessorCondition *>::iterator it = _conditions.begin(); it != _conditions.end(); ++it)
+        delete it->second;
+}
+
+std::string Preprocessor::getcode(const std::string &filedata, std::string cfg, const std::string &filename, const Settings *settings, ErrorLogger *errorLogger)
+{
+    const DirectiveTree directives(filedata, settings);
+    return getcode(directives, cfg, filename, settings, errorLogger);
+}
+
+Preprocessor::Configuration::Configuration(const std::string &cfg)
+    : name(cfg)
+{
+    std::string::size_type pos = 0;
+    for (;;)
+    {
+        std::string::size_type pos2 = cfg.find_first_of(";=", pos);
+        if (pos2 == std::string::npos)
+        {
+            defines[cfg.substr(pos)] = "";
+            break;
+        }
+        if (cfg[pos2] == ';')
+        {
+            defines[cfg.substr(pos, pos2-pos)] = "";
+        }
+        else
+        {
+            std::string::size_type pos3 = pos2;
+            pos2 = cfg.find(";", pos2);
+            if (pos2 == std::string::npos)
+            {
+                defines[cfg.substr(pos, pos3-pos)] = cfg.substr(pos3 + 1);
+                break;
+            }
+            else
+            {
+                defines[cfg.substr(pos, pos3-pos)] = cfg.substr(pos3 + 1, pos2 - pos3 - 1);
+            }
+        }
+        pos = pos2 + 1;
+    }
+}
+
+std::string Preprocessor::getcode(const DirectiveTree &directives, const std::string &cfg, const std::string &filename, const Settings *settings, ErrorLogger *errorLogger)
+{
+    return getcode(directives, Configuration(cfg), filename, settings, errorLogger);
+}
+
+std::string Preprocessor::getcode(const DirectiveTree &directives, const Configuration &cfg, const std::string &filename, const Settings *settings, ErrorLogger *errorLogger)
+{
+    std::string ret;
+    ret.reserve(directives._code.size() + 1);
+
+    bool match = true;
+    std::vector<bool> matching_ifdef;
+    std::vector<bool> matched_ifdef;
+
+    // The defines in the code are added to a copy of the configuration
+    std::map<std::string, std::string> cfgmap(cfg.defines);
+
+    const std::vector<DirectiveTree::Node> &nodes = directives._nodes;
+    for (unsigned int i = 0; i < nodes.size(); ++i)
+    {
+        const DirectiveTree::Node &node = nodes[i];
+
+        switch (node.type)
+        {
+        case DirectiveTree::Text:
+            if (match)
+            {
+                ret.append(directives._code, node.pos, node.len);
+                ret += '\n';
+            }
+            else
+                ret.append(node.lines, '\n');
+            continue;
+
+        case DirectiveTree::Asm:
+            ret += node.str;
+            if (!node.endasm)
+                i = static_cast<unsigned int>(nodes.size());
+            continue;
+
+        case DirectiveTree::Define:
+            if (match)
+                cfgmap[node.str] = node.value;
+            break;
+
+        case DirectiveTree::If:
+        case DirectiveTree::Ifndef:
+            matching_ifdef.push_back(matchCondition(*node.condition, cfgmap, node.str) == (node.type == DirectiveTree::If));
+            matched_ifdef.push_back(matching_ifdef.back());
+            break;
+
+        case DirectiveTree::Elif:
+            if (matched_ifdef.empty())
+                break;
+            if (matched_ifdef.back())
+                matching_ifdef.back() = false;
+            else if (matchCondition(*node.condition, cfgmap, node.str))
+            {
+                matching_ifdef.back() = true;
+                matched_ifdef.back() = true;
+            }
+            break;
+
+        case DirectiveTree::Else:
+            if (! matched_ifdef.empty())
+                matching_ifdef.back() = ! matched_ifdef.back();
+            break;
+
+        case DirectiveTree::Endif:
+            if (! matched_ifdef.empty())
+                matched_ifdef.pop_back();
+            if (! matching_ifdef.empty())
+                matching_ifdef.pop_back();
+            break;
+
+        case DirectiveTree::Error:
+        case DirectiveTree::Keep:
+        case DirectiveTree::Directive:
+            break;
+        };
+
+        match = (std::find(matching_ifdef.begin(), matching_ifdef.end(), false) == matching_ifdef.end());
+
+        // #error => return ""
+        if (match && node.type == DirectiveTree::Error)
+        {
+            if (settings && !settings->userDefines.empty())
+            {
+                unsigned int linenr = node.linenr;
+                const std::string file(getLocation(directives._locations, filename, linenr));
+
+                Settings settings2(*settings);
+                Preprocessor preprocessor(&settings2, errorLogger);
+                preprocessor.error(file, linenr, directives._code.substr(node.pos, node.len));
+            }
+            return "";
+        }
+
+        // The lines are kept so the line numbers are not corrupted
+        if (node.type == DirectiveTree::Keep || (match && node.type == DirectiveTree::Define))
+            ret.append(directives._code, node.pos, node.len);
+        ret += '\n';
+
+        // Skip the block if it is not part of this configuration. Only the
+        // line numbers and #undef are kept.
+        if (!match && node.next > i)
+        {
+            for (++i; i < node.next; ++i)
+            {
+                const DirectiveTree::Node &skipped = nodes[i];
+                if (skipped.type == DirectiveTree::Asm)
+                {
+                    ret += skipped.str;
+                    if (!skipped.endasm)
+                    {
+                        i = static_cast<unsigned int>(nodes.size());
+                        break;
+                    }
+                    continue;
+                }
+                if (skipped.type == DirectiveTree::Keep)
+                    ret.append(directives._code, skipped.pos, skipped.len);
+                ret.append(skipped.lines, '\n');
+            }
+            --i;
+        }
     }
 
-    return expandMacros(ret.str(), filename, errorLogger);
+    return expandMacros(ret, filename, errorLogger, directives._locations);
 }
 
 void Preprocessor::error(const std::string &filename, unsigned int linenr, const std::string &msg)
@@ -1490,12 +2055,102 @@ static int tolowerWrapper(int c)
 }
 
 
+std::string Preprocessor::getIncludeGuard(const std::string &code)
+{
+    std::string guard;
+    bool define = false;
+    int level = 0;
+    std::string::size_type pos = 0;
+    while (pos < code.size())
+    {
+        std::string::size_type end = code.find('\n', pos);
+        if (end == std::string::npos)
+            end = code.size();
+        const std::string line(code, pos, end - pos);
+        pos = end + 1;
+
+        if (line.empty())
+            continue;
+
+        if (level == 0 && line == "#pragma once")
+            return line;
+
+        // the guard block must start at the first line with code
+        if (guard.empty())
+        {
+            if (line.compare(0, 8, "#ifndef ") == 0)
+                guard = line.substr(8);
+            else if (line.compare(0, 13, "#if !defined(") == 0 && line[line.size()-1] == ')')
+                guard = line.substr(13, line.size() - 14);
+            else
+                return "";
+            define = true;
+            level = 1;
+            continue;
+        }
+
+        // the guard macro must be defined in the next line
+        if (define)
+        {
+            if (line != "#define " + guard && line.compare(0, 9 + guard.size(), "#define " + guard + " ") != 0)
+                return "";
+            define = false;
+            continue;
+        }
+
+        // there must not be code after the guard block
+        if (level == 0)
+            return "";
+
+        if (line.compare(0, 3, "#if") == 0)
+            ++level;
+        else if (line.compare(0, 6, "#endif") == 0)
+            --level;
+        else if (level == 1 && (line.compare(0, 5, "#else") == 0 || line.compare(0, 5, "#elif") == 0))
+            return "";
+    }
+
+    return (level == 0) ? guard : "";
+}
+
 void Preprocessor::handleIncludes(std::string &code,
                                   const std::string &filePath,
                                   const std::list<std::string> &includePaths,
                                   std::set<std::string> &systemIncludes,
-                                  std::set<std::string> handledFiles)
+                                  std::set<std::string> &handledFiles,
+                                  SourceLocations &locations,
+                                  bool unconditional)
 {
+    // Macros that are undefined can't be used as include guards
+    for (std::string::size_type pos = code.find("#undef "); pos != std::string::npos; pos = code.find("#undef ", pos + 7))
+    {
+        if (pos == 0 || code[pos-1] == '\n')
+            _undefinedMacros.insert(code.substr(pos + 7, code.find_first_of(" \n", pos + 7) - pos - 7));
+    }
+
+    // Remember the include guard of a header that is included unconditionally
+    const std::string guard(getIncludeGuard(code));
+    if (unconditional && !guard.empty())
+    {
+        std::string tempFile = Path::simplifyPath(filePath.c_str());
+        std::transform(tempFile.begin(), tempFile.end(), tempFile.begin(), tolowerWrapper);
+        _includeGuards[tempFile] = guard;
+    }
+
+    // #if level. The include guard block is level 0.
+    int level = (guard.empty() || guard == "#pragma once") ? 0 : -1;
+
+    // Line number in this file at linepos. The included code is skipped.
+    unsigned int linenr = 1;
+    std::string::size_type linepos = 0;
+
+    // Number of lines of included code before linepos
+    unsigned int includedLines = 0;
+    locations.add(1, filePath, 1);
+
+    // The files that this call adds to handledFiles
+    std::vector<std::string> handled;
+
     std::string::size_type pos = 0;
     while ((pos = code.find("#include", pos)) != std::string::npos)
     {
@@ -1506,6 +2161,17 @@ void Preprocessor::handleIncludes(std::string &code,
             continue;
         }
 
+        // Read the lines before the #include
+        while (linepos < pos)
+        {
+            if (code.compare(linepos, 3, "#if") == 0)
+                ++level;
+            else if (code.compare(linepos, 6, "#endif") == 0)
+                --level;
+            linepos = code.find('\n', linepos) + 1;
+            ++linenr;
+        }
+
         std::string::size_type end = code.find("\n", pos);
         std::string filename = code.substr(pos, end - pos);
 
@@ -1516,10 +2182,34 @@ void Preprocessor::handleIncludes(std::string &code,
         if (headerType == NoHeader)
             continue;
 
+        // Has the file been found before? Then it's not opened if it's guarded.
+        const std::string includeKey = filename + (headerType == UserHeader ? "\n" + filePath.substr(0, filePath.find_last_of("\\/") + 1) : "");
+        const std::map<std::string, std::string>::const_iterator includeFile = _includeFiles.find(includeKey);
+        if (includeFile != _includeFiles.end())
+        {
+            std::string tempFile = Path::simplifyPath(includeFile->second.c_str());
+            std::transform(tempFile.begin(), tempFile.end(), tempFile.begin(), tolowerWrapper);
+            const std::map<std::string, std::string>::const_iterator it = _includeGuards.find(tempFile);
+            if (it != _includeGuards.end() && _undefinedMacros.find(it->second) == _undefinedMacros.end())
+                continue;
+        }
+
         // filename contains now a file name e.g. "menu.h"
         std::string processedFile;
         bool fileOpened = false;
         std::ifstream fin;
+        if (includeFile != _includeFiles.end())
+        {
+            fin.open(includeFile->second.c_str());
+            if (fin.is_open())
+            {
+                filename = includeFile->second;
+                fileOpened = true;
+            }
+            fin.clear();
+        }
+
+        if (!fileOpened)
         {
             std::list<std::string> includePaths2(includePaths);
             includePaths2.push_front("");
@@ -1555,11 +2245,14 @@ void Preprocessor::handleIncludes(std::string &code,
 
         if (fileOpened)
         {
+            _includeFiles[includeKey] = filename;
             filename = Path::simplifyPath(filename.c_str());
             std::string tempFile = filename;
             std::transform(tempFile.begin(), tempFile.end(), tempFile.begin(), tolowerWrapper);
+            const std::map<std::string, std::string>::const_iterator it = _includeGuards.find(tempFile);
             if (handledFiles.find(tempFile) != handledFiles.end() ||
-                (headerType == SystemHeader && systemIncludes.find(tempFile) != systemIncludes.end()))
+                (headerType == SystemHeader && systemIncludes.find(tempFile) != systemIncludes.end()) ||
+                (it != _includeGuards.end() && _undefinedMacros.find(it->second) == _undefinedMacros.end()))
             {
                 // We have processed this file already once, skip
                 // it this time to avoid eternal loop.
@@ -1569,8 +2262,8 @@ void Preprocessor::handleIncludes(std::string &code,
 
             if (headerType == SystemHeader)
                 systemIncludes.insert(tempFile);
-            else
-                handledFiles.insert(tempFile);
+            else if (handledFiles.insert(tempFile).second)
+                handled.push_back(tempFile);
             processedFile = Preprocessor::read(fin, filename, _settings);
             fin.close();
         }
@@ -1586,10 +2279,22 @@ void Preprocessor::handleIncludes(std::string &code,
 
             // Remove space characters that are after or before new line character
             processedFile = removeSpaceNearNL(processedFile);
-            handleIncludes(processedFile, filename, includePaths, systemIncludes, handledFiles);
-            processedFile = "#file \"" + filename + "\"\n" + processedFile + "\n#endfile";
-            code.insert(pos, processedFile);
-            pos += processedFile.size();
+            SourceLocations includedLocations;
+            handleIncludes(processedFile, filename, includePaths, systemIncludes, handledFiles, includedLocations, unconditional && level == 0);
+            if (processedFile.empty() || processedFile[processedFile.size() - 1] != '\n')
+                processedFile += '\n';
+
+            // Insert the code after the line of the #include
+            if (pos == code.size())
+                code += '\n';
+            code.insert(pos + 1, processedFile);
+            pos += 1 + processedFile.size();
+            linepos = pos;
+
+            locations.add(linenr + includedLines + 1, includedLocations);
+            includedLines += static_cast<unsigned int>(std::count(processedFile.begin(), processedFile.end(), '\n'));
+            ++linenr;
+            locations.add(linenr + includedLines, filePath, linenr);
         }
         else if (!fileOpened)
         {
@@ -1601,27 +2306,6 @@ void Preprocessor::handleIncludes(std::string &code,
             if (_errorLogger && _settings && _settings->isEnabled("missingInclude"))
 #endif
             {
-                // Determine line number of include
-                unsigned int linenr = 1;
-                unsigned int level = 0;
-                for (std::string::size_type p = 1; p <= pos; ++p)
-                {
-                    if (level == 0 && code[pos-p] == '\n')
-                        ++linenr;
-                    else if (code.compare(pos-p, 9, "#endfile\n") == 0)
-                    {
-                        ++level;
-                    }
-                    else if (code.compare(pos-p, 6, "#file ") == 0)
-                    {
-                        if (level == 0)
-                        {
-                            break;
-                        }
-                        --level;
-                    }
-                }
-
                 missingInclude(Path::toNativeSeparators(filePath),
                                linenr,
                                filename,
@@ -1629,6 +2313,9 @@ void Preprocessor::handleIncludes(std::string &code,
             }
         }
     }
+
+    for (std::vector<std::string>::const_iterator it = handled.begin(); it != handled.end(); ++it)
+        handledFiles.erase(*it);
 }
 
 // Report that include is missing
@@ -1766,14 +2453,88 @@ static void getparams(const std::string &line,
     }
 }
 
-/** @brief Class that the preprocessor uses when it expands macros. This class represents a preprocessor macro */
+class PreprocessorMacro;
+
+/**
+ * @brief Hash table with the macros that are defined when macros are
+ * expanded. A macro can be looked up with a name in the code so no string
+ * needs to be created for each identifier. The table does not own the macros.
+ */
+class MacroTable
+{
+public:
+    MacroTable() : _buckets(64), _size(0)
+    { }
+
+    /**
+     * @brief Find macro
+     * @param name start of the macro name
+     * @param length length of the macro name
+     * @return the macro or 0 if there is no macro with the given name
+     */
+    PreprocessorMacro *find(const char name[], std::string::size_type length) const;
+
+    /** @brief Find macro, returns 0 if there is no macro with the given name */
+    PreprocessorMacro *find(const std::string &name) const
+    {
+        return find(name.c_str(), name.size());
+    }
+
+    /**
+     * @brief Add macro
+     * @param macro the macro
+     * @return the macro with the same name that is replaced, or 0
+     */
+    PreprocessorMacro *insert(PreprocessorMacro *macro);
+
+    /**
+     * @brief Remove macro
+     * @param name name of the macro
+     * @return the removed macro, or 0 if there is no macro with the given name
+     */
+    PreprocessorMacro *erase(const std::string &name);
+
+    /** @brief Delete all macros in the table */
+    void deleteMacros();
+
+private:
+    static unsigned int hash(const char name[], std::string::size_type length);
+
+    std::vector<std::vector<PreprocessorMacro *> > _buckets;
+
+    /** number of macros in the table */
+    unsigned int _size;
+};
+
+/**
+ * @brief Class that the preprocessor uses when it expands macros. This class represents a preprocessor macro.
+ * The macro definition is parsed the first time the macro is used, most macros in headers are never used.
+ * Expanding a parsed macro doesn't need to parse the definition again.
+ */
 class PreprocessorMacro
 {
 private:
-    Settings settings;
+    /** @brief Token in the replacement list of a macro with parameters */
+    struct ReplacementToken
+    {
+        /** token. The '#' of a "#x" is removed */
+        std::string str;
+
+        /** index of the parameter, -1 if the token is not a parameter */
+        int param;
+
+        /** is the token a name or a "#x". It can be a parameter or a macro */
+        bool name;
+
+        /** "#x" => stringify parameter */
+        bool stringify;
 
-    /** tokens of this macro */
-    Tokenizer tokenizer;
+        /** ", ##" in a variadic macro. The comma is removed if there are no variadic parameters */
+        bool optcomma;
+
+        /** add a space after the token */
+        bool space;
+    };
 
     /** macro parameters */
     std::vector<std::string> _params;
@@ -1787,43 +2548,173 @@ private:
     /** does this macro take a variable number of parameters? */
     bool _variadic;
 
-    /** prefix that is used by cppcheck to separate macro parameters. Always "__cppcheck__" */
-    const std::string _prefix;
-
     /** The macro has parentheses but no parameters.. "AAA()" */
     bool _nopar;
 
+    /** has the macro definition been parsed, see parse() */
+    bool _parsed;
+
+    /** does the macro definition contain a '(' */
+    bool _parentheses;
+
+    /** code of a macro that has no parameters. In a variadic macro the __VA_ARGS__ is replaced when it's expanded */
+    std::string _code;
+
+    /** code that is used when this macro is used in the code of a macro with parameters */
+    std::string _innerCode;
+
+    /** replacement list of a macro with parameters */
+    std::vector<ReplacementToken> _replacement;
+
+    /** name of inner macro, when the code is "A(x,y) B(x,y)" */
+    std::string _innerMacroName;
+
+    /** number of parameters given to the inner macro */
+    unsigned int _innerMacroParams;
+
     /** disabled assignment operator */
     void operator=(const PreprocessorMacro &);
 
-    /** @brief expand inner macro */
-    std::vector<std::string> expandInnerMacros(const std::vector<std::string> &params1,
-            const std::map<std::string, PreprocessorMacro *> &macros) const
+    /** @brief parse the tokens of the macro definition: parameters, code and replacement list */
+    void parseTokens(const Token *tokens)
     {
-        std::string innerMacroName;
+        // macro name..
+        if (tokens && tokens->isName())
+            _name = tokens->str();
+
+        std::string::size_type pos = _macro.find_first_of(" (");
+        if (pos != std::string::npos && _macro[pos] == '(')
+        {
+            // Extract macro parameters
+            if (Token::Match(tokens, "%var% ( %var%"))
+            {
+                for (const Token *tok = tokens->tokAt(2); tok; tok = tok->next())
+                {
+                    if (tok->str() == ")")
+                        break;
+                    if (Token::simpleMatch(tok, ". . . )"))
+                    {
+                        if (tok->previous()->str() == ",")
+                            _params.push_back("__VA_ARGS__");
+                        _variadic = true;
+                        break;
+                    }
+                    if (tok->isName())
+                        _params.push_back(tok->str());
+                }
+            }
+
+            else if (Token::Match(tokens, "%var% ( . . . )"))
+                _variadic = true;
+
+            else if (Token::Match(tokens, "%var% ( )"))
+                _nopar = true;
+        }
+
+        if (_nopar || (_params.empty() && _variadic))
+        {
+            _code = _macro.substr(1 + _macro.find(")"));
+
+            // Remove leading spaces
+            if ((pos = _code.find_first_not_of(" ")) > 0)
+                _code.erase(0, pos);
+            // Remove ending newline
+            if ((pos = _code.find_first_of("\r\n")) != std::string::npos)
+                _code.erase(pos);
+        }
+
+        else if (_params.empty())
+        {
+            setCode();
+        }
 
-        // Is there an inner macro..
+        else
         {
-            const Token *tok = Token::findmatch(tokens(), ")");
-            if (!Token::Match(tok, ") %var% ("))
-                return params1;
-            innerMacroName = tok->strAt(1);
-            tok = tok->tokAt(3);
-            unsigned int par = 0;
-            while (Token::Match(tok, "%var% ,|)"))
+            // Is there an inner macro..
+            const Token *tok = Token::findmatch(tokens, ")");
+            if (Token::Match(tok, ") %var% ("))
+            {
+                const std::string innerMacroName(tok->strAt(1));
+                unsigned int par = 0;
+                for (tok = tok->tokAt(3); Token::Match(tok, "%var% ,|)"); tok = tok->tokAt(2))
+                    par++;
+                if (!tok)
+                {
+                    _innerMacroName = innerMacroName;
+                    _innerMacroParams = par;
+                }
+            }
+
+            // The replacement list is the tokens after the parameters
+            tok = tokens;
+            while (tok && tok->str() != ")")
+                tok = tok->next();
+            for (tok = tok ? tok->next() : 0; tok; tok = tok->next())
             {
-                tok = tok->tokAt(2);
-                par++;
+                if (tok->str() == "##")
+                    continue;
+
+                ReplacementToken rtok;
+                rtok.str = tok->str();
+                rtok.param = -1;
+                rtok.name = (rtok.str[0] == '#' || tok->isName());
+                rtok.stringify = (rtok.str[0] == '#');
+                if (rtok.stringify)
+                    rtok.str.erase(0, 1);
+                if (rtok.name)
+                {
+                    for (unsigned int i = 0; i < _params.size(); ++i)
+                    {
+                        if (rtok.str == _params[i])
+                        {
+                            rtok.param = (int)i;
+                            break;
+                        }
+                    }
+                }
+                rtok.optcomma = (_variadic && tok->str() == "," && tok->next() && tok->next()->str() == "##");
+                // Same as Token::Match(tok, "%var% %var%|%num%") etc, but faster
+                const Token * const next = tok->next();
+                rtok.space = (next &&
+                              ((tok->isName() && (next->isName() || next->isNumber())) ||
+                               (tok->isNumber() && next->isName()) ||
+                               (tok->str() == ">" && next->str() == ">")));
+                _replacement.push_back(rtok);
             }
-            if (tok || par != params1.size())
-                return params1;
         }
+    }
+
+    /** @brief set the code of a macro without parentheses, "A 123" => "123" */
+    void setCode()
+    {
+        std::string::size_type pos = _macro.find(" ");
+        if (pos != std::string::npos)
+        {
+            _code = _macro.substr(pos + 1);
+            if ((pos = _code.find_first_of("\r\n")) != std::string::npos)
+                _code.erase(pos);
+        }
+    }
+
+    /**
+     * @brief expand inner macro
+     * @param params1 the parameters
+     * @param macros macro definitions
+     * @param params2 the parameters with the expanded inner macro are written here
+     * @return false if there is no inner macro to expand
+     */
+    bool expandInnerMacros(const std::vector<std::string> &params1,
+                           const MacroTable &macros,
+                           std::vector<std::string> &params2) const
+    {
+        if (_innerMacroName.empty() || _innerMacroParams != params1.size())
+            return false;
 
-        std::vector<std::string> params2(params1);
+        params2 = params1;
 
         for (unsigned int ipar = 0; ipar < params1.size(); ++ipar)
         {
-            const std::string s(innerMacroName + "(");
+            const std::string s(_innerMacroName + "(");
             std::string param(params1[ipar]);
             if (param.compare(0,s.length(),s)==0 && param[param.length()-1]==')')
             {
@@ -1835,15 +2726,14 @@ private:
                 if (pos == param.length()-1 && num==0 && endFound && innerparams.size() == params1.size())
                 {
                     // Is inner macro defined?
-                    std::map<std::string, PreprocessorMacro *>::const_iterator it = macros.find(innerMacroName);
-                    if (it != macros.end())
+                    PreprocessorMacro *innerMacro = macros.find(_innerMacroName);
+                    if (innerMacro)
                     {
                         // expand the inner macro
-                        const PreprocessorMacro *innerMacro = it->second;
-
+                        innerMacro->parse();
                         std::string innercode;
-                        std::map<std::string,PreprocessorMacro *> innermacros = macros;
-                        innermacros.erase(innerMacroName);
+                        MacroTable innermacros(macros);
+                        innermacros.erase(_innerMacroName);
                         innerMacro->code(innerparams, innermacros, innercode);
                         params2[ipar] = innercode;
                     }
@@ -1851,7 +2741,7 @@ private:
             }
         }
 
-        return params2;
+        return true;
     }
 
 public:
@@ -1862,55 +2752,44 @@ public:
      * e.g. "A(x) foo(x);"
      */
     PreprocessorMacro(const std::string &macro)
-        : _macro(macro), _prefix("__cppcheck__")
+        : _macro(macro), _variadic(false), _nopar(false), _parsed(false), _innerMacroParams(0)
     {
-        tokenizer.setSettings(&settings);
-
-        // Tokenize the macro to make it easier to handle
-        std::istringstream istr(macro.c_str());
-        tokenizer.createTokens(istr);
-
-        // macro name..
-        if (tokens() && tokens()->isName())
-            _name = tokens()->str();
+        _parentheses = (macro.find("(") != std::string::npos);
+        if (!_parentheses)
+            _innerCode = macro.substr(std::min(macro.find(" "), macro.size()));
+
+        // Get the name, "A 123" or "A(x) x". Parse other macros now
+        const std::string::size_type pos = macro.find_first_of(" (");
+        std::string::size_type end = 0;
+        while (end < macro.size() && (std::isalnum(static_cast<unsigned char>(macro[end])) || macro[end] == '_'))
+            ++end;
+        if (end > 0 && !std::isdigit(static_cast<unsigned char>(macro[0])) && end == std::min(pos, macro.size()))
+            _name = macro.substr(0, end);
+        else
+            parse();
+    }
 
-        // initialize parameters to default values
-        _variadic = _nopar = false;
+    /** @brief Parse the macro definition. This must be called before the macro is used. */
+    void parse()
+    {
+        if (_parsed)
+            return;
+        _parsed = true;
 
-        std::string::size_type pos = macro.find_first_of(" (");
-        if (pos != std::string::npos && macro[pos] == '(')
+        // A macro without parentheses, "A 123"
+        const std::string::size_type pos = _macro.find_first_of(" (");
+        if (!_name.empty() && (pos == std::string::npos || _macro[pos] == ' '))
         {
-            // Extract macro parameters
-            if (Token::Match(tokens(), "%var% ( %var%"))
-            {
-                for (const Token *tok = tokens()->tokAt(2); tok; tok = tok->next())
-                {
-                    if (tok->str() == ")")
-                        break;
-                    if (Token::simpleMatch(tok, ". . . )"))
-                    {
-                        if (tok->previous()->str() == ",")
-                            _params.push_back("__VA_ARGS__");
-                        _variadic = true;
-                        break;
-                    }
-                    if (tok->isName())
-                        _params.push_back(tok->str());
-                }
-            }
-
-            else if (Token::Match(tokens(), "%var% ( . . . )"))
-                _variadic = true;
-
-            else if (Token::Match(tokens(), "%var% ( )"))
-                _nopar = true;
+            setCode();
+            return;
         }
-    }
 
-    /** return tokens of this macro */
-    const Token *tokens() const
-    {
-        return tokenizer.tokens();
+        // Tokenize the macro to make it easier to handle
+        Settings settings;
+        Tokenizer tokenizer(&settings, 0);
+        std::istringstream istr(_macro.c_str());
+        tokenizer.createTokens(istr);
+        parseTokens(tokenizer.tokens());
     }
 
     /** read parameters of this macro */
@@ -1944,24 +2823,14 @@ public:
      * @param macrocode output string
      * @return true if the expanding was successful
      */
-    bool code(const std::vector<std::string> &params2, const std::map<std::string, PreprocessorMacro *> &macros, std::string &macrocode) const
+    bool code(const std::vector<std::string> &params2, const MacroTable &macros, std::string &macrocode) const
     {
         if (_nopar || (_params.empty() && _variadic))
         {
-            macrocode = _macro.substr(1 + _macro.find(")"));
-            if (macrocode.empty())
-                return true;
-
-            std::string::size_type pos = 0;
-            // Remove leading spaces
-            if ((pos = macrocode.find_first_not_of(" ")) > 0)
-                macrocode.erase(0, pos);
-            // Remove ending newline
-            if ((pos = macrocode.find_first_of("\r\n")) != std::string::npos)
-                macrocode.erase(pos);
+            macrocode = _code;
 
             // Replace "__VA_ARGS__" with parameters
-            if (!_nopar)
+            if (!_nopar && !macrocode.empty())
             {
                 std::string s;
                 for (unsigned int i = 0; i < params2.size(); ++i)
@@ -1971,7 +2840,7 @@ public:
                     s += params2[i];
                 }
 
-                pos = 0;
+                std::string::size_type pos = 0;
                 while ((pos = macrocode.find("__VA_ARGS__", pos)) != std::string::npos)
                 {
                     macrocode.erase(pos, 11);
@@ -1983,106 +2852,81 @@ public:
 
         else if (_params.empty())
         {
-            std::string::size_type pos = _macro.find(" ");
-            if (pos == std::string::npos)
-                macrocode = "";
-            else
-            {
-                macrocode = _macro.substr(pos + 1);
-                if ((pos = macrocode.find_first_of("\r\n")) != std::string::npos)
-                    macrocode.erase(pos);
-            }
+            macrocode = _code;
         }
 
         else
         {
-            const std::vector<std::string> givenparams = expandInnerMacros(params2, macros);
+            std::vector<std::string> innerparams;
+            const std::vector<std::string> &givenparams = expandInnerMacros(params2, macros, innerparams) ? innerparams : params2;
 
-            const Token *tok = tokens();
-            while (tok && tok->str() != ")")
-                tok = tok->next();
-            if (tok)
+            bool optcomma = false;
+            for (std::vector<ReplacementToken>::const_iterator tok = _replacement.begin(); tok != _replacement.end(); ++tok)
             {
-                bool optcomma = false;
-                while ((tok = tok->next()) != NULL)
+                if (tok->optcomma)
                 {
-                    std::string str = tok->str();
-                    if (str == "##")
-                        continue;
-                    if (str[0] == '#' || tok->isName())
-                    {
-                        const bool stringify(str[0] == '#');
-                        if (stringify)
-                        {
-                            str = str.erase(0, 1);
-                        }
-                        for (unsigned int i = 0; i < _params.size(); ++i)
-                        {
-                            if (str == _params[i])
-                            {
-                                if (_variadic &&
-                                    (i == _params.size() - 1 ||
-                                     (givenparams.size() + 2 == _params.size() && i + 1 == _params.size() - 1)))
-                                {
-                                    str = "";
-                                    for (unsigned int j = (unsigned int)_params.size() - 1; j < givenparams.size(); ++j)
-                                    {
-                                        if (optcomma || j > _params.size() - 1)
-                                            str += ",";
-                                        optcomma = false;
-                                        str += givenparams[j];
-                                    }
-                                }
-                                else if (i >= givenparams.size())
-                                {
-                                    // Macro had more parameters than caller used.
-                                    macrocode = "";
-                                    return false;
-                                }
-                                else if (stringify)
-                                {
-                                    const std::string &s(givenparams[i]);
-                                    std::ostringstream ostr;
-                                    ostr << "\"";
-                                    for (std::string::size_type j = 0; j < s.size(); ++j)
-                                    {
-                                        if (s[j] == '\\' || s[j] == '\"')
-                                            ostr << '\\';
-                                        ostr << s[j];
-                                    }
-                                    str = ostr.str() + "\"";
-                                }
-                                else
-                                    str = givenparams[i];
-
-                                break;
-                            }
-                        }
+                    optcomma = true;
+                    continue;
+                }
 
-                        // expand nopar macro
-                        const std::map<std::string, PreprocessorMacro *>::const_iterator it = macros.find(str);
-                        if (it != macros.end() && it->second->_macro.find("(") == std::string::npos)
-                        {
-                            str = it->second->_macro;
-                            if (str.find(" ") != std::string::npos)
-                                str.erase(0, str.find(" "));
-                            else
-                                str = "";
-                        }
+                if (!tok->name)
+                {
+                    optcomma = false;
+                    macrocode += tok->str;
+                    if (tok->space)
+                        macrocode += " ";
+                    continue;
+                }
+
+                std::string str;
+                const unsigned int i = (unsigned int)tok->param;
+                if (tok->param < 0)
+                {
+                    str = tok->str;
+                }
+                else if (_variadic &&
+                         (i == _params.size() - 1 ||
+                          (givenparams.size() + 2 == _params.size() && i + 1 == _params.size() - 1)))
+                {
+                    for (unsigned int j = (unsigned int)_params.size() - 1; j < givenparams.size(); ++j)
+                    {
+                        if (optcomma || j > _params.size() - 1)
+                            str += ",";
+                        optcomma = false;
+                        str += givenparams[j];
                     }
-                    if (_variadic && tok->str() == "," && tok->next() && tok->next()->str() == "##")
+                }
+                else if (i >= givenparams.size())
+                {
+                    // Macro had more parameters than caller used.
+                    macrocode = "";
+                    return false;
+                }
+                else if (tok->stringify)
+                {
+                    const std::string &s(givenparams[i]);
+                    std::ostringstream ostr;
+                    ostr << "\"";
+                    for (std::string::size_type j = 0; j < s.size(); ++j)
                     {
-                        optcomma = true;
-                        continue;
+                        if (s[j] == '\\' || s[j] == '\"')
+                            ostr << '\\';
+                        ostr << s[j];
                     }
-                    optcomma = false;
-                    macrocode += str;
-                    if (Token::Match(tok, "%var% %var%") ||
-                        Token::Match(tok, "%var% %num%") ||
-                        Token::Match(tok, "%num% %var%") ||
-                        Token::Match(tok, "> >"))
-                        macrocode += " ";
+                    str = ostr.str() + "\"";
                 }
+                else
+                    str = givenparams[i];
+
+                // expand nopar macro
+                const PreprocessorMacro *macro = macros.find(str);
+                if (macro && !macro->_parentheses)
+                    str = macro->_innerCode;
+
+                optcomma = false;
+                macrocode += str;
+                if (tok->space)
+                    macrocode += " ";
             }
         }
 
@@ -2090,41 +2934,124 @@ public:
     }
 };
 
+unsigned int MacroTable::hash(const char name[], std::string::size_type length)
+{
+    // FNV-1a
+    unsigned int h = 2166136261U;
+    for (std::string::size_type i = 0; i < length; ++i)
+    {
+        h ^= (unsigned char)name[i];
+        h *= 16777619U;
+    }
+    return h;
+}
+
+PreprocessorMacro *MacroTable::find(const char name[], std::string::size_type length) const
+{
+    const std::vector<PreprocessorMacro *> &bucket = _buckets[hash(name, length) & (_buckets.size() - 1)];
+    for (std::vector<PreprocessorMacro *>::const_iterator it = bucket.begin(); it != bucket.end(); ++it)
+    {
+        const std::string &macroName = (*it)->name();
+        if (macroName.size() == length && macroName.compare(0, length, name, length) == 0)
+            return *it;
+    }
+    return 0;
+}
+
+PreprocessorMacro *MacroTable::insert(PreprocessorMacro *macro)
+{
+    const std::string &name = macro->name();
+    std::vector<PreprocessorMacro *> &bucket = _buckets[hash(name.c_str(), name.size()) & (_buckets.size() - 1)];
+    for (std::vector<PreprocessorMacro *>::iterator it = bucket.begin(); it != bucket.end(); ++it)
+    {
+        if ((*it)->name() == name)
+        {
+            PreprocessorMacro * const old = *it;
+            *it = macro;
+            return old;
+        }
+    }
+    bucket.push_back(macro);
+
+    // Grow the table so the buckets stay short
+    if (++_size > _buckets.size())
+    {
+        std::vector<std::vector<PreprocessorMacro *> > buckets(2 * _buckets.size());
+        for (unsigned int i = 0; i < _buckets.size(); ++i)
+        {
+            for (std::vector<PreprocessorMacro *>::const_iterator it = _buckets[i].begin(); it != _buckets[i].end(); ++it)
+                buckets[hash((*it)->name().c_str(), (*it)->name().size()) & (buckets.size() - 1)].push_back(*it);
+        }
+        _buckets.swap(buckets);
+    }
+
+    return 0;
+}
+
+PreprocessorMacro *MacroTable::erase(const std::string &name)
+{
+    std::vector<PreprocessorMacro *> &bucket = _buckets[hash(name.c_str(), name.size()) & (_buckets.size() - 1)];
+    for (std::vector<PreprocessorMacro *>::iterator it = bucket.begin(); it != bucket.end(); ++it)
+    {
+        if ((*it)->name() == name)
+        {
+            PreprocessorMacro * const macro = *it;
+            bucket.erase(it);
+            --_size;
+            return macro;
+        }
+    }
+    return 0;
+}
+
+void MacroTable::deleteMacros()
+{
+    for (unsigned int i = 0; i < _buckets.size(); ++i)
+    {
+        for (std::vector<PreprocessorMacro *>::iterator it = _buckets[i].begin(); it != _buckets[i].end(); ++it)
+            delete *it;
+        _buckets[i].clear();
+    }
+    _size = 0;
+}
+
 /**
- * Get data from a input string. This is an extended version of std::getline.
+ * Get data from the code. This is an extended version of std::getline.
  * The std::getline only get a single line at a time. It can therefore happen that it
  * contains a partial statement. This function ensures that the returned data
  * doesn't end in the middle of a statement. The "getlines" name indicate that
  * this function will return multiple lines if needed.
- * @param istr input stream
+ * @param code input code
+ * @param pos in: position where the data starts, out: position after the data
  * @param line output data
  * @return success
  */
-static bool getlines(std::istream &istr, std::string &line)
+static bool getlines(const std::string &code, std::string::size_type &pos, std::string &line)
 {
-    if (!istr.good())
+    if (pos >= code.size())
         return false;
-    line = "";
+    line.clear();
     int parlevel = 0;
-    for (char ch = (char)istr.get(); istr.good(); ch = (char)istr.get())
+    while (pos < code.size())
     {
+        const char ch = code[pos++];
         if (ch == '\'' || ch == '\"')
         {
             line += ch;
             char c = 0;
-            while (istr.good() && c != ch)
+            while (c != ch)
             {
                 if (c == '\\')
                 {
-                    c = (char)istr.get();
-                    if (!istr.good())
+                    if (pos >= code.size())
                         return true;
+                    c = code[pos++];
                     line += c;
                 }
 
-                c = (char)istr.get();
-                if (!istr.good())
+                if (pos >= code.size())
                     return true;
+                c = code[pos++];
                 if (c == '\n' && line.compare(0, 1, "#") == 0)
                     return true;
                 line += c;
@@ -2140,7 +3067,7 @@ static bool getlines(std::istream &istr, std::string &line)
             if (line.compare(0, 1, "#") == 0)
                 return true;
 
-            if (istr.peek() == '#')
+            if (pos < code.size() && code[pos] == '#')
             {
                 line += ch;
                 return true;
@@ -2157,27 +3084,24 @@ static bool getlines(std::istream &istr, std::string &line)
     return true;
 }
 
-std::string Preprocessor::expandMacros(const std::string &code, std::string filename, ErrorLogger *errorLogger)
+std::string Preprocessor::expandMacros(const std::string &code, const std::string &filename, ErrorLogger *errorLogger, const SourceLocations &locations)
 {
     // Search for macros and expand them..
     // --------------------------------------------
 
-    // Available macros (key=macroname, value=macro).
-    std::map<std::string, PreprocessorMacro *> macros;
+    // Available macros
+    MacroTable macros;
 
     // Current line number
     unsigned int linenr = 1;
 
-    // linenr, filename
-    std::stack< std::pair<unsigned int, std::string> > fileinfo;
-
     // output stream
     std::ostringstream ostr;
 
     // read code..
-    std::istringstream istr(code.c_str());
+    std::string::size_type codepos = 0;
     std::string line;
-    while (getlines(istr, line))
+    while (getlines(code, codepos, line))
     {
         // defining a macro..
         if (line.compare(0, 8, "#define ") == 0)
@@ -2186,50 +3110,17 @@ std::string Preprocessor::expandMacros(const std::string &code, std::string file
             if (macro->name().empty())
                 delete macro;
             else
-            {
-                std::map<std::string, PreprocessorMacro *>::iterator it;
-                it = macros.find(macro->name());
-                if (it != macros.end())
-                    delete it->second;
-                macros[macro->name()] = macro;
-            }
+                delete macros.insert(macro);
             line = "\n";
         }
 
         // undefining a macro..
         else if (line.compare(0, 7, "#undef ") == 0)
         {
-            std::map<std::string, PreprocessorMacro *>::iterator it;
-            it = macros.find(line.substr(7));
-            if (it != macros.end())
-            {
-                delete it->second;
-                macros.erase(it);
-            }
+            delete macros.erase(line.substr(7));
             line = "\n";
         }
 
-        // entering a file, update position..
-        else if (line.compare(0, 7, "#file \"") == 0)
-        {
-            fileinfo.push(std::pair<unsigned int, std::string>(linenr, filename));
-            filename = line.substr(7, line.length() - 8);
-            linenr = 0;
-            line += "\n";
-        }
-
-        // leaving a file, update position..
-        else if (line == "#endfile")
-        {
-            if (!fileinfo.empty())
-            {
-                linenr = fileinfo.top().first;
-                filename = fileinfo.top().second;
-                fileinfo.pop();
-            }
-            line += "\n";
-        }
-
         // all other preprocessor directives are just replaced with a newline
         else if (line.compare(0, 1, "#") == 0)
         {
@@ -2276,16 +3167,15 @@ std::string Preprocessor::expandMacros(const std::string &code, std::string file
 
                     if (pos >= line.size())
                     {
-                        writeError(filename,
-                                   linenr + tmpLinenr,
+                        unsigned int errorLinenr = linenr + tmpLinenr;
+                        const std::string errorFile(getLocation(locations, filename, errorLinenr));
+                        writeError(errorFile,
+                                   errorLinenr,
                                    errorLogger,
                                    "noQuoteCharPair",
                                    std::string("No pair for character (") + ch + "). Can't process file. File is either invalid or unicode, which is currently not supported.");
 
-                        std::map<std::string, PreprocessorMacro *>::iterator it;
-                        for (it = macros.begin(); it != macros.end(); ++it)
-                            delete it->second;
-
+                        macros.deleteMacros();
                         return "";
                     }
 
@@ -2306,16 +3196,11 @@ std::string Preprocessor::expandMacros(const std::string &code, std::string file
                     while (pos < line.size() && (std::isalnum(line[pos]) || line[pos] == '_'))
                         ++pos;
 
-                    // get identifier
-                    const std::string id = line.substr(pos1, pos - pos1);
-
                     // is there a macro with this name?
-                    std::map<std::string, PreprocessorMacro *>::const_iterator it;
-                    it = macros.find(id);
-                    if (it == macros.end())
+                    PreprocessorMacro * const macro = macros.find(line.c_str() + pos1, pos - pos1);
+                    if (!macro)
                         break;  // no macro with this name exist
-
-                    const PreprocessorMacro * const macro = it->second;
+                    macro->parse();
 
                     // check that pos is within allowed limits for this
                     // macro
@@ -2361,16 +3246,15 @@ std::string Preprocessor::expandMacros(const std::string &code, std::string file
                     if (!macro->code(params, macros, tempMacro))
                     {
                         // Syntax error in code
-                        writeError(filename,
-                                   linenr + tmpLinenr,
+                        unsigned int errorLinenr = linenr + tmpLinenr;
+                        const std::string errorFile(getLocation(locations, filename, errorLinenr));
+                        writeError(errorFile,
+                                   errorLinenr,
                                    errorLogger,
                                    "syntaxError",
                                    std::string("Syntax error. Not enough parameters for macro '") + macro->name() + "'.");
 
-                        std::map<std::string, PreprocessorMacro *>::iterator iter;
-                        for (iter = macros.begin(); iter != macros.end(); ++iter)
-                            delete iter->second;
-
+                        macros.deleteMacros();
                         return "";
                     }
 
@@ -2426,11 +3310,7 @@ std::string Preprocessor::expandMacros(const std::string &code, std::string file
         }
     }
 
-    {
-        std::map<std::string, PreprocessorMacro *>::iterator it;
-        for (it = macros.begin(); it != macros.end(); ++it)
-            delete it->second;
-    }
+    macros.deleteMacros();
 
     return ostr.str();
 }
@@ -21,18 +21,114 @@
 #define preprocessorH
 //---------------------------------------------------------------------------
 
+#include "sourcelocations.h"
+
 #include <map>
 #include <istream>
 #include <string>
 #include <list>
 #include <set>
+#include <vector>
 
 class ErrorLogger;
 class Settings;
+class PreprocessorCondition;
 
 /// @addtogroup Core
 /// @{
 
+/**
+ * @brief The conditional structure of a preprocessed file.
+ *
+ * The file is parsed once into a list of nodes. Consecutive code lines
+ * become one text node that refers to a range of the file data. The
+ * conditional blocks form a tree: each #if, #elif and #else node is
+ * linked to the next #elif, #else or #endif on the same level, so
+ * blocks that are not part of a configuration can be skipped. Use it
+ * with Preprocessor::getcode() to get the code for each configuration.
+ */
+class DirectiveTree
+{
+public:
+    /**
+     * Parse preprocessed file data
+     * @param filedata preprocessed file data
+     * @param settings settings
+     * @param locations the files and line numbers of the lines, for error messages
+     */
+    DirectiveTree(const std::string &filedata, const Settings *settings, const SourceLocations &locations = SourceLocations());
+
+    ~DirectiveTree();
+
+private:
+    /** Disable copy constructor */
+    DirectiveTree(const DirectiveTree &);
+
+    /** Disable assignment operator */
+    void operator=(const DirectiveTree &);
+
+    friend class Preprocessor;
+
+    enum NodeType
+    {
+        Text,       ///< code lines
+        Keep,       ///< #undef that is always kept
+        Define,     ///< #define
+        If,         ///< #if / #ifdef
+        Ifndef,     ///< #ifndef
+        Elif,       ///< #elif
+        Else,       ///< #else
+        Endif,      ///< #endif
+        Error,      ///< #error
+        Asm,        ///< #pragma asm .. #pragma endasm
+        Directive   ///< other directives, these are removed
+    };
+
+    /** @brief node in the tree */
+    struct Node
+    {
+        NodeType type;
+
+        /** text and the #define and #undef lines: position in the file data */
+        std::string::size_type pos;
+
+        /** length of text, without the last newline */
+        std::string::size_type len;
+
+        /** number of lines */
+        unsigned int lines;
+
+        /** line number */
+        unsigned int linenr;
+
+        /** #if, #elif and #else: index of the next #elif, #else or #endif on the same level */
+        unsigned int next;
+
+        /** condition of #if / #elif, name of #define or the code for #pragma asm */
+        std::string str;
+
+        /** value of #define */
+        std::string value;
+
+        /** compiled condition */
+        const PreprocessorCondition *condition;
+
+        /** #pragma asm: was #pragma endasm found? */
+        bool endasm;
+    };
+
+    /** file data */
+    const std::string _code;
+
+    /** the files and line numbers of the lines */
+    const SourceLocations _locations;
+
+    std::vector<Node> _nodes;
+
+    /** compiled conditions, key is the condition */
+    std::map<std::string, PreprocessorCondition *> _conditions;
+};
+
 /**
  * @brief The cppcheck preprocessor.
  * The preprocessor has special functionality for extracting the various ifdef
@@ -52,6 +148,29 @@ public:
         SystemHeader
     };
 
+    /**
+     * @brief A configuration: the defined macros and their values. The
+     * macros without a value have an empty value.
+     */
+    class Configuration
+    {
+    public:
+        Configuration()
+        { }
+
+        /**
+         * Parse a configuration string
+         * @param cfg the configuration, "A;B=1;C"
+         */
+        explicit Configuration(const std::string &cfg);
+
+        /** the configuration as a "A;B=1;C" string */
+        std::string name;
+
+        /** the defined macros and their values */
+        std::map<std::string, std::string> defines;
+    };
+
     Preprocessor(Settings *settings = 0, ErrorLogger *errorLogger = 0);
 
     /**
@@ -86,6 +205,22 @@ public:
      */
     void preprocess(std::istream &srcCodeStream, std::string &processedFile, std::list<std::string> &resultConfigurations, const std::string &filename, const std::list<std::string> &includePaths);
 
+    /**
+     * Extract the code for each configuration. Same as the above, but the
+     * configurations are given as Configuration objects that can be passed
+     * to getcode() without parsing the configuration strings.
+     */
+    void preprocess(std::istream &srcCodeStream, std::string &processedFile, std::list<Configuration> &resultConfigurations, const std::string &filename, const std::list<std::string> &includePaths);
+
+    /**
+     * The files and line numbers of the lines of the code from the last
+     * preprocess(). Pass these to the Tokenizer with the code.
+     */
+    const SourceLocations &getSourceLocations() const
+    {
+        return _locations;
+    }
+
     /** Just read the code into a string. Perform simple cleanup of the code */
     std::string read(std::istream &istr, const std::string &filename, Settings *settings);
 
@@ -94,6 +229,29 @@ public:
      */
     static std::string getcode(const std::string &filedata, std::string cfg, const std::string &filename, const Settings *settings, ErrorLogger *errorLogger);
 
+    /**
+     * Get preprocessed code for a given configuration. Use this when code
+     * for several configurations is needed, the file is then parsed only once.
+     * @param directives the parsed file data
+     * @param cfg the configuration
+     * @param filename the name of the file
+     * @param settings settings
+     * @param errorLogger error logger
+     * @return the code for the configuration
+     */
+    static std::string getcode(const DirectiveTree &directives, const std::string &cfg, const std::string &filename, const Settings *settings, ErrorLogger *errorLogger);
+
+    /**
+     * Get preprocessed code for a given configuration
+     * @param directives the parsed file data
+     * @param cfg the configuration
+     * @param filename the name of the file
+     * @param settings settings
+     * @param errorLogger error logger
+     * @return the code for the configuration
+     */
+    static std::string getcode(const DirectiveTree &directives, const Configuration &cfg, const std::string &filename, const Settings *settings, ErrorLogger *errorLogger);
+
     /**
      * simplify condition
      * @param variables Variable values
@@ -133,9 +291,10 @@ protected:
      * @param code The input code
      * @param filename filename of source file
      * @param errorLogger Error logger to write errors to (if any)
+     * @param locations the files and line numbers of the lines, for error messages
      * @return the expanded string
      */
-    static std::string expandMacros(const std::string &code, std::string filename, ErrorLogger *errorLogger);
+    static std::string expandMacros(const std::string &code, const std::string &filename, ErrorLogger *errorLogger, const SourceLocations &locations = SourceLocations());
 
     /**
      * Remove comments from code. This should only be called from read().
@@ -162,6 +321,15 @@ protected:
      *         SystemHeader if file surrounded with \<\> was found
      */
     static Preprocessor::HeaderTypes getHeaderFileName(std::string &str);
+
+    /**
+     * Get the include guard of a header. The code of a guarded header is
+     * in a "#ifndef GUARD" block that starts with "#define GUARD".
+     * @param code the code of the header
+     * @return the guard macro, "#pragma once" or an empty string if the
+     * header is not guarded
+     */
+    static std::string getIncludeGuard(const std::string &code);
 private:
 
     /**
@@ -175,11 +343,17 @@ private:
     /**
      * Get all possible configurations sorted in alphabetical order.
      * By looking at the ifdefs and ifndefs in filedata
+     * @param filedata the preprocessed file data
+     * @param filename the name of the file
+     * @param locations the files and line numbers of the lines. The include
+     * guards of the included files are not configurations.
      */
-    std::list<std::string> getcfgs(const std::string &filedata, const std::string &filename);
+    std::list<Configuration> getcfgs(const std::string &filedata, const std::string &filename, const SourceLocations &locations);
 
     static std::string getdef(std::string line, bool def);
 
+    friend class DirectiveTree;
+
 public:
 
     /**
@@ -214,21 +388,43 @@ private:
      * Note that if path from given filename is also extracted and that is used as
      * a last include path if include file was not found from earlier paths.
      * @param systemIncludes System includes
-     * @param handledFiles used in the recursive handling. Should be empty unless
-     * a recursive call is made.
+     * @param handledFiles Files that are handled in the recursion. The
+     * files that are added in a recursive call are removed when it returns.
+     * @param locations The files and line numbers of the lines of the
+     * modified code are written here
+     * @param unconditional Is the code included unconditionally?
      * @return modified source code
      */
     void handleIncludes(std::string &code,
                         const std::string &filePath,
                         const std::list<std::string> &includePaths,
                         std::set<std::string> &systemIncludes,
-                        std::set<std::string> handledFiles = std::set<std::string>());
+                        std::set<std::string> &handledFiles,
+                        SourceLocations &locations,
+                        bool unconditional = true);
 
     Settings *_settings;
     ErrorLogger *_errorLogger;
 
     /** filename for cpp/c file - useful when reporting errors */
     std::string file0;
+
+    /**
+     * @brief Include guards of headers that have been included unconditionally.
+     * Key is the lowercase file name and value is the guard macro or
+     * "#pragma once". Such a header is not included again unless the guard
+     * macro is undefined somewhere.
+     */
+    std::map<std::string, std::string> _includeGuards;
+
+    /** @brief Macros that are undefined with #undef in the included code */
+    std::set<std::string> _undefinedMacros;
+
+    /** @brief Paths of the found include files. Key is the #include and the path of the including file. */
+    std::map<std::string, std::string> _includeFiles;
+
+    /** @brief The files and line numbers of the lines of the preprocessed code */
+    SourceLocations _locations;
 };
 
 /// @}
@@ -39,6 +39,9 @@ Settings::Settings()
     _jobs = 1;
     _exitCode = 0;
     _showtime = 0; // TODO: use enum
+    _maxExecutionPaths = 10;
+    _maxExecutionPathTime = 0;
+    _configBudget = 0;
     _append = "";
     _terminate = false;
     inconclusive = false;
@@ -23,6 +23,7 @@
 #include <string>
 #include <istream>
 #include <map>
+#include <set>
 
 /// @addtogroup Core
 /// @{
@@ -105,6 +106,18 @@ public:
     /** @brief show timing information (--showtime=file|summary|top5) */
     unsigned int _showtime;
 
+    /** @brief Max number of execution paths for a function body (--max-paths=n) */
+    unsigned int _maxExecutionPaths;
+
+    /** @brief Max time for checking the execution paths of a function
+        body in milliseconds. 0 => no limit (--max-path-time=ms) */
+    unsigned int _maxExecutionPathTime;
+
+    /** @brief Time in seconds for checking the configurations of a file.
+        The configurations that cover most lines are checked first.
+        0 => the first 12 configurations are checked (--config-budget=seconds) */
+    unsigned int _configBudget;
+
     /** @brief List of include paths, e.g. "my/includes/" which should be used
         for finding include files inside source files. (-I) */
     std::list<std::string> _includePaths;
@@ -177,6 +190,15 @@ public:
     /** @brief Experimental 2 pass checking of files */
     bool test_2_pass;
 
+    /** @brief File where function summaries are stored between runs (--summaries=file) */
+    std::string summaryFile;
+
+    /**
+     * @brief Function summaries of the analysed files (--test-2-pass).
+     * The key is the name of the check, see Check::name().
+     */
+    std::map<std::string, std::set<std::string> > functionSummaries;
+
     /** @brief --report-progress */
     bool reportProgress;
 
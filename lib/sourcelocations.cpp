@@ -0,0 +1,81 @@
+/*
+ * Cppcheck - A tool for static C/C++ code analysis
+ * Copyright (C) 2007-2010 Daniel Marjamäki and Cppcheck team.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "sourcelocations.h"
+
+#include <algorithm>
+
+/** Compare a line with the first line of a range */
+static bool lineBefore(unsigned int line, const SourceLocations::Range &range)
+{
+    return line < range.line;
+}
+
+void SourceLocations::add(unsigned int line, const std::string &file, unsigned int fileLine)
+{
+    Range range;
+    range.line = line;
+    range.file = getFileIndex(file);
+    range.fileLine = fileLine;
+
+    if (!_ranges.empty() && _ranges.back().line == line)
+        _ranges.back() = range;
+    else
+        _ranges.push_back(range);
+}
+
+void SourceLocations::add(unsigned int line, const SourceLocations &locations)
+{
+    for (std::vector<Range>::const_iterator it = locations._ranges.begin(); it != locations._ranges.end(); ++it)
+        add(line + it->line - 1, locations._files[it->file], it->fileLine);
+}
+
+void SourceLocations::find(unsigned int line, unsigned int &file, unsigned int &fileLine) const
+{
+    // the last range that starts at or before the line
+    const std::vector<Range>::const_iterator it = std::upper_bound(_ranges.begin(), _ranges.end(), line, lineBefore);
+    if (it == _ranges.begin())
+    {
+        file = 0;
+        fileLine = line;
+        return;
+    }
+
+    const Range &range = *(it - 1);
+    file = range.file;
+    fileLine = range.fileLine + line - range.line;
+}
+
+void SourceLocations::clear()
+{
+    _ranges.clear();
+    _files.clear();
+    _fileIndexes.clear();
+}
+
+unsigned int SourceLocations::getFileIndex(const std::string &file)
+{
+    const std::map<std::string, unsigned int>::const_iterator it = _fileIndexes.find(file);
+    if (it != _fileIndexes.end())
+        return it->second;
+
+    const unsigned int index = static_cast<unsigned int>(_files.size());
+    _files.push_back(file);
+    _fileIndexes[file] = index;
+    return index;
+}
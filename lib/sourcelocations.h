@@ -0,0 +1,109 @@
+/*
+ * Cppcheck - A tool for static C/C++ code analysis
+ * Copyright (C) 2007-2010 Daniel Marjamäki and Cppcheck team.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef sourcelocationsH
+#define sourcelocationsH
+
+#include <map>
+#include <string>
+#include <vector>
+
+/// @addtogroup Core
+/// @{
+
+
+/**
+ * @brief The files and line numbers of the lines of preprocessed code.
+ *
+ * The preprocessor splices the code of the included files into the code
+ * of the source file. The lines of the code are mapped back to the files
+ * with ranges: a range is a sequence of lines from the same file, and it
+ * lasts until the next range starts. The ranges are sorted by line so a
+ * location is found with a binary search.
+ */
+class SourceLocations
+{
+public:
+    /** @brief a range of lines */
+    struct Range
+    {
+        /** first line of the range in the code */
+        unsigned int line;
+
+        /** index of the file in files() */
+        unsigned int file;
+
+        /** line number of the first line in the file */
+        unsigned int fileLine;
+    };
+
+    /**
+     * Add a range. The ranges must be added in the order of the lines.
+     * A range that starts at the same line as the previous range
+     * replaces it.
+     * @param line first line of the range in the code
+     * @param file the file
+     * @param fileLine line number of the first line in the file
+     */
+    void add(unsigned int line, const std::string &file, unsigned int fileLine);
+
+    /**
+     * Add the ranges of code that is inserted in this code
+     * @param line the line of this code where the inserted code starts
+     * @param locations the locations of the inserted code
+     */
+    void add(unsigned int line, const SourceLocations &locations);
+
+    /**
+     * Get the location of a line of the code
+     * @param line the line in the code
+     * @param file the index of the file in files() is written here
+     * @param fileLine the line number in the file is written here
+     */
+    void find(unsigned int line, unsigned int &file, unsigned int &fileLine) const;
+
+    /** @brief the ranges, sorted by line */
+    const std::vector<Range> &ranges() const
+    {
+        return _ranges;
+    }
+
+    /** @brief the files. The source file is the first one. */
+    const std::vector<std::string> &files() const
+    {
+        return _files;
+    }
+
+    /** @brief Remove the ranges and files */
+    void clear();
+
+private:
+    /** Get the index of a file. The file is added if it's not found. */
+    unsigned int getFileIndex(const std::string &file);
+
+    std::vector<Range> _ranges;
+
+    std::vector<std::string> _files;
+
+    /** index of each file in _files */
+    std::map<std::string, unsigned int> _fileIndexes;
+};
+
+/// @}
+
+#endif
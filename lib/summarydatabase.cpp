@@ -0,0 +1,112 @@
+/*
+ * Cppcheck - A tool for static C/C++ code analysis
+ * Copyright (C) 2007-2010 Daniel Marjamäki and Cppcheck team.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "summarydatabase.h"
+
+#include <sstream>
+
+/** First line in a summary database file */
+static const char header[] = "cppcheck-summaries 1";
+
+SummaryDatabase::SummaryDatabase()
+    : _changed(false)
+{
+}
+
+std::string SummaryDatabase::hash(const std::string &content)
+{
+    // 64-bit FNV-1a
+    unsigned long long h = 14695981039346656037ULL;
+    for (std::string::size_type i = 0; i < content.size(); ++i)
+    {
+        h ^= (unsigned char)content[i];
+        h *= 1099511628211ULL;
+    }
+
+    std::ostringstream ostr;
+    ostr << std::hex << h << "-" << std::dec << content.size();
+    return ostr.str();
+}
+
+bool SummaryDatabase::find(const std::string &filename, const std::string &hash, Data &data) const
+{
+    const std::map<std::string, Entry>::const_iterator it = _entries.find(filename);
+    if (it == _entries.end() || it->second.hash != hash)
+        return false;
+    data = it->second.data;
+    return true;
+}
+
+void SummaryDatabase::insert(const std::string &filename, const std::string &hash, const Data &data)
+{
+    Entry &entry = _entries[filename];
+    entry.hash = hash;
+    entry.data = data;
+    _changed = true;
+}
+
+bool SummaryDatabase::load(std::istream &istr)
+{
+    std::string line;
+    if (!std::getline(istr, line) || line != header)
+        return false;
+
+    // The entries are not used unless the whole file is valid
+    std::map<std::string, Entry> entries;
+    Entry *entry = 0;
+    while (std::getline(istr, line))
+    {
+        // file <hash> <filename>
+        if (line.compare(0, 5, "file ") == 0)
+        {
+            const std::string::size_type pos = line.find(" ", 5);
+            if (pos == std::string::npos)
+                return false;
+            entry = &entries[line.substr(pos + 1)];
+            entry->hash = line.substr(5, pos - 5);
+            entry->data.clear();
+        }
+
+        // <check name> TAB <summary>
+        else if (entry && line.find("\t") != std::string::npos)
+        {
+            const std::string::size_type pos = line.find("\t");
+            entry->data[line.substr(0, pos)].insert(line.substr(pos + 1));
+        }
+
+        else if (!line.empty())
+            return false;
+    }
+
+    _entries.swap(entries);
+    return true;
+}
+
+void SummaryDatabase::save(std::ostream &ostr) const
+{
+    ostr << header << "\n";
+    for (std::map<std::string, Entry>::const_iterator it = _entries.begin(); it != _entries.end(); ++it)
+    {
+        ostr << "file " << it->second.hash << " " << it->first << "\n";
+        for (Data::const_iterator check = it->second.data.begin(); check != it->second.data.end(); ++check)
+        {
+            for (std::set<std::string>::const_iterator summary = check->second.begin(); summary != check->second.end(); ++summary)
+                ostr << check->first << "\t" << *summary << "\n";
+        }
+    }
+}
@@ -0,0 +1,106 @@
+/*
+ * Cppcheck - A tool for static C/C++ code analysis
+ * Copyright (C) 2007-2010 Daniel Marjamäki and Cppcheck team.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef summarydatabaseH
+#define summarydatabaseH
+
+#include <istream>
+#include <ostream>
+#include <map>
+#include <set>
+#include <string>
+
+/// @addtogroup Core
+/// @{
+
+
+/**
+ * @brief Persistent storage for the function summaries that the checks
+ * generate in the analysis pass (see Check::analyse).
+ *
+ * The summaries are stored per source file together with a hash of the
+ * preprocessed file content. When the content is unchanged the stored
+ * summaries are used instead of tokenizing and analysing the file again.
+ */
+class SummaryDatabase
+{
+public:
+    /** @brief Summaries for one file. Key is the check name. */
+    typedef std::map<std::string, std::set<std::string> > Data;
+
+    SummaryDatabase();
+
+    /**
+     * @brief Calculate hash for file content
+     * @param content the preprocessed file content
+     * @return hash as a hexadecimal string
+     */
+    static std::string hash(const std::string &content);
+
+    /**
+     * @brief Get the stored summaries for a file
+     * @param filename name of source file
+     * @param hash hash of the current file content
+     * @param data the stored summaries are written here
+     * @return true if summaries with matching hash were found
+     */
+    bool find(const std::string &filename, const std::string &hash, Data &data) const;
+
+    /**
+     * @brief Store summaries for a file. Old summaries for the file are replaced.
+     * @param filename name of source file
+     * @param hash hash of the file content
+     * @param data summaries
+     */
+    void insert(const std::string &filename, const std::string &hash, const Data &data);
+
+    /**
+     * @brief Read database
+     * @param istr input stream
+     * @return false if the data is not a summary database. The database
+     * is not changed then.
+     */
+    bool load(std::istream &istr);
+
+    /** @brief Write database */
+    void save(std::ostream &ostr) const;
+
+    /** @brief Has the database been changed since it was loaded? */
+    bool changed() const
+    {
+        return _changed;
+    }
+
+private:
+    /** @brief summaries and content hash for a file */
+    struct Entry
+    {
+        std::string hash;
+        Data data;
+    };
+
+    /** @brief Key is file name */
+    std::map<std::string, Entry> _entries;
+
+    /** @brief Has insert() been called */
+    bool _changed;
+};
+
+/// @}
+
+#endif
@@ -36,7 +36,7 @@
 //---------------------------------------------------------------------------
 
 SymbolDatabase::SymbolDatabase(const Tokenizer *tokenizer, const Settings *settings, ErrorLogger *errorLogger)
-    : _tokenizer(tokenizer), _settings(settings), _errorLogger(errorLogger)
+    : _callGraph(false), _tokenizer(tokenizer), _settings(settings), _errorLogger(errorLogger)
 {
     // find all namespaces (class,struct and namespace)
     SpaceInfo *info = new SpaceInfo(this, NULL, NULL);
@@ -1949,3 +1949,118 @@ bool SymbolDatabase::isVirtualFunc(const SymbolDatabase::SpaceInfo *info, const
     return false;
 }
 
+//---------------------------------------------------------------------------
+
+void SymbolDatabase::createCallGraph() const
+{
+    _callGraph = true;
+
+    // function bodies..
+    std::map<const Token *, const SpaceInfo *> functionStart;
+    for (std::list<SpaceInfo *>::const_iterator it = spaceInfoList.begin(); it != spaceInfoList.end(); ++it)
+    {
+        const SpaceInfo *info = *it;
+        if (info->type != SpaceInfo::Function || !info->classStart)
+            continue;
+        functionStart[info->classStart] = info;
+        _functionScopes.insert(std::make_pair(info->className, info));
+    }
+
+    // calls..
+    std::vector<const SpaceInfo *> functions;
+    unsigned int index = 0;
+    for (const Token *tok = _tokenizer->tokens(); tok; tok = tok->next())
+    {
+        if (tok->str() == "{")
+        {
+            const std::map<const Token *, const SpaceInfo *>::const_iterator it = functionStart.find(tok);
+            if (it != functionStart.end())
+                functions.push_back(it->second);
+        }
+        else if (tok->str() == "}")
+        {
+            if (!functions.empty() && tok == functions.back()->classEnd)
+                functions.pop_back();
+        }
+
+        if (!Token::Match(tok, "%var% (") || Token::Match(tok, "if|for|while|switch|return|sizeof"))
+            continue;
+
+        // function implementation / constructor initialization
+        const Token *end = tok->next()->link();
+        if (!end || Token::Match(end, ") const|{"))
+            continue;
+
+        CallSite call;
+        call.tok = tok;
+        call.caller = functions.empty() ? NULL : functions.back();
+        call.index = index++;
+        _callSites[tok->str()].push_back(call);
+        if (call.caller)
+            _calls[call.caller].push_back(call);
+    }
+}
+
+const SymbolDatabase::SpaceInfo *SymbolDatabase::findFunctionScope(const std::string &funcname) const
+{
+    if (!_callGraph)
+        createCallGraph();
+
+    const std::map<std::string, const SpaceInfo *>::const_iterator it = _functionScopes.find(funcname);
+    return (it == _functionScopes.end()) ? NULL : it->second;
+}
+
+const std::vector<SymbolDatabase::CallSite> &SymbolDatabase::getCallSites(const std::string &funcname) const
+{
+    if (!_callGraph)
+        createCallGraph();
+
+    static const std::vector<CallSite> empty;
+    const std::map<std::string, std::vector<CallSite> >::const_iterator it = _callSites.find(funcname);
+    return (it == _callSites.end()) ? empty : it->second;
+}
+
+/** Sort calls in token order */
+static bool callBefore(const SymbolDatabase::CallSite &call1, const SymbolDatabase::CallSite &call2)
+{
+    return call1.index < call2.index;
+}
+
+std::vector<SymbolDatabase::CallSite> SymbolDatabase::findCallSites(const std::string &funcnames) const
+{
+    std::vector<CallSite> calls;
+
+    std::string::size_type pos1 = 0;
+    while (pos1 <= funcnames.size())
+    {
+        std::string::size_type pos2 = funcnames.find("|", pos1);
+        if (pos2 == std::string::npos)
+            pos2 = funcnames.size();
+
+        const std::vector<CallSite> &callsToFunction = getCallSites(funcnames.substr(pos1, pos2 - pos1));
+        calls.insert(calls.end(), callsToFunction.begin(), callsToFunction.end());
+
+        pos1 = pos2 + 1;
+    }
+
+    std::sort(calls.begin(), calls.end(), callBefore);
+    return calls;
+}
+
+const std::vector<SymbolDatabase::CallSite> &SymbolDatabase::getCalls(const SpaceInfo *caller) const
+{
+    if (!_callGraph)
+        createCallGraph();
+
+    static const std::vector<CallSite> empty;
+    const std::map<const SpaceInfo *, std::vector<CallSite> >::const_iterator it = _calls.find(caller);
+    return (it == _calls.end()) ? empty : it->second;
+}
+
+const std::map<std::string, std::vector<SymbolDatabase::CallSite> > &SymbolDatabase::getAllCallSites() const
+{
+    if (!_callGraph)
+        createCallGraph();
+
+    return _callSites;
+}
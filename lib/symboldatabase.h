@@ -23,6 +23,7 @@
 
 #include <string>
 #include <list>
+#include <map>
 #include <vector>
 
 class Token;
@@ -266,8 +267,73 @@ public:
      */
     const SpaceInfo *findVarType(const SpaceInfo *start, const Token *type) const;
 
+    /**
+     * @brief A function call. Every "%var% (" that doesn't start a function
+     * body is a call, so function declarations are calls too.
+     */
+    struct CallSite
+    {
+        /** @brief function name token */
+        const Token *tok;
+
+        /** @brief innermost function that the call is in, NULL if it is not in a function */
+        const SpaceInfo *caller;
+
+        /** @brief position among all calls, in token order */
+        unsigned int index;
+    };
+
+    /**
+     * @brief find the first function implementation with the given name
+     * @param funcname function name
+     * @return function scope or NULL if not found
+     */
+    const SpaceInfo *findFunctionScope(const std::string &funcname) const;
+
+    /**
+     * @brief get the calls to functions with the given name
+     * @param funcname function name
+     * @return the calls in token order
+     */
+    const std::vector<CallSite> &getCallSites(const std::string &funcname) const;
+
+    /**
+     * @brief get the calls to any of the given functions
+     * @param funcnames function names separated with "|", for example "scanf|fscanf"
+     * @return the calls in token order
+     */
+    std::vector<CallSite> findCallSites(const std::string &funcnames) const;
+
+    /**
+     * @brief get the calls in a function
+     * @param caller function scope
+     * @return the calls in token order
+     */
+    const std::vector<CallSite> &getCalls(const SpaceInfo *caller) const;
+
+    /**
+     * @brief get the calls to all functions
+     * @return calls, the key is the function name
+     */
+    const std::map<std::string, std::vector<CallSite> > &getAllCallSites() const;
+
 private:
 
+    /** @brief create the call graph, it is created the first time it is used */
+    void createCallGraph() const;
+
+    /** @brief has the call graph been created? */
+    mutable bool _callGraph;
+
+    /** @brief first function implementation for each function name */
+    mutable std::map<std::string, const SpaceInfo *> _functionScopes;
+
+    /** @brief calls by function name */
+    mutable std::map<std::string, std::vector<CallSite> > _callSites;
+
+    /** @brief calls by caller */
+    mutable std::map<const SpaceInfo *, std::vector<CallSite> > _calls;
+
     // Needed by Borland C++:
     friend class SpaceInfo;
 
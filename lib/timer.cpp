@@ -51,6 +51,9 @@ void TimerResults::ShowResults()
 
     const double secOverall = (double)overallClocks / CLOCKS_PER_SEC;
     std::cout << "Overall time: " << secOverall << "s" << std::endl;
+
+    for (std::map<std::string, unsigned long>::const_iterator it = _counts.begin(); it != _counts.end(); ++it)
+        std::cout << it->first << ": " << it->second << std::endl;
 }
 
 void TimerResults::AddResults(const std::string& str, std::clock_t clocks)
@@ -59,6 +62,11 @@ void TimerResults::AddResults(const std::string& str, std::clock_t clocks)
     _results[str]._numberOfResults++;
 }
 
+void TimerResults::AddCount(const std::string& str, unsigned long count)
+{
+    _counts[str] += count;
+}
+
 Timer::Timer(const std::string& str, unsigned int showtimeMode, TimerResultsIntf* timerResults)
     : _str(str)
     , _showtimeMode(showtimeMode)
@@ -96,3 +104,11 @@ void Timer::Stop()
 
     _stopped = true;
 }
+
+void Timer::Count(const std::string& str, unsigned long count, unsigned int showtimeMode, TimerResultsIntf* timerResults)
+{
+    if (showtimeMode == SHOWTIME_FILE)
+        std::cout << str << ": " << count << std::endl;
+    else if (showtimeMode != SHOWTIME_NONE && timerResults)
+        timerResults->AddCount(str, count);
+}
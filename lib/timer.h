@@ -37,6 +37,7 @@ public:
     virtual ~TimerResultsIntf() { }
 
     virtual void AddResults(const std::string& str, std::clock_t clocks) = 0;
+    virtual void AddCount(const std::string& str, unsigned long count) = 0;
 };
 
 struct TimerResultsData
@@ -60,9 +61,11 @@ public:
 
     void ShowResults();
     virtual void AddResults(const std::string& str, std::clock_t clocks);
+    virtual void AddCount(const std::string& str, unsigned long count);
 
 private:
     std::map<std::string, struct TimerResultsData> _results;
+    std::map<std::string, unsigned long> _counts;
 };
 
 class Timer
@@ -72,6 +75,9 @@ public:
     ~Timer();
     void Stop();
 
+    /** Show a counter value, such as the number of iterations of some algorithm */
+    static void Count(const std::string& str, unsigned long count, unsigned int showtimeMode, TimerResultsIntf* timerResults);
+
 private:
     Timer& operator=(const Timer&); // disallow assignments
 
@@ -44,6 +44,7 @@ Token::Token(Token **t) :
     _link(0),
     _fileIndex(0),
     _linenr(0),
+    _numericValueValid(false),
     _progressValue(0)
 {
 }
@@ -56,6 +57,7 @@ Token::~Token()
 void Token::str(const std::string &s)
 {
     _str = s;
+    _numericValueValid = false;
 
     _isName = bool(_str[0] == '_' || std::isalpha(_str[0]));
 
@@ -78,6 +80,7 @@ void Token::concatStr(std::string const& b)
 {
     _str.erase(_str.length() - 1);
     _str.append(b.begin() + 1, b.end());
+    _numericValueValid = false;
 }
 
 std::string Token::strValue() const
@@ -104,6 +107,8 @@ void Token::deleteThis()
     if (_next)
     {
         _str = _next->_str;
+        _numericValue = _next->_numericValue;
+        _numericValueValid = _next->_numericValueValid;
         _isName = _next->_isName;
         _isNumber = _next->_isNumber;
         _isBoolean = _next->_isBoolean;
@@ -197,6 +202,30 @@ std::string Token::strAt(int index) const
     return tok ? tok->_str.c_str() : "";
 }
 
+const MathLib::Value &Token::numericValue() const
+{
+    if (!_numericValueValid)
+    {
+        _numericValue = MathLib::Value(_str);
+        _numericValueValid = true;
+    }
+    return _numericValue;
+}
+
+void Token::numericValue(const MathLib::Value &value)
+{
+    str(value.str());
+
+    // Floating point values are rounded when they are converted to
+    // strings. The value is parsed from the string when it is needed so
+    // it is the same as the string.
+    if (!value.isFloat())
+    {
+        _numericValue = value;
+        _numericValueValid = true;
+    }
+}
+
 int Token::multiCompare(const char *haystack, const char *needle)
 {
     bool emptyStringFound = false;
@@ -21,6 +21,7 @@
 
 #include <string>
 #include <vector>
+#include "mathlib.h"
 
 /// @addtogroup Core
 /// @{
@@ -71,6 +72,20 @@ public:
 
     std::string strAt(int index) const;
 
+    /**
+     * Get the value of a number token. The string is parsed the first
+     * time the value is needed, after that the value is cached.
+     * Should be called for %num% tokens only.
+     */
+    const MathLib::Value &numericValue() const;
+
+    /**
+     * Set the string of a number token from a calculated value. Integer
+     * values are cached so they are not parsed again.
+     * @param value calculated value
+     */
+    void numericValue(const MathLib::Value &value);
+
     /**
      * Match given token (or list of tokens) to a pattern list.
      *
@@ -402,6 +417,12 @@ private:
     unsigned int _fileIndex;
     unsigned int _linenr;
 
+    /** Cached value of a number token, see numericValue() */
+    mutable MathLib::Value _numericValue;
+
+    /** Is _numericValue valid? */
+    mutable bool _numericValueValid;
+
     /**
      * A value from 0-100 that provides a rough idea about where in the token
      * list this token is located.
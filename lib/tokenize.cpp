@@ -31,6 +31,8 @@
 #include "check.h"
 #include "path.h"
 #include "symboldatabase.h"
+#include "timer.h"
+#include "sourcelocations.h"
 
 #include <locale>
 #include <fstream>
@@ -45,6 +47,10 @@
 #include <stack>
 #include <stdexcept>    // for std::runtime_error
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 //---------------------------------------------------------------------------
 
 Tokenizer::Tokenizer()
@@ -59,6 +65,12 @@ Tokenizer::Tokenizer()
 
     // symbol database
     _symbolDatabase = NULL;
+
+    // counters for --showtime
+    _timerResults = NULL;
+
+    // locations of the lines
+    _locations = NULL;
 }
 
 Tokenizer::Tokenizer(const Settings *settings, ErrorLogger *errorLogger)
@@ -76,6 +88,12 @@ Tokenizer::Tokenizer(const Settings *settings, ErrorLogger *errorLogger)
 
     // symbol database
     _symbolDatabase = NULL;
+
+    // counters for --showtime
+    _timerResults = NULL;
+
+    // locations of the lines
+    _locations = NULL;
 }
 
 Tokenizer::~Tokenizer()
@@ -135,25 +153,27 @@ void Tokenizer::addtoken(const char str[], const unsigned int lineno, const unsi
     }
 
     // Replace hexadecimal value with decimal
-    std::ostringstream str2;
-    if (strncmp(str, "0x", 2) == 0 || strncmp(str, "0X", 2) == 0)
+    std::string str2;
+    if (str[0] == '0' && (str[1] == 'x' || str[1] == 'X'))
     {
-        str2 << std::strtoul(str + 2, NULL, 16);
+        std::ostringstream ostr;
+        ostr << std::strtoul(str + 2, NULL, 16);
+        str2 = ostr.str();
     }
     else
     {
-        str2 << str;
+        str2 = str;
     }
 
     if (_tokensBack)
     {
-        _tokensBack->insertToken(str2.str().c_str());
+        _tokensBack->insertToken(str2);
     }
     else
     {
         _tokens = new Token(&_tokensBack);
         _tokensBack = _tokens;
-        _tokensBack->str(str2.str());
+        _tokensBack->str(str2);
     }
 
     _tokensBack->linenr(lineno);
@@ -251,169 +271,223 @@ void Tokenizer::insertTokens(Token *dest, const Token *src, unsigned int n)
 // Tokenize - tokenizes a given file.
 //---------------------------------------------------------------------------
 
+/** Character classes for Tokenizer::createTokens() */
+class TokenChars
+{
+public:
+    enum Type { Other = 0, Separator, Quote };
+
+    TokenChars()
+    {
+        for (unsigned int c = 0; c < 256; ++c)
+            _type[c] = Other;
+
+        // the null character separates tokens too
+        const char separators[] = "+-*/%&|^?!=<>[](){};:,.~\n ";
+        for (unsigned int i = 0; i < sizeof(separators); ++i)
+            _type[(unsigned char)separators[i]] = Separator;
+
+        _type[(unsigned char)'\''] = Quote;
+        _type[(unsigned char)'\"'] = Quote;
+    }
+
+    Type type(char c) const
+    {
+        return _type[(unsigned char)c];
+    }
+
+private:
+    Type _type[256];
+};
+
+#ifdef __SSE2__
+/**
+ * Number of identifier characters [A-Za-z0-9_] at the start of the buffer.
+ * These are all TokenChars::Other characters. 16 characters are
+ * classified at a time.
+ * @param buf the buffer
+ * @param size size of the buffer
+ * @return number of identifier characters
+ */
+static std::string::size_type identifierLength(const char *buf, std::string::size_type size)
+{
+    // c is in the range [lo, hi] if (c + 128 - lo) is less than (hi - lo + 1 - 128) as a signed char
+    const __m128i lowerOffset = _mm_set1_epi8((char)(128 - 'a'));
+    const __m128i lowerLimit = _mm_set1_epi8((char)('z' - 'a' + 1 - 128));
+    const __m128i digitOffset = _mm_set1_epi8((char)(128 - '0'));
+    const __m128i digitLimit = _mm_set1_epi8((char)('9' - '0' + 1 - 128));
+    const __m128i caseBit = _mm_set1_epi8(0x20);
+    const __m128i underscore = _mm_set1_epi8('_');
+
+    std::string::size_type pos = 0;
+    while (pos + 16 <= size)
+    {
+        const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i *>(buf + pos));
+
+        // 'A'-'Z' are 'a'-'z' with the case bit set. No other character is.
+        const __m128i letter = _mm_cmplt_epi8(_mm_add_epi8(_mm_or_si128(c, caseBit), lowerOffset), lowerLimit);
+        const __m128i digit = _mm_cmplt_epi8(_mm_add_epi8(c, digitOffset), digitLimit);
+        const __m128i identifier = _mm_or_si128(_mm_or_si128(letter, digit), _mm_cmpeq_epi8(c, underscore));
+
+        // __SSE2__ is only defined by gcc and clang so __builtin_ctz can be used
+        const unsigned int mask = (unsigned int)_mm_movemask_epi8(identifier);
+        if (mask != 0xffff)
+            return pos + (std::string::size_type)__builtin_ctz(~mask);
+        pos += 16;
+    }
+    return pos;
+}
+#endif
+
+unsigned int Tokenizer::getFileIndex(const std::string &filename)
+{
+    // Has this file been tokenized already?
+    for (unsigned int i = 0; i < _files.size(); i++)
+    {
+        if (getFileLister()->sameFileName(_files[i].c_str(), filename.c_str()))
+            return i;
+    }
+
+    // The "_files" vector remembers what files have been tokenized..
+    _files.push_back(Path::simplifyPath(filename.c_str()));
+    return static_cast<unsigned int>(_files.size() - 1);
+}
+
 void Tokenizer::createTokens(std::istream &code)
 {
-    // line number in parsed code
+    // The code is read into a buffer and the tokens are scanned from it
+    std::string buffer;
+    {
+        std::ostringstream ostr;
+        ostr << code.rdbuf();
+        buffer = ostr.str();
+    }
+    const char * const buf = buffer.c_str();
+    const std::string::size_type size = buffer.size();
+
+    static const TokenChars tokenChars;
+
+    // line number in the file
     unsigned int lineno = 1;
 
     // The current token being parsed
     std::string CurrentToken;
 
-    // lineNumbers holds line numbers for files in fileIndexes
-    // every time an include file is completely parsed, last item in the vector
-    // is removed and lineno is set to point to that value.
-    std::vector<unsigned int> lineNumbers;
-
-    // fileIndexes holds index for _files vector about currently parsed files
-    // every time an include file is completely parsed, last item in the vector
-    // is removed and FileIndex is set to point to that value.
-    std::vector<unsigned int> fileIndexes;
-
     // FileIndex. What file in the _files vector is read now?
     unsigned int FileIndex = 0;
 
-    // Read one byte at a time from code and create tokens
-    for (char ch = (char)code.get(); code.good(); ch = (char)code.get())
+    // The ranges of lines from the included files. A range starts at
+    // a line of the code and it lasts until the next range starts.
+    const std::vector<SourceLocations::Range> noRanges;
+    const std::vector<SourceLocations::Range> &ranges = _locations ? _locations->ranges() : noRanges;
+    std::vector<SourceLocations::Range>::const_iterator range = ranges.begin();
+
+    // line number in the code
+    unsigned int codeLine = 1;
+    for (; range != ranges.end() && range->line <= codeLine; ++range)
     {
+        FileIndex = (range->file == 0) ? 0 : getFileIndex(_locations->files()[range->file]);
+        lineno = range->fileLine;
+    }
+
+    std::string::size_type pos = 0;
+    while (pos < size)
+    {
+        const char ch = buf[pos];
+        const TokenChars::Type type = tokenChars.type(ch);
+
+        // Characters that belong to the current token..
+        if (type == TokenChars::Other)
+        {
+            const std::string::size_type start = pos;
+            ++pos;
+#ifdef __SSE2__
+            pos += identifierLength(buf + pos, size - pos);
+#endif
+            while (pos < size && tokenChars.type(buf[pos]) == TokenChars::Other)
+                ++pos;
+            CurrentToken.append(buf + start, pos - start);
+            continue;
+        }
+
         // char/string..
         // multiline strings are not handled. The preprocessor should handle that for us.
-        if (ch == '\'' || ch == '\"')
+        if (type == TokenChars::Quote)
         {
-            std::string line;
-
-            // read char
+            // Find the end of the string. The ending quote is not read
+            // again if it's missing.
+            const std::string::size_type start = pos;
             bool special = false;
-            char c = ch;
-            do
-            {
-                // Append token..
-                line += c;
-
-                // Special sequence '\.'
-                if (special)
-                    special = false;
-                else
-                    special = (c == '\\');
-
-                // Get next character
-                c = (char)code.get();
-            }
-            while (code.good() && (special || c != ch));
+            while (++pos < size && (special || buf[pos] != ch))
+                special = !special && (buf[pos] == '\\');
+            std::string line(buf + start, pos - start);
             line += ch;
+            if (pos < size)
+                ++pos;
 
-            // Handle #file "file.h"
-            if (CurrentToken == "#file")
-            {
-                // Extract the filename
-                line = line.substr(1, line.length() - 2);
+            // Add previous token
+            addtoken(CurrentToken.c_str(), lineno, FileIndex);
 
-                // Has this file been tokenized already?
-                ++lineno;
-                bool foundOurfile = false;
-                fileIndexes.push_back(FileIndex);
-                for (unsigned int i = 0; i < _files.size(); i++)
-                {
-                    if (getFileLister()->sameFileName(_files[i].c_str(), line.c_str()))
-                    {
-                        // Use this index
-                        foundOurfile = true;
-                        FileIndex = i;
-                    }
-                }
-
-                if (!foundOurfile)
-                {
-                    // The "_files" vector remembers what files have been tokenized..
-                    _files.push_back(Path::simplifyPath(line.c_str()));
-                    FileIndex = static_cast<unsigned int>(_files.size() - 1);
-                }
-
-                lineNumbers.push_back(lineno);
-                lineno = 0;
-            }
-            else
-            {
-                // Add previous token
-                addtoken(CurrentToken.c_str(), lineno, FileIndex);
-
-                // Add content of the string
-                addtoken(line.c_str(), lineno, FileIndex);
-            }
+            // Add content of the string
+            addtoken(line.c_str(), lineno, FileIndex);
 
             CurrentToken.clear();
 
             continue;
         }
 
-        if (strchr("+-*/%&|^?!=<>[](){};:,.~\n ", ch))
-        {
-            if (ch == '.' &&
-                CurrentToken.length() > 0 &&
-                std::isdigit(CurrentToken[0]))
-            {
-                // Don't separate doubles "5.4"
-            }
-            else if (strchr("+-", ch) &&
-                     CurrentToken.length() > 0 &&
-                     std::isdigit(CurrentToken[0]) &&
-                     (CurrentToken[CurrentToken.length()-1] == 'e' ||
-                      CurrentToken[CurrentToken.length()-1] == 'E'))
-            {
-                // Don't separate doubles "4.2e+10"
-            }
-            else if (ch=='&' && CurrentToken.empty() && code.peek() == '&')
-            {
-                // &&
-                ch = (char)code.get();
-                addtoken("&&", lineno, FileIndex, true);
-                continue;
-            }
-            else
-            {
-                if (CurrentToken == "#file")
-                {
-                    // Handle this where strings are handled
-                    continue;
-                }
-                else if (CurrentToken == "#endfile")
-                {
-                    if (lineNumbers.empty() || fileIndexes.empty())
-                    {
-                        cppcheckError(0);
-                        deallocateTokens();
-                        return;
-                    }
-
-                    lineno = lineNumbers.back();
-                    lineNumbers.pop_back();
-                    FileIndex = fileIndexes.back();
-                    fileIndexes.pop_back();
-                    CurrentToken.clear();
-                    continue;
-                }
+        ++pos;
 
-                addtoken(CurrentToken.c_str(), lineno, FileIndex, true);
+        if (ch == '.' &&
+            CurrentToken.length() > 0 &&
+            std::isdigit(CurrentToken[0]))
+        {
+            // Don't separate doubles "5.4"
+        }
+        else if (strchr("+-", ch) &&
+                 CurrentToken.length() > 0 &&
+                 std::isdigit(CurrentToken[0]) &&
+                 (CurrentToken[CurrentToken.length()-1] == 'e' ||
+                  CurrentToken[CurrentToken.length()-1] == 'E'))
+        {
+            // Don't separate doubles "4.2e+10"
+        }
+        else if (ch=='&' && CurrentToken.empty() && pos < size && buf[pos] == '&')
+        {
+            // &&
+            ++pos;
+            addtoken("&&", lineno, FileIndex, true);
+            continue;
+        }
+        else
+        {
+            addtoken(CurrentToken.c_str(), lineno, FileIndex, true);
 
-                CurrentToken.clear();
+            CurrentToken.clear();
 
-                if (ch == '\n')
-                {
-                    ++lineno;
-                    continue;
-                }
-                else if (ch == ' ')
+            if (ch == '\n')
+            {
+                ++lineno;
+                ++codeLine;
+                for (; range != ranges.end() && range->line <= codeLine; ++range)
                 {
-                    continue;
+                    FileIndex = (range->file == 0) ? 0 : getFileIndex(_locations->files()[range->file]);
+                    lineno = range->fileLine;
                 }
-
-                CurrentToken += ch;
-                // Add "++", "--" or ">>" token
-                if ((ch == '+' || ch == '-' || ch == '>') && (code.peek() == ch))
-                    CurrentToken += (char)code.get();
-                addtoken(CurrentToken.c_str(), lineno, FileIndex);
-                CurrentToken.clear();
                 continue;
             }
+            else if (ch == ' ' || ch == '\0')
+            {
+                continue;
+            }
+
+            CurrentToken += ch;
+            // Add "++", "--" or ">>" token
+            if ((ch == '+' || ch == '-' || ch == '>') && pos < size && buf[pos] == ch)
+                CurrentToken += buf[pos++];
+            addtoken(CurrentToken.c_str(), lineno, FileIndex);
+            CurrentToken.clear();
+            continue;
         }
 
         CurrentToken += ch;
@@ -700,6 +774,17 @@ struct SpaceInfo
 
 void Tokenizer::simplifyTypedef()
 {
+    // How many times each name is used. A typedef name that is used only
+    // in the typedef itself doesn't need to be searched for. The
+    // substitutions only copy existing tokens so a name that is used once
+    // can't appear later.
+    std::map<std::string, unsigned int> nameCount;
+    for (const Token *tok = _tokens; tok; tok = tok->next())
+    {
+        if (tok->isName())
+            ++nameCount[tok->str()];
+    }
+
     std::vector<SpaceInfo> spaceInfo;
     bool isNamespace = false;
     std::string className;
@@ -1130,7 +1215,13 @@ void Tokenizer::simplifyTypedef()
             int memberScope = 0;
             std::size_t classLevel = spaceInfo.size();
 
-            for (Token *tok2 = tok; tok2; tok2 = tok2->next())
+            // first name in the pattern
+            std::string patternStart(typeName->str());
+
+            // the typedef is not used
+            const bool unused(nameCount[typeName->str()] <= 1);
+
+            for (Token *tok2 = unused ? 0 : tok; tok2; tok2 = tok2->next())
             {
                 // check for end of scope
                 if (tok2->str() == "}")
@@ -1152,6 +1243,7 @@ void Tokenizer::simplifyTypedef()
                             pattern += (spaceInfo[i].className + " :: ");
 
                         pattern += typeName->str();
+                        patternStart = pattern.substr(0, pattern.find(" "));
                     }
                     else
                     {
@@ -1168,7 +1260,7 @@ void Tokenizer::simplifyTypedef()
                 }
 
                 // check for member functions
-                else if (Token::Match(tok2, ") const| {"))
+                else if (tok2->str() == ")" && Token::Match(tok2, ") const| {"))
                 {
                     const Token *func = tok2->link()->previous();
 
@@ -1200,7 +1292,7 @@ void Tokenizer::simplifyTypedef()
                 }
 
                 // check for typedef that can be substituted
-                else if (Token::Match(tok2, pattern.c_str()) ||
+                else if ((tok2->str() == patternStart && Token::Match(tok2, pattern.c_str())) ||
                          (inMemberFunc && tok2->str() == typeName->str()))
                 {
                     std::string pattern1;
@@ -2759,6 +2851,21 @@ void Tokenizer::simplifyTemplates()
     }
 
 
+    // Limits for the instantiation. Recursive templates such as
+    // "template<int N> struct F { F<N-1> f; };" are otherwise instantiated
+    // until the memory runs out.
+    const unsigned int maxInstantiationDepth = 100;
+    const unsigned int maxInstantiations = 1000;
+
+    // How deeply nested each template usage is. The usages in the original
+    // code are not stored here, their depth is 0.
+    std::map<const Token *, unsigned int> usageDepth;
+
+    // counters for --showtime
+    unsigned long instantiations = 0;
+    unsigned long reusedInstantiations = 0;
+    bool limitReached = false;
+
     // expand templates
     bool done = false;
     //while (!done)
@@ -2828,21 +2935,14 @@ void Tokenizer::simplifyTemplates()
             const std::string pattern(s + "> ");
 
             std::string::size_type sz1 = used.size();
-            unsigned int recursiveCount = 0;
 
-            for (std::list<Token *>::iterator iter2 = used.begin(); iter2 != used.end(); ++iter2)
+            for (std::list<Token *>::iterator iter2 = used.begin(); iter2 != used.end() && !limitReached; ++iter2)
             {
                 // If the size of "used" has changed, simplify calculations
                 if (sz1 != used.size())
                 {
                     sz1 = used.size();
                     simplifyCalculations();
-                    recursiveCount++;
-                    if (recursiveCount > 100)
-                    {
-                        // bail out..
-                        break;
-                    }
                 }
 
                 Token * const tok2 = *iter2;
@@ -2906,9 +3006,24 @@ void Tokenizer::simplifyTemplates()
                 // New classname/funcname..
                 const std::string name2(name + "<" + type2 + ">");
 
-                if (expandedtemplates.find(name2) == expandedtemplates.end())
+                // Nesting depth for usages in the new instantiation
+                std::map<const Token *, unsigned int>::const_iterator it = usageDepth.find(tok2);
+                const unsigned int depth = (it == usageDepth.end() ? 0 : it->second) + 1;
+
+                if (expandedtemplates.find(name2) != expandedtemplates.end())
+                    ++reusedInstantiations;
+
+                else if (depth > maxInstantiationDepth || instantiations >= maxInstantiations)
+                {
+                    templateInstantiationLimitError(tok2, name2);
+                    limitReached = true;
+                    break;
+                }
+
+                else
                 {
                     expandedtemplates.insert(name2);
+                    ++instantiations;
                     // Copy template..
                     int _indentlevel = 0;
                     int _parlevel = 0;
@@ -2997,6 +3112,7 @@ void Tokenizer::simplifyTemplates()
                                 if (!Token::Match(tok3, (name + " <").c_str()))
                                     done = false;
                                 used.push_back(_tokensBack);
+                                usageDepth[_tokensBack] = depth;
                             }
 
                             // link() newly tokens manually
@@ -3068,9 +3184,11 @@ void Tokenizer::simplifyTemplates()
                             while (tok4->next()->str() != ">")
                             {
                                 used.remove(tok4->next());
+                                usageDepth.erase(tok4->next());
                                 tok4->deleteNext();
                             }
                             used.remove(tok4->next());
+                            usageDepth.erase(tok4->next());
                             tok4->deleteNext();
                         }
                     }
@@ -3079,6 +3197,12 @@ void Tokenizer::simplifyTemplates()
         }
     }
 
+    if (_settings)
+    {
+        Timer::Count("Tokenizer::simplifyTemplates: instantiations", instantiations, _settings->_showtime, _timerResults);
+        Timer::Count("Tokenizer::simplifyTemplates: reused instantiations", reusedInstantiations, _settings->_showtime, _timerResults);
+    }
+
     removeTemplates(_tokens);
 }
 //---------------------------------------------------------------------------
@@ -3135,12 +3259,50 @@ std::string Tokenizer::getNameForFunctionParams(const Token *start)
     return result;
 }
 
+/** compare the indexes of two tokens in the name index that setVarId uses */
+static bool tokenIndexLess(const std::pair<unsigned int, Token *> &a, const std::pair<unsigned int, Token *> &b)
+{
+    return a.first < b.first;
+}
+
 void Tokenizer::setVarId()
 {
+    // The occurrences are indexed again when they are needed
+    _varOccurrences.clear();
+
     // Clear all variable ids
     for (Token *tok = _tokens; tok; tok = tok->next())
         tok->varId(0);
 
+    // Index the name tokens and the blocks. When a variable is declared
+    // in a block its tokens are looked up in the index instead of scanning
+    // the rest of the block for each declaration.
+    std::map<std::string, std::vector<std::pair<unsigned int, Token *> > > nameIndex;
+    std::map<const Token *, unsigned int> blockEnd;
+    {
+        std::stack<const Token *> blocks;
+        unsigned int index = 0;
+        for (Token *tok = _tokens; tok; tok = tok->next(), ++index)
+        {
+            if (tok->isName())
+                nameIndex[tok->str()].push_back(std::make_pair(index, tok));
+            else if (tok->str() == "{")
+                blocks.push(tok);
+            else if (tok->str() == "}" && !blocks.empty())
+            {
+                blockEnd[blocks.top()] = index;
+                blocks.pop();
+            }
+        }
+    }
+
+    // Open brackets before the current declaration. Updated when a
+    // declaration is found.
+    std::vector<const Token *> brackets;
+    const Token *bracketTok = _tokens;
+    unsigned int bracketIndex = 0;
+    bool balanced = true;
+
     // Set variable ids..
     unsigned int _varId = 0;
     for (Token *tok = _tokens; tok; tok = tok->next())
@@ -3336,6 +3498,45 @@ void Tokenizer::setVarId()
         if (Token::Match(tok2, "[,();[=]") && !varname.empty())
         {
             ++_varId;
+
+            // Which brackets are open at the declaration?
+            for (; bracketTok != tok->next(); bracketTok = bracketTok->next(), ++bracketIndex)
+            {
+                const std::string &str = bracketTok->str();
+                if (str == "{" || str == "(")
+                    brackets.push_back(bracketTok);
+                else if (str == "}" || str == ")")
+                {
+                    if (brackets.empty() || brackets.back()->str() != (str == "}" ? "{" : "("))
+                        balanced = false;
+                    else
+                        brackets.pop_back();
+                }
+            }
+
+            // Declared in a block => the variable is used until the end of
+            // the block. Set the variable id for the indexed tokens.
+            if (balanced && (brackets.empty() || brackets.back()->str() == "{"))
+            {
+                const std::map<const Token *, unsigned int>::const_iterator end =
+                    brackets.empty() ? blockEnd.end() : blockEnd.find(brackets.back());
+                if (brackets.empty() || end != blockEnd.end())
+                {
+                    const unsigned int endIndex = brackets.empty() ? ~0U : end->second;
+                    const std::vector<std::pair<unsigned int, Token *> > &occurrences = nameIndex[varname];
+                    std::vector<std::pair<unsigned int, Token *> >::const_iterator it;
+                    it = std::upper_bound(occurrences.begin(), occurrences.end(), std::make_pair(bracketIndex - 1, (Token *)0), tokenIndexLess);
+                    for (; it != occurrences.end() && it->first < endIndex; ++it)
+                    {
+                        Token * const tok3 = it->second;
+                        const std::string &prev = tok3->strAt(-1);
+                        if (prev != "struct" && prev != "union" && prev != "::" && prev != "." && tok3->strAt(1) != "::")
+                            tok3->varId(_varId);
+                    }
+                    continue;
+                }
+            }
+
             int indentlevel = 0;
             int parlevel = 0;
             bool funcDeclaration = false;
@@ -3377,23 +3578,45 @@ void Tokenizer::setVarId()
     }
 
     // Struct/Class members
-    for (Token *tok = _tokens; tok; tok = tok->next())
     {
-        // str.clear is a variable
-        // str.clear() is a member function
-        if (tok->varId() != 0 &&
-            Token::Match(tok->next(), ". %var% !!(") &&
-            tok->tokAt(2)->varId() == 0)
+        // The tokens for each variable id. The tokens that have been
+        // passed are skipped.
+        std::vector<std::vector<Token *> > varTokens(_varId + 1);
+        std::vector<unsigned int> passed(_varId + 1, 0);
+        for (Token *tok = _tokens; tok; tok = tok->next())
         {
-            ++_varId;
+            if (tok->varId() != 0)
+                varTokens[tok->varId()].push_back(tok);
+        }
 
-            const std::string pattern(std::string(". ") + tok->strAt(2));
-            for (Token *tok2 = tok; tok2; tok2 = tok2->next())
+        for (Token *tok = _tokens; tok; tok = tok->next())
+        {
+            const unsigned int varid = tok->varId();
+            if (varid == 0)
+                continue;
+
+            const std::vector<Token *> &tokens = varTokens[varid];
+            while (passed[varid] < tokens.size() && tokens[passed[varid]] != tok)
+                ++passed[varid];
+
+            // str.clear is a variable
+            // str.clear() is a member function
+            if (Token::Match(tok->next(), ". %var% !!(") &&
+                tok->tokAt(2)->varId() == 0)
             {
-                if (tok2->varId() == tok->varId())
+                ++_varId;
+                varTokens.push_back(std::vector<Token *>());
+                passed.push_back(0);
+
+                const std::string &membername = tok->strAt(2);
+                for (unsigned int i = passed[varid]; i < varTokens[varid].size(); ++i)
                 {
-                    if (Token::Match(tok2->next(), pattern.c_str()))
+                    Token * const tok2 = varTokens[varid][i];
+                    if (tok2->varId() == varid && Token::simpleMatch(tok2->next(), ".") && tok2->strAt(2) == membername)
+                    {
                         tok2->tokAt(2)->varId(_varId);
+                        varTokens[_varId].push_back(tok2->tokAt(2));
+                    }
                 }
             }
         }
@@ -3901,6 +4124,7 @@ bool Tokenizer::simplifyTokenList()
     // clear the _functionList so it can't contain dead pointers
     delete _symbolDatabase;
     _symbolDatabase = NULL;
+    _varOccurrences.clear();
 
     for (Token *tok = _tokens; tok; tok = tok->next())
     {
@@ -4843,14 +5067,14 @@ bool Tokenizer::simplifyConditions()
 
                 if (cmp == "==" || cmp == "!=")
                 {
-                    const std::string op1(tok->strAt(1));
-                    const std::string op2(tok->strAt(3));
+                    const MathLib::Value &op1(tok->tokAt(1)->numericValue());
+                    const MathLib::Value &op2(tok->tokAt(3)->numericValue());
 
                     bool eq = false;
-                    if (MathLib::isInt(op1) && MathLib::isInt(op2))
-                        eq = (MathLib::toLongNumber(op1) == MathLib::toLongNumber(op2));
+                    if (!op1.isFloat() && !op2.isFloat())
+                        eq = (op1.getInt() == op2.getInt());
                     else
-                        eq = (op1 == op2);
+                        eq = (tok->strAt(1) == tok->strAt(3));
 
                     if (cmp == "==")
                         result = eq;
@@ -4859,8 +5083,8 @@ bool Tokenizer::simplifyConditions()
                 }
                 else
                 {
-                    double op1 = MathLib::toDoubleNumber(tok->strAt(1));
-                    double op2 = MathLib::toDoubleNumber(tok->strAt(3));
+                    double op1 = tok->tokAt(1)->numericValue().getDouble();
+                    double op2 = tok->tokAt(3)->numericValue().getDouble();
                     if (cmp == ">=")
                         result = (op1 >= op2);
                     else if (cmp == ">")
@@ -6086,11 +6310,44 @@ bool Tokenizer::simplifyKnownVariables()
         if (! Token::Match(tok, ") const| {"))
             continue;
 
+        // Count the uses of each variable in the block. When a known value
+        // is propagated the scan can stop after the last use instead of
+        // walking to the end of the block.
+        std::map<unsigned int, unsigned int> varUses;
+        {
+            const Token * const start = tok->next()->str() == "{" ? tok->next() : tok->tokAt(2);
+            for (const Token *tok2 = start; tok2 && tok2 != start->link(); tok2 = tok2->next())
+            {
+                if (tok2->varId())
+                    ++varUses[tok2->varId()];
+            }
+        }
+
+        // Variables that have been propagated into other variables. Their
+        // use count is not reliable.
+        std::set<unsigned int> aliased;
+
         // parse the block of code..
         int indentlevel = 0;
         Token *tok2 = tok;
         for (; tok2; tok2 = tok2->next())
         {
+            if (tok2->varId() && varUses[tok2->varId()] > 0)
+                --varUses[tok2->varId()];
+
+            // Known values might have been propagated into this assignment.
+            // Calculate it so the result is propagated in this same pass.
+            if (Token::Match(tok2->previous(), "[;{}] %var% = %num% +|-|* %num% ;") &&
+                !tok2->tokAt(2)->numericValue().isFloat() &&
+                !tok2->tokAt(4)->numericValue().isFloat())
+            {
+                Token * const op1 = tok2->tokAt(2);
+                op1->numericValue(MathLib::calculate(op1->numericValue(), op1->tokAt(2)->numericValue(), op1->strAt(1)[0], this));
+                op1->deleteNext();
+                op1->deleteNext();
+                ret = true;
+            }
+
             if (tok2->str() == "{")
                 ++indentlevel;
 
@@ -6205,8 +6462,29 @@ bool Tokenizer::simplifyKnownVariables()
                 Token* bailOutFromLoop = 0;
                 int indentlevel3 = indentlevel;     // indentlevel for tok3
                 bool ret3 = false;
+
+                // Uses of the variable after the assignment. The pointer
+                // declaration is removed at the end of the scope so then the
+                // whole scope must be scanned.
+                if (valueVarId)
+                    aliased.insert(valueVarId);
+                unsigned int uses = varUses[varid];
+                const bool scanWholeScope(aliased.find(varid) != aliased.end() ||
+                                          Token::Match(tok2->tokAt(-7), "%type% * %var% ; %var% = & %var% ;"));
+                bool lastUse = false;
+
                 for (; tok3; tok3 = tok3->next())
                 {
+                    if (!scanWholeScope && uses == 0)
+                    {
+                        // the last use has been handled
+                        if (lastUse)
+                            break;
+                        lastUse = true;
+                    }
+                    if (uses > 0 && tok3->next() && tok3->next()->varId() == varid)
+                        --uses;
+
                     if (tok3->str() == "{")
                     {
                         ++indentlevel3;
@@ -6233,7 +6511,7 @@ bool Tokenizer::simplifyKnownVariables()
                     // Stop if return or break is found ..
                     if (tok3->str() == "break")
                         break;
-                    if ((indentlevel3 > 1 || !Token::simpleMatch(Token::findmatch(tok3,";"), "; }")) && tok3->str() == "return")
+                    if (tok3->str() == "return" && (indentlevel3 > 1 || !Token::simpleMatch(Token::findmatch(tok3,";"), "; }")))
                         ret3 = true;
                     if (ret3 && tok3->str() == ";")
                         break;
@@ -6294,6 +6572,17 @@ bool Tokenizer::simplifyKnownVariables()
                         continue;
                     }
 
+                    // The patterns below all need the variable within the
+                    // next few tokens. Skip the matching when it is not there.
+                    if (tok3->str() != "for")
+                    {
+                        const Token *tok4 = tok3;
+                        for (int i = 0; i < 6 && tok4 && tok4->varId() != varid; ++i)
+                            tok4 = tok4->next();
+                        if (!tok4 || tok4->varId() != varid)
+                            continue;
+                    }
+
                     // Variable used in realloc (see Ticket #1649)
                     if (Token::Match(tok3, "%var% = realloc ( %var% ,") &&
                         tok3->varId() == varid &&
@@ -6820,16 +7109,16 @@ bool Tokenizer::simplifyCalculations()
             }
 
             if (Token::Match(tok, "%num% ==|!=|<=|>=|<|> %num%") &&
-                MathLib::isInt(tok->str()) &&
-                MathLib::isInt(tok->tokAt(2)->str()))
+                !tok->numericValue().isFloat() &&
+                !tok->tokAt(2)->numericValue().isFloat())
             {
                 const std::string prev(tok->previous() ? tok->strAt(-1).c_str() : "");
                 const std::string after(tok->tokAt(3) ? tok->strAt(3).c_str() : "");
                 if ((prev == "(" || prev == "&&" || prev == "||") && (after == ")" || after == "&&" || after == "||"))
                 {
-                    const MathLib::bigint op1(MathLib::toLongNumber(tok->str()));
+                    const MathLib::bigint op1(tok->numericValue().getInt());
                     const std::string &cmp(tok->next()->str());
-                    const MathLib::bigint op2(MathLib::toLongNumber(tok->tokAt(2)->str()));
+                    const MathLib::bigint op2(tok->tokAt(2)->numericValue().getInt());
 
                     std::string result;
 
@@ -6854,8 +7143,8 @@ bool Tokenizer::simplifyCalculations()
 
             if (Token::Match(tok->previous(), "[([,=] %num% <<|>> %num%"))
             {
-                const MathLib::bigint op1(MathLib::toLongNumber(tok->str()));
-                const MathLib::bigint op2(MathLib::toLongNumber(tok->tokAt(2)->str()));
+                const MathLib::bigint op1(tok->numericValue().getInt());
+                const MathLib::bigint op2(tok->tokAt(2)->numericValue().getInt());
                 MathLib::bigint result;
 
                 if (tok->next()->str() == "<<")
@@ -6863,10 +7152,7 @@ bool Tokenizer::simplifyCalculations()
                 else
                     result = op1 >> op2;
 
-                std::ostringstream ss;
-                ss << result;
-
-                tok->str(ss.str());
+                tok->numericValue(MathLib::Value(result));
                 tok->deleteNext();
                 tok->deleteNext();
             }
@@ -6896,12 +7182,14 @@ bool Tokenizer::simplifyCalculations()
                         continue;
                 }
 
+                const MathLib::Value &op1(tok->numericValue());
+                const MathLib::Value &op2(tok->tokAt(2)->numericValue());
                 if (Token::Match(tok->previous(), "- %num% - %num%"))
-                    tok->str(MathLib::add(tok->str(), tok->tokAt(2)->str()));
+                    tok->numericValue(MathLib::add(op1, op2));
                 else if (Token::Match(tok->previous(), "- %num% + %num%"))
-                    tok->str(MathLib::subtract(tok->str(), tok->tokAt(2)->str()));
+                    tok->numericValue(MathLib::subtract(op1, op2));
                 else
-                    tok->str(MathLib::calculate(tok->str(), tok->tokAt(2)->str(), tok->strAt(1)[0], this));
+                    tok->numericValue(MathLib::calculate(op1, op2, tok->strAt(1)[0], this));
 
                 Token::eraseTokens(tok, tok->tokAt(3));
 
@@ -7271,6 +7559,15 @@ void Tokenizer::simplifyEnum()
     if (isJavaOrCSharp())
         return;
 
+    // How many times each name is used. An enumerator that is used only
+    // in the enum itself doesn't need to be searched for.
+    std::map<std::string, unsigned int> nameCount;
+    for (const Token *tok = _tokens; tok; tok = tok->next())
+    {
+        if (tok->isName())
+            ++nameCount[tok->str()];
+    }
+
     std::string className;
     int classLevel = 0;
     for (Token *tok = _tokens; tok; tok = tok->next())
@@ -7463,7 +7760,8 @@ void Tokenizer::simplifyEnum()
                 }
 
                 // find all uses of this enumerator and substitute it's value for it's name
-                if (enumName && (enumValue || (enumValueStart && enumValueEnd)))
+                if (enumName && (enumValue || (enumValueStart && enumValueEnd)) &&
+                    nameCount[enumName->str()] > 1)
                 {
                     const std::string pattern(className.empty() ? "" : (className + " :: " + enumName->str()).c_str());
                     int level = 1;
@@ -7510,7 +7808,7 @@ void Tokenizer::simplifyEnum()
                                 ++level;
                             }
                         }
-                        else if (!pattern.empty() && Token::Match(tok2, pattern.c_str()))
+                        else if (!pattern.empty() && tok2->str() == className && Token::Match(tok2, pattern.c_str()))
                         {
                             simplify = true;
                             hasClass = true;
@@ -7734,25 +8032,52 @@ const Token *Tokenizer::getFunctionTokenByName(const char funcname[]) const
     if (_symbolDatabase == NULL)
         getSymbolDatabase();
 
-    std::list<SymbolDatabase::SpaceInfo *>::iterator i;
+    const SymbolDatabase::SpaceInfo *info = _symbolDatabase->findFunctionScope(funcname);
+    return info ? info->classDef : NULL;
+}
+
 
-    for (i = _symbolDatabase->spaceInfoList.begin(); i != _symbolDatabase->spaceInfoList.end(); ++i)
+void Tokenizer::fillFunctionList()
+{
+    _symbolDatabase = new SymbolDatabase(this, _settings, _errorLogger);
+    _varOccurrences.clear();
+}
+
+const std::vector<const Token *> &Tokenizer::getVarOccurrences(unsigned int varid) const
+{
+    if (_varOccurrences.empty())
     {
-        SymbolDatabase::SpaceInfo *info = *i;
+        unsigned int maxVarId = 0;
+        for (const Token *tok = _tokens; tok; tok = tok->next())
+        {
+            if (tok->varId() > maxVarId)
+                maxVarId = tok->varId();
+        }
 
-        if (info->type == SymbolDatabase::SpaceInfo::Function)
+        _varOccurrences.resize(maxVarId + 1);
+        for (const Token *tok = _tokens; tok; tok = tok->next())
         {
-            if (info->classDef->str() == funcname)
-                return info->classDef;
+            if (tok->varId() != 0)
+                _varOccurrences[tok->varId()].push_back(tok);
         }
     }
-    return NULL;
-}
 
+    static const std::vector<const Token *> empty;
+    if (varid == 0 || varid >= _varOccurrences.size())
+        return empty;
+    return _varOccurrences[varid];
+}
 
-void Tokenizer::fillFunctionList()
+const Token *Tokenizer::findVarMatch(const char pattern[], unsigned int varid, unsigned int offset) const
 {
-    _symbolDatabase = new SymbolDatabase(this, _settings, _errorLogger);
+    const std::vector<const Token *> &occurrences = getVarOccurrences(varid);
+    for (std::vector<const Token *>::const_iterator it = occurrences.begin(); it != occurrences.end(); ++it)
+    {
+        const Token *tok = (*it)->tokAt(-(int)offset);
+        if (Token::Match(tok, pattern, varid))
+            return tok;
+    }
+    return NULL;
 }
 
 //---------------------------------------------------------------------------
@@ -7760,6 +8085,7 @@ void Tokenizer::fillFunctionList()
 // Deallocate lists..
 void Tokenizer::deallocateTokens()
 {
+    _varOccurrences.clear();
     deleteTokens(_tokens);
     _tokens = 0;
     _tokensBack = 0;
@@ -7858,6 +8184,29 @@ void Tokenizer::syntaxError(const Token *tok, char c)
         Check::reportError(errmsg);
 }
 
+void Tokenizer::templateInstantiationLimitError(const Token *tok, const std::string &name) const
+{
+    std::list<ErrorLogger::ErrorMessage::FileLocation> locationList;
+    if (tok)
+    {
+        ErrorLogger::ErrorMessage::FileLocation loc;
+        loc.line = tok->linenr();
+        loc.setfile(file(tok));
+        locationList.push_back(loc);
+    }
+
+    const ErrorLogger::ErrorMessage errmsg(locationList,
+                                           Severity::information,
+                                           "Template instantiation limit reached when instantiating '" + name +
+                                           "'. The remaining instantiations are not simplified.",
+                                           "templateInstantiationLimit");
+
+    if (_errorLogger)
+        _errorLogger->reportErr(errmsg);
+    else
+        Check::reportError(errmsg);
+}
+
 void Tokenizer::cppcheckError(const Token *tok) const
 {
     std::list<ErrorLogger::ErrorMessage::FileLocation> locationList;
@@ -8362,6 +8711,7 @@ void Tokenizer::getErrorMessages(ErrorLogger *errorLogger, const Settings *setti
     Tokenizer t(settings, errorLogger);
     t.syntaxError(0, ' ');
     t.cppcheckError(0);
+    t.templateInstantiationLimitError(0, "name");
 }
 
 /** find pattern */
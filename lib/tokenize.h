@@ -30,6 +30,8 @@ class Token;
 class ErrorLogger;
 class Settings;
 class SymbolDatabase;
+class TimerResultsIntf;
+class SourceLocations;
 
 /// @addtogroup Core
 /// @{
@@ -62,18 +64,17 @@ public:
      * Tokenize code
      * @param code input stream for code, e.g.
      * \code
-     * #file "p.h"
      * class Foo
      * {
      * private:
      * void Bar();
      * };
      *
-     * #endfile
      * void Foo::Bar()
      * {
      * }
      * \endcode
+     * The lines of included files are given with setSourceLocations().
      *
      * @param FileName The filename
      * @param configuration E.g. "A" for code where "#ifdef A" is true
@@ -467,6 +468,9 @@ public:
     /** Syntax error. Example: invalid number of ')' */
     void syntaxError(const Token *tok, char c);
 
+    /** Template instantiation limit was reached, the template is not fully simplified */
+    void templateInstantiationLimitError(const Token *tok, const std::string &name) const;
+
     /**
      * assert that tokens are ok - used during debugging for example
      * to catch problems in simplifyTokenList.
@@ -572,8 +576,50 @@ public:
         _settings = settings;
     }
 
+    /** Where the counters for --showtime are added */
+    void setTimerResults(TimerResultsIntf *timerResults)
+    {
+        _timerResults = timerResults;
+    }
+
+    /** The --showtime results, see setTimerResults */
+    TimerResultsIntf *getTimerResults() const
+    {
+        return _timerResults;
+    }
+
+    /**
+     * The files and line numbers of the lines of the code, see
+     * Preprocessor::getSourceLocations(). Without these all the code
+     * is in the file that is given to tokenize().
+     */
+    void setSourceLocations(const SourceLocations *locations)
+    {
+        _locations = locations;
+    }
+
     SymbolDatabase * getSymbolDatabase() const;
 
+    /**
+     * @brief Get all occurrences of a variable. They are indexed the first
+     * time this is called and the index is thrown away when the variable
+     * ids are set again.
+     * @param varid variable id
+     * @return the variable tokens in token order
+     */
+    const std::vector<const Token *> &getVarOccurrences(unsigned int varid) const;
+
+    /**
+     * @brief Find the first occurrence of a variable where a pattern matches.
+     * This is the same as Token::findmatch(tokens(), pattern, varid) if
+     * the %varid% is at the given offset in the pattern.
+     * @param pattern pattern that contains %varid%
+     * @param varid variable id
+     * @param offset position of %varid% in the pattern
+     * @return the token where the pattern matches, NULL if not found
+     */
+    const Token *findVarMatch(const char pattern[], unsigned int varid, unsigned int offset = 0) const;
+
 private:
     /** Disable copy constructor, no implementation */
     Tokenizer(const Tokenizer &);
@@ -581,6 +627,14 @@ private:
     /** Disable assignment operator, no implementation */
     Tokenizer &operator=(const Tokenizer &);
 
+    /**
+     * Get the index of a file in _files. The file is added if it's
+     * not there.
+     * @param filename the name of the file
+     * @return the index of the file
+     */
+    unsigned int getFileIndex(const std::string &filename);
+
     /** Token list */
     Token *_tokens, *_tokensBack;
 
@@ -608,6 +662,15 @@ private:
 
     /** Symbol database that all checks etc can use */
     mutable SymbolDatabase *_symbolDatabase;
+
+    /** Occurrences of the variables, see getVarOccurrences. Index is the varid. */
+    mutable std::vector<std::vector<const Token *> > _varOccurrences;
+
+    /** Counters for --showtime */
+    TimerResultsIntf *_timerResults;
+
+    /** The files and line numbers of the lines of the code */
+    const SourceLocations *_locations;
 };
 
 /// @}
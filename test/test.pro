@@ -51,6 +51,7 @@ SOURCES += options.cpp \
            testsimplifytokens.cpp \
            teststl.cpp \
            testsuite.cpp \
+           testsummarydatabase.cpp \
            testthreadexecutor.cpp \
            testtoken.cpp \
            testtokenize.cpp \
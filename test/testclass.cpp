@@ -19,6 +19,7 @@
 
 
 #include "tokenize.h"
+#include "sourcelocations.h"
 #include "checkclass.h"
 #include "testsuite.h"
 #include <sstream>
@@ -1501,7 +1502,7 @@ private:
         ASSERT_EQUALS("[test.cpp:9]: (error) Class AA<double> which is inherited by class B does not have a virtual destructor\n", errout.str());
     }
 
-    void checkUninitVar(const char code[])
+    void checkUninitVar(const char code[], const SourceLocations *locations = 0)
     {
         // Clear the error log
         errout.str("");
@@ -1511,6 +1512,7 @@ private:
 
         // Tokenize..
         Tokenizer tokenizer(&settings, this);
+        tokenizer.setSourceLocations(locations);
         std::istringstream istr(code);
         tokenizer.tokenize(istr, "test.cpp");
         tokenizer.simplifyTokenList();
@@ -2430,43 +2432,49 @@ private:
 
     void uninitVarHeader1()
     {
-        checkUninitVar("#file \"fred.h\"\n"
-                       "class Fred\n"
+        // The code is in fred.h
+        SourceLocations locations;
+        locations.add(1, "test.cpp", 1);
+        locations.add(1, "fred.h", 1);
+        checkUninitVar("class Fred\n"
                        "{\n"
                        "private:\n"
                        "    unsigned int i;\n"
                        "public:\n"
                        "    Fred();\n"
-                       "};\n"
-                       "#endfile\n");
+                       "};\n", &locations);
         ASSERT_EQUALS("", errout.str());
     }
 
     void uninitVarHeader2()
     {
-        checkUninitVar("#file \"fred.h\"\n"
-                       "class Fred\n"
+        // The code is in fred.h
+        SourceLocations locations;
+        locations.add(1, "test.cpp", 1);
+        locations.add(1, "fred.h", 1);
+        checkUninitVar("class Fred\n"
                        "{\n"
                        "private:\n"
                        "    unsigned int i;\n"
                        "public:\n"
                        "    Fred() { }\n"
-                       "};\n"
-                       "#endfile\n");
+                       "};\n", &locations);
         ASSERT_EQUALS("[fred.h:6]: (warning) Member variable not initialized in the constructor 'Fred::i'\n", errout.str());
     }
 
     void uninitVarHeader3()
     {
-        checkUninitVar("#file \"fred.h\"\n"
-                       "class Fred\n"
+        // The code is in fred.h
+        SourceLocations locations;
+        locations.add(1, "test.cpp", 1);
+        locations.add(1, "fred.h", 1);
+        checkUninitVar("class Fred\n"
                        "{\n"
                        "private:\n"
                        "    mutable int i;\n"
                        "public:\n"
                        "    Fred() { }\n"
-                       "};\n"
-                       "#endfile\n");
+                       "};\n", &locations);
         ASSERT_EQUALS("[fred.h:6]: (warning) Member variable not initialized in the constructor 'Fred::i'\n", errout.str());
     }
 
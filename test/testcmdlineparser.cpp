@@ -65,7 +65,19 @@ private:
         TEST_CASE(jobs);
         TEST_CASE(jobsMissingCount);
         TEST_CASE(jobsInvalid);
+        TEST_CASE(jobsNegative);
         TEST_CASE(reportProgress);
+        TEST_CASE(summaries);
+        TEST_CASE(summariesMissingFile);
+        TEST_CASE(summariesJobs);
+        TEST_CASE(maxPaths);
+        TEST_CASE(maxPathsZero);
+        TEST_CASE(maxPathsNegative);
+        TEST_CASE(maxPathTime);
+        TEST_CASE(maxPathTimeNegative);
+        TEST_CASE(configBudget);
+        TEST_CASE(configBudgetInvalid);
+        TEST_CASE(configBudgetNegative);
         TEST_CASE(suppressions); // TODO: Create and test real suppression file
         TEST_CASE(templates);
         TEST_CASE(templatesGcc);
@@ -413,6 +425,15 @@ private:
         ASSERT(!parser.ParseFromArgs(3, argv));
     }
 
+    void jobsNegative()
+    {
+        REDIRECT;
+        const char *argv[] = {"cppcheck", "-j -2", "file.cpp"};
+        Settings settings;
+        CmdLineParser parser(&settings);
+        ASSERT(!parser.ParseFromArgs(3, argv));
+    }
+
     void reportProgress()
     {
         REDIRECT;
@@ -423,6 +444,110 @@ private:
         ASSERT(settings.reportProgress);
     }
 
+    void summaries()
+    {
+        REDIRECT;
+        const char *argv[] = {"cppcheck", "--summaries=summaries.txt", "file.cpp"};
+        Settings settings;
+        CmdLineParser parser(&settings);
+        ASSERT(parser.ParseFromArgs(3, argv));
+        ASSERT_EQUALS("summaries.txt", settings.summaryFile);
+        ASSERT(settings.test_2_pass);
+    }
+
+    void summariesMissingFile()
+    {
+        REDIRECT;
+        const char *argv[] = {"cppcheck", "--summaries=", "file.cpp"};
+        Settings settings;
+        CmdLineParser parser(&settings);
+        ASSERT(!parser.ParseFromArgs(3, argv));
+    }
+
+    void summariesJobs()
+    {
+        REDIRECT;
+        const char *argv[] = {"cppcheck", "--summaries=summaries.txt", "-j2", "file.cpp"};
+        Settings settings;
+        CmdLineParser parser(&settings);
+        ASSERT(!parser.ParseFromArgs(4, argv));
+    }
+
+    void maxPaths()
+    {
+        REDIRECT;
+        const char *argv[] = {"cppcheck", "--max-paths=20", "file.cpp"};
+        Settings settings;
+        CmdLineParser parser(&settings);
+        ASSERT(parser.ParseFromArgs(3, argv));
+        ASSERT_EQUALS(20, settings._maxExecutionPaths);
+    }
+
+    void maxPathsZero()
+    {
+        REDIRECT;
+        const char *argv[] = {"cppcheck", "--max-paths=0", "file.cpp"};
+        Settings settings;
+        CmdLineParser parser(&settings);
+        ASSERT(!parser.ParseFromArgs(3, argv));
+    }
+
+    void maxPathsNegative()
+    {
+        REDIRECT;
+        const char *argv[] = {"cppcheck", "--max-paths=-5", "file.cpp"};
+        Settings settings;
+        CmdLineParser parser(&settings);
+        ASSERT(!parser.ParseFromArgs(3, argv));
+    }
+
+    void maxPathTime()
+    {
+        REDIRECT;
+        const char *argv[] = {"cppcheck", "--max-path-time=500", "file.cpp"};
+        Settings settings;
+        CmdLineParser parser(&settings);
+        ASSERT(parser.ParseFromArgs(3, argv));
+        ASSERT_EQUALS(500, settings._maxExecutionPathTime);
+    }
+
+    void maxPathTimeNegative()
+    {
+        REDIRECT;
+        const char *argv[] = {"cppcheck", "--max-path-time=-1", "file.cpp"};
+        Settings settings;
+        CmdLineParser parser(&settings);
+        ASSERT(!parser.ParseFromArgs(3, argv));
+    }
+
+    void configBudget()
+    {
+        REDIRECT;
+        const char *argv[] = {"cppcheck", "--config-budget=60", "file.cpp"};
+        Settings settings;
+        CmdLineParser parser(&settings);
+        ASSERT(parser.ParseFromArgs(3, argv));
+        ASSERT_EQUALS(60, settings._configBudget);
+    }
+
+    void configBudgetInvalid()
+    {
+        REDIRECT;
+        const char *argv[] = {"cppcheck", "--config-budget=0", "file.cpp"};
+        Settings settings;
+        CmdLineParser parser(&settings);
+        ASSERT(!parser.ParseFromArgs(3, argv));
+    }
+
+    void configBudgetNegative()
+    {
+        REDIRECT;
+        const char *argv[] = {"cppcheck", "--config-budget=-60", "file.cpp"};
+        Settings settings;
+        CmdLineParser parser(&settings);
+        ASSERT(!parser.ParseFromArgs(3, argv));
+    }
+
     void suppressions()
     {
         REDIRECT;
@@ -64,6 +64,9 @@ private:
 
         TEST_CASE(include);
         TEST_CASE(templateFormat);
+
+        TEST_CASE(identicalConfigurations);
+        TEST_CASE(configBudget);
         //TEST_CASE(getErrorMessages);
         //TEST_CASE(parseOutputtingArgs);
         //TEST_CASE(parseOutputtingInvalidArgs);
@@ -420,6 +423,70 @@ private:
         ASSERT_EQUALS("testId-" + fname + ",error.10?{long testMessage}", errorMessage.toString(false, "{id}-{file},{severity}.{line}?{{message}}"));
     }
 
+    void identicalConfigurations()
+    {
+        errout.str("");
+        output.str("");
+        Settings settings;
+        settings._verbose = true;
+        CppCheck cppCheck(*this);
+        cppCheck.settings(settings);
+        cppCheck.addFile("file.cpp", "#ifdef A\n"
+                         "// comment\n"
+                         "#endif\n"
+                         "#ifdef B\n"
+                         "int b;\n"
+                         "#endif\n"
+                         "void f() { }\n");
+        cppCheck.check();
+
+        // The configuration "A" gives the same code as ""
+        ASSERT_EQUALS("Checking file.cpp...\n"
+                      "Checking file.cpp: B...\n"
+                      "Skipped 1 configuration of file.cpp with the same code as a checked configuration\n", output.str());
+    }
+
+    void configBudget()
+    {
+        errout.str("");
+        output.str("");
+        Settings settings;
+        settings._configBudget = 1000;
+        const char code[] = "int x;\n"
+                            "#ifdef A\n"
+                            "int a;\n"
+                            "#endif\n"
+                            "#ifdef B\n"
+                            "int b1;\n"
+                            "int b2;\n"
+                            "#endif\n";
+        {
+            CppCheck cppCheck(*this);
+            cppCheck.settings(settings);
+            cppCheck.addFile("file.cpp", code);
+            cppCheck.check();
+
+            // "B" covers most lines and is checked first. "A" covers the
+            // last uncovered line. The line coverage is reported.
+            ASSERT_EQUALS("Checking file.cpp...\n"
+                          "Checking file.cpp: B...\n"
+                          "Checking file.cpp: A...\n"
+                          "Line coverage of file.cpp: 4 of 4 lines (100%) in 3 of 3 configurations\n", output.str());
+        }
+
+        // The line coverage is not reported with --quiet
+        output.str("");
+        settings._errorsOnly = true;
+        {
+            CppCheck cppCheck(*this);
+            cppCheck.settings(settings);
+            cppCheck.addFile("file.cpp", code);
+            cppCheck.check();
+
+            ASSERT_EQUALS("", output.str());
+        }
+    }
+
     void getErrorMessages()
     {
         errout.str("");
@@ -36,6 +36,7 @@ private:
         TEST_CASE(isint);
         TEST_CASE(isnegative);
         TEST_CASE(isfloat);
+        TEST_CASE(value);
     }
 
     void calculate()
@@ -274,6 +275,25 @@ private:
         ASSERT_EQUALS(true , MathLib::isFloat("1.0E-1"));
         ASSERT_EQUALS(true , MathLib::isFloat("-1.0E+1"));
     }
+
+    void value()
+    {
+        const MathLib::Value hex("0xff");
+        ASSERT_EQUALS(false, hex.isFloat());
+        ASSERT_EQUALS(255, (int)hex.getInt());
+        ASSERT_EQUALS("255", hex.str());
+
+        const MathLib::Value flt("1.5");
+        ASSERT_EQUALS(true, flt.isFloat());
+        ASSERT_EQUALS("1.5", flt.str());
+
+        ASSERT_EQUALS("256", MathLib::add(hex, MathLib::Value("1")).str());
+        ASSERT_EQUALS(false, MathLib::add(hex, MathLib::Value("1")).isFloat());
+        ASSERT_EQUALS("3", MathLib::multiply(flt, MathLib::Value("2")).str());
+        ASSERT_EQUALS(true, MathLib::multiply(flt, MathLib::Value("2")).isFloat());
+        ASSERT_EQUALS("2", MathLib::calculate(MathLib::Value("7"), MathLib::Value("5"), '-', 0).str());
+        ASSERT_EQUALS("5", MathLib::divide(MathLib::Value("10"), MathLib::Value("2")).str());
+    }
 };
 
 REGISTER_TEST(TestMathLib)
@@ -20,6 +20,7 @@
 
 #include "tokenize.h"
 #include "checkmemoryleak.h"
+#include "summarydatabase.h"
 #include "testsuite.h"
 
 #include <sstream>
@@ -127,13 +128,15 @@ public:
     { }
 
 private:
-    void check(const char code[], bool showAll = false)
+    void check(const char code[], bool showAll = false, const SummaryDatabase::Data *summaries = 0)
     {
         // Clear the error buffer..
         errout.str("");
 
         Settings settings;
         settings.inconclusive = showAll;
+        if (summaries)
+            settings.functionSummaries = *summaries;
 
         // Tokenize..
         Tokenizer tokenizer(&settings, this);
@@ -227,6 +230,7 @@ private:
         TEST_CASE(func18);
         TEST_CASE(func19);      // Ticket #2056 - if (!f(p)) return 0;
         TEST_CASE(func20);		// Ticket #2182 - exit is not handled
+        TEST_CASE(func21);      // Function called from several places
 
         TEST_CASE(allocfunc1);
         TEST_CASE(allocfunc2);
@@ -257,6 +261,7 @@ private:
         TEST_CASE(assign);
 
         TEST_CASE(varid);
+        TEST_CASE(multipleVariables);
 
         TEST_CASE(cast1);
 
@@ -295,6 +300,8 @@ private:
         TEST_CASE(exit6);
         TEST_CASE(exit7);
         TEST_CASE(noreturn);
+        TEST_CASE(analyseFunctions);
+        TEST_CASE(loadedSummaries);
         TEST_CASE(stdstring);
 
         TEST_CASE(strndup_function);
@@ -713,6 +720,10 @@ private:
 
         // use ; dealloc ;
         ASSERT_EQUALS("; alloc ; use ; if return ; dealloc ;", simplifycode("; alloc ; use ; if { return ; } dealloc ;"));
+
+        // nested blocks are reduced in several passes
+        ASSERT_EQUALS("; alloc ; if use ; dealloc ;", simplifycode("; alloc ; if { if { if { use ; } } } dealloc ;"));
+        ASSERT_EQUALS("; alloc ; use ; if { if dealloc ; return ; } dealloc ;", simplifycode("; alloc ; use ; use ; switch { case ; if { { dealloc ; } } return ; default ; } dealloc ;"));
     }
 
 
@@ -1697,6 +1708,57 @@ private:
         ASSERT_EQUALS("", errout.str());
     }
 
+    void func21()
+    {
+        // The result of analysing "foo" is reused for the later calls.
+        check("static void foo(char *str)\n"
+              "{\n"
+              "    free(str);\n"
+              "}\n"
+              "\n"
+              "static void f1()\n"
+              "{\n"
+              "    char *p = malloc(100);\n"
+              "    foo(p);\n"
+              "}\n"
+              "\n"
+              "static void f2()\n"
+              "{\n"
+              "    char *p = malloc(100);\n"
+              "    foo(p);\n"
+              "    foo(p);\n"
+              "}\n"
+              "\n"
+              "static void f3()\n"
+              "{\n"
+              "    char *p = malloc(100);\n"
+              "    if (x)\n"
+              "        foo(p);\n"
+              "}\n");
+        ASSERT_EQUALS("[test.cpp:16]: (error) Deallocating a deallocated pointer: p\n"
+                      "[test.cpp:24]: (error) Memory leak: p\n", errout.str());
+
+        // Errors in the called function are reported for each call
+        check("static void foo(char *str)\n"
+              "{\n"
+              "    delete str;\n"
+              "}\n"
+              "\n"
+              "static void f1()\n"
+              "{\n"
+              "    char *p = new char[100];\n"
+              "    foo(p);\n"
+              "}\n"
+              "\n"
+              "static void f2()\n"
+              "{\n"
+              "    char *p = new char[100];\n"
+              "    foo(p);\n"
+              "}\n", true);
+        ASSERT_EQUALS("[test.cpp:9] -> [test.cpp:3]: (error) Mismatching allocation and deallocation: str\n"
+                      "[test.cpp:15] -> [test.cpp:3]: (error) Mismatching allocation and deallocation: str\n", errout.str());
+    }
+
 
 
 
@@ -2217,6 +2279,28 @@ private:
         ASSERT_EQUALS("", errout.str());
     }
 
+    void multipleVariables()
+    {
+        // only some of the variables are allocated/deallocated
+        check("void foo(char *s)\n"
+              "{\n"
+              "    int i, n;\n"
+              "    char *p, *q, *r;\n"
+              "    n = 10;\n"
+              "    p = malloc(n);\n"
+              "    q = s;\n"
+              "    r = 0;\n"
+              "    for (i = 0; i < n; i++)\n"
+              "        q[i] = 0;\n"
+              "    int fd = open(q, O_RDONLY);\n"
+              "    char *buf;\n"
+              "    buf = s + n;\n"
+              "    delete [] r;\n"
+              "}\n");
+        ASSERT_EQUALS("[test.cpp:15]: (error) Memory leak: p\n"
+                      "[test.cpp:15]: (error) Resource leak: fd\n", errout.str());
+    }
+
     void cast1()
     {
         check("void foo()\n"
@@ -2619,6 +2703,74 @@ private:
 
 
 
+    std::string analyse(const char code[])
+    {
+        // Clear the error buffer..
+        errout.str("");
+
+        Settings settings;
+
+        // Tokenize..
+        Tokenizer tokenizer(&settings, this);
+        std::istringstream istr(code);
+        tokenizer.tokenize(istr, "test.cpp");
+        tokenizer.simplifyTokenList();
+
+        std::set<std::string> f;
+        const CheckMemoryLeakInFunction check(0, 0, 0);
+        check.analyse(tokenizer.tokens(), f);
+
+        std::string ret;
+        for (std::set<std::string>::const_iterator it = f.begin(); it != f.end(); ++it)
+            ret += (ret.empty() ? "" : ",") + *it;
+        return ret;
+    }
+
+    void analyseFunctions()
+    {
+        ASSERT_EQUALS("noreturn fatal_error", analyse("void fatal_error()\n"
+                      "{ exit(1); }\n"));
+
+        ASSERT_EQUALS("alloc create 1", analyse("char *create()\n"
+                      "{ return malloc(10); }\n"));
+
+        ASSERT_EQUALS("alloc create 4", analyse("char *create()\n"
+                      "{\n"
+                      "    char *p = new char[10];\n"
+                      "    return p;\n"
+                      "}\n"));
+
+        ASSERT_EQUALS("", analyse("char *f(char *p)\n"
+                                  "{ return p; }\n"));
+
+        // class members are not analysed
+        ASSERT_EQUALS("", analyse("class A {\n"
+                                  "    void fatal_error() { exit(1); }\n"
+                                  "};\n"));
+    }
+
+    void loadedSummaries()
+    {
+        const char code[] = "void f()\n"
+                            "{\n"
+                            "    char *p = loaded_create();\n"
+                            "}\n";
+        check(code);
+        ASSERT_EQUALS("", errout.str());
+
+        // summary of a function in another file
+        SummaryDatabase db;
+        std::istringstream istr("cppcheck-summaries 1\n"
+                                "file 1a-2 other.c\n"
+                                "Memory leaks (function variables)\talloc loaded_create 1\n");
+        ASSERT_EQUALS(true, db.load(istr));
+        SummaryDatabase::Data data;
+        ASSERT_EQUALS(true, db.find("other.c", "1a-2", data));
+
+        check(code, false, &data);
+        ASSERT_EQUALS("[test.cpp:4]: (error) Memory leak: p\n", errout.str());
+    }
+
     void stdstring()
     {
         check("void f(std::string foo)\n"
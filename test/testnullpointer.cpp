@@ -41,20 +41,25 @@ private:
         TEST_CASE(nullpointer5);    // References should not be checked
         TEST_CASE(nullpointerExecutionPaths);
         TEST_CASE(nullpointerExecutionPathsLoop);
+        TEST_CASE(nullpointerExecutionPathsMerge);
         TEST_CASE(nullpointer7);
         TEST_CASE(nullpointer8);
         TEST_CASE(nullpointer9);
         TEST_CASE(pointerCheckAndDeRef);	// check if pointer is null and then dereference it
         TEST_CASE(nullConstantDereference);		// Dereference NULL constant
+        TEST_CASE(analyseFunctions);
+        TEST_CASE(analysedFunctions);
     }
 
-    void check(const char code[])
+    void check(const char code[], const std::map<std::string, std::set<std::string> > *summaries = 0)
     {
         // Clear the error buffer..
         errout.str("");
 
         Settings settings;
         settings._checkCodingStyle = true;
+        if (summaries)
+            settings.functionSummaries = *summaries;
 
         // Tokenize..
         Tokenizer tokenizer(&settings, this);
@@ -671,6 +676,54 @@ private:
         TODO_ASSERT_EQUALS("error", errout.str());
     }
 
+    void nullpointerExecutionPathsMerge()
+    {
+        // Both branches set the pointers to null. The equal execution paths
+        // are merged, so there are not too many paths at the second "if".
+        check("void foo(int a)\n"
+              "{\n"
+              "    int *p1; int *p2; int *p3; int *p4; int *p5; int *p6;\n"
+              "    if (a == 1) {\n"
+              "        p1 = 0; p2 = 0; p3 = 0; p4 = 0; p5 = 0; p6 = 0;\n"
+              "    } else {\n"
+              "        p1 = 0; p2 = 0; p3 = 0; p4 = 0; p5 = 0; p6 = 0;\n"
+              "    }\n"
+              "    if (a < *p1) { }\n"
+              "    bar(p1, p2, p3, p4, p5, p6);\n"
+              "}\n");
+        ASSERT_EQUALS("[test.cpp:9]: (error) Possible null pointer dereference: p1\n", errout.str());
+
+        // The branches are different and both execution paths are kept
+        check("void foo(int a)\n"
+              "{\n"
+              "    int *p1; int *p2;\n"
+              "    if (a == 1) {\n"
+              "        p1 = 0;\n"
+              "    } else {\n"
+              "        p2 = 0;\n"
+              "    }\n"
+              "    if (a < *p1 && a < *p2) { }\n"
+              "    bar(p1, p2);\n"
+              "}\n");
+        ASSERT_EQUALS("[test.cpp:9]: (error) Possible null pointer dereference: p1\n"
+                      "[test.cpp:9]: (error) Possible null pointer dereference: p2\n", errout.str());
+
+        // The branches are different. There are too many execution paths
+        // after the merge, so the pointers are not tracked anymore.
+        check("void foo(int a)\n"
+              "{\n"
+              "    int *p1; int *p2; int *p3; int *p4; int *p5; int *p6;\n"
+              "    if (a == 1) {\n"
+              "        p1 = 0; p2 = 0; p3 = 0; p4 = 0; p5 = 0; p6 = 0;\n"
+              "    } else {\n"
+              "        a = 0;\n"
+              "    }\n"
+              "    if (a < *p1) { }\n"
+              "    bar(p1, p2, p3, p4, p5, p6);\n"
+              "}\n");
+        ASSERT_EQUALS("", errout.str());
+    }
+
     void nullpointer7()
     {
         check("void foo()\n"
@@ -815,6 +868,72 @@ private:
         ASSERT_EQUALS("[test.cpp:3]: (error) Null pointer dereference\n", errout.str());
     }
 
+
+    std::string analyse(const char code[])
+    {
+        // Clear the error buffer..
+        errout.str("");
+
+        Settings settings;
+
+        // Tokenize..
+        Tokenizer tokenizer(&settings, this);
+        std::istringstream istr(code);
+        tokenizer.tokenize(istr, "test.cpp");
+        tokenizer.simplifyTokenList();
+
+        std::set<std::string> f;
+        const CheckNullPointer check(0, 0, 0);
+        check.analyse(tokenizer.tokens(), f);
+
+        std::string ret;
+        for (std::set<std::string>::const_iterator it = f.begin(); it != f.end(); ++it)
+            ret += (ret.empty() ? "" : ",") + *it;
+        return ret;
+    }
+
+    void analyseFunctions()
+    {
+        ASSERT_EQUALS("1 f", analyse("void f(char *p)\n"
+                                     "{ *p = 0; }\n"));
+
+        ASSERT_EQUALS("2 f", analyse("void f(int x, struct ABC *abc)\n"
+                                     "{ abc->a = x; }\n"));
+
+        ASSERT_EQUALS("1 f,2 f", analyse("void f(char *a, char *b)\n"
+                                         "{ *a = *b; }\n"));
+
+        // the pointer is checked before it is dereferenced
+        ASSERT_EQUALS("", analyse("void f(char *p)\n"
+                                  "{\n"
+                                  "    if (p)\n"
+                                  "        *p = 0;\n"
+                                  "}\n"));
+
+        // the pointer is assigned before it is dereferenced
+        ASSERT_EQUALS("", analyse("void f(char *p)\n"
+                                  "{\n"
+                                  "    p = buf;\n"
+                                  "    *p = 0;\n"
+                                  "}\n"));
+    }
+
+    void analysedFunctions()
+    {
+        const char code[] = "void foo()\n"
+                            "{\n"
+                            "    char *p = 0;\n"
+                            "    loaded_deref(p);\n"
+                            "}\n";
+        check(code);
+        ASSERT_EQUALS("", errout.str());
+
+        // summary of a function in another file
+        std::map<std::string, std::set<std::string> > summaries;
+        summaries["Null pointer"].insert("1 loaded_deref");
+        check(code, &summaries);
+        ASSERT_EQUALS("[test.cpp:4]: (error) Possible null pointer dereference: p\n", errout.str());
+    }
 };
 
 REGISTER_TEST(TestNullPointer)
@@ -48,6 +48,9 @@ private:
 
         // dangerous function
         TEST_CASE(testgets);
+
+        // several obsolete functions are reported in the order they are used
+        TEST_CASE(testmultiple);
     }
 
 
@@ -214,6 +217,19 @@ private:
         ASSERT_EQUALS("[test.cpp:3]: (style) Found obsolete function 'gets'. It is recommended to use the function 'fgets' instead\n", errout.str());
     }
 
+    void testmultiple()
+    {
+        check("void f(char *s)\n"
+              "{\n"
+              "    usleep(10);\n"
+              "    bzero(s, 10);\n"
+              "    usleep(20);\n"
+              "}\n");
+        ASSERT_EQUALS("[test.cpp:3]: (style) Found obsolete function 'usleep'. It is recommended that new applications use the 'nanosleep' or 'setitimer' function\n"
+                      "[test.cpp:4]: (style) Found obsolete function 'bzero'. It is recommended that new applications use the 'memset' function\n"
+                      "[test.cpp:5]: (style) Found obsolete function 'usleep'. It is recommended that new applications use the 'nanosleep' or 'setitimer' function\n", errout.str());
+    }
+
 
 
 };
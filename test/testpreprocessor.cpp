@@ -27,6 +27,8 @@
 #include "token.h"
 #include "settings.h"
 
+#include <cstdio>
+#include <fstream>
 #include <map>
 #include <string>
 #include <sstream>
@@ -49,17 +51,63 @@ public:
             return Preprocessor::replaceIfDefined(str);
         }
 
-        static std::string expandMacros(std::string code, ErrorLogger *errorLogger = 0)
+        static std::string expandMacros(std::string code, ErrorLogger *errorLogger = 0, const SourceLocations &locations = SourceLocations())
         {
-            return Preprocessor::expandMacros(code, "file.cpp", errorLogger);
+            return Preprocessor::expandMacros(code, "file.cpp", errorLogger, locations);
         }
 
         static int getHeaderFileName(std::string &str)
         {
             return Preprocessor::getHeaderFileName(str);
         }
+
+        static std::string getIncludeGuard(const std::string &code)
+        {
+            return Preprocessor::getIncludeGuard(code);
+        }
+    };
+
+    /** A header file that is written for a test and removed afterwards */
+    class HeaderFile
+    {
+    public:
+        HeaderFile(const std::string &name, const std::string &code) : _name(name)
+        {
+            std::ofstream fout(name.c_str());
+            fout << code;
+        }
+
+        ~HeaderFile()
+        {
+            std::remove(_name.c_str());
+        }
+
+    private:
+        const std::string _name;
     };
 
+    /** Count how many times str occurs in code */
+    static unsigned int countOf(const std::string &code, const std::string &str)
+    {
+        unsigned int count = 0;
+        for (std::string::size_type pos = code.find(str); pos != std::string::npos; pos = code.find(str, pos + 1))
+            ++count;
+        return count;
+    }
+
+    /** Preprocess code and handle its includes */
+    std::string preprocessIncludes(const char code[])
+    {
+        errout.str("");
+        std::istringstream istr(code);
+        std::string processedFile;
+        std::list<std::string> configurations;
+        Settings settings;
+        Preprocessor preprocessor(&settings, this);
+        preprocessor.preprocess(istr, processedFile, configurations, "file.c", std::list<std::string>());
+        return processedFile;
+    }
+
 private:
 
     void run()
@@ -102,6 +150,7 @@ private:
 
         // Test the Preprocessor::match_cfg_def
         TEST_CASE(match_cfg_def);
+        TEST_CASE(match_cfg_def_expressions);
 
         TEST_CASE(if_cond1);
         TEST_CASE(if_cond2);
@@ -143,6 +192,7 @@ private:
         TEST_CASE(macro_simple11);
         TEST_CASE(macro_simple12);
         TEST_CASE(macro_simple13);
+        TEST_CASE(macro_simple14);
         TEST_CASE(macroInMacro);
         TEST_CASE(macro_mismatch);
         TEST_CASE(macro_linenumbers);
@@ -167,6 +217,9 @@ private:
         TEST_CASE(stringify4);
         TEST_CASE(stringify5);
         TEST_CASE(ifdefwithfile);
+        TEST_CASE(sourceLocations);
+        TEST_CASE(directiveTree);
+        TEST_CASE(configurationObjects);
         TEST_CASE(pragma);
         TEST_CASE(pragma_asm_1);
         TEST_CASE(pragma_asm_2);
@@ -183,6 +236,12 @@ private:
         TEST_CASE(macro_parameters);
         TEST_CASE(newline_in_macro);
         TEST_CASE(includes);
+        TEST_CASE(includeGuard);
+        TEST_CASE(includeGuardedHeaderTwice);
+        TEST_CASE(includeGuardedHeaderConditional);
+        TEST_CASE(includeGuardedHeaderUndef);
+        TEST_CASE(includePragmaOnce);
+        TEST_CASE(missingIncludeLineNumber);
         TEST_CASE(ifdef_ifdefined);
 
         // define and then ifdef
@@ -192,6 +251,7 @@ private:
         TEST_CASE(endfile);
 
         TEST_CASE(redundant_config);
+        TEST_CASE(redundant_config2);
     }
 
 
@@ -489,11 +549,10 @@ private:
     void includeguard1()
     {
         // Handling include guards..
-        const char filedata[] = "#file \"abc.h\"\n"
-                                "#ifndef abcH\n"
-                                "#define abcH\n"
-                                "#endif\n"
-                                "#endfile\n"
+        const HeaderFile abc("testpreprocessor_abc.h", "#ifndef abcH\n"
+                             "#define abcH\n"
+                             "#endif\n");
+        const char filedata[] = "#include \"testpreprocessor_abc.h\"\n"
                                 "#ifdef ABC\n"
                                 "#endif";
 
@@ -511,12 +570,11 @@ private:
     void includeguard2()
     {
         // Handling include guards..
-        const char filedata[] = "#file \"abc.h\"\n"
-                                "foo\n"
-                                "#ifdef ABC\n"
-                                "\n"
-                                "#endif\n"
-                                "#endfile\n";
+        const HeaderFile abc("testpreprocessor_abc.h", "foo\n"
+                             "#ifdef ABC\n"
+                             "\n"
+                             "#endif\n");
+        const char filedata[] = "#include \"testpreprocessor_abc.h\"\n";
 
         // Preprocess => actual result..
         std::istringstream istr(filedata);
@@ -535,10 +593,9 @@ private:
     void ifdefwithfile()
     {
         // Handling include guards..
+        const HeaderFile abc("testpreprocessor_abc.h", "class A{};/*\n\n\n\n\n\n\n*/\n");
         const char filedata[] = "#ifdef ABC\n"
-                                "#file \"abc.h\"\n"
-                                "class A{};/*\n\n\n\n\n\n\n*/\n"
-                                "#endfile\n"
+                                "#include \"testpreprocessor_abc.h\"\n"
                                 "#endif\n"
                                 "int main() {}\n";
 
@@ -547,9 +604,10 @@ private:
         std::map<std::string, std::string> actual;
         Settings settings;
         Preprocessor preprocessor(&settings, this);
-        preprocessor.preprocess(istr, actual, "file.c");
+        preprocessor.preprocess(istr, actual, "main.cpp");
 
         Tokenizer tok(&settings, this);
+        tok.setSourceLocations(&preprocessor.getSourceLocations());
         std::istringstream codeStream(actual[""]);
         tok.tokenize(codeStream, "main.cpp");
 
@@ -557,8 +615,123 @@ private:
 
         // Expected configurations: "" and "ABC"
         ASSERT_EQUALS(2, static_cast<unsigned int>(actual.size()));
-        ASSERT_EQUALS("\n#file \"abc.h\"\n\n\n\n\n\n\n\n\n#endfile\n\nint main() {}\n", actual[""]);
-        ASSERT_EQUALS("\n#file \"abc.h\"\nclass A{};\n\n\n\n\n\n\n\n#endfile\n\nint main() {}\n", actual["ABC"]);
+        ASSERT_EQUALS("\n\n\n\n\n\n\n\n\n\n\nint main() {}\n", actual[""]);
+        ASSERT_EQUALS("\n\nclass A{};\n\n\n\n\n\n\n\n\nint main() {}\n", actual["ABC"]);
+
+        // The lines of the header are mapped to the header
+        std::istringstream codeStream2(actual["ABC"]);
+        Tokenizer tok2(&settings, this);
+        tok2.setSourceLocations(&preprocessor.getSourceLocations());
+        tok2.tokenize(codeStream2, "main.cpp");
+        ASSERT_EQUALS("[testpreprocessor_abc.h:1]", tok2.fileLine(tok2.tokens()));
+        ASSERT_EQUALS("[main.cpp:4]", tok2.fileLine(Token::findmatch(tok2.tokens(), "main")));
+    }
+
+    void sourceLocations()
+    {
+        const HeaderFile a("testpreprocessor_a.h", "a1;\n"
+                           "#include \"testpreprocessor_b.h\"\n"
+                           "a3;\n");
+        const HeaderFile b("testpreprocessor_b.h", "b1;\n"
+                           "b2;\n");
+        const char filedata[] = "x;\n"
+                                "#include \"testpreprocessor_a.h\"\n"
+                                "y;\n";
+
+        std::istringstream istr(filedata);
+        std::map<std::string, std::string> actual;
+        Settings settings;
+        Preprocessor preprocessor(&settings, this);
+        preprocessor.preprocess(istr, actual, "main.cpp");
+        ASSERT_EQUALS("x;\n\na1;\n\nb1;\nb2;\na3;\ny;\n", actual[""]);
+
+        // The included lines follow the #include lines, one range per file switch
+        const SourceLocations &locations = preprocessor.getSourceLocations();
+        ASSERT_EQUALS(5, static_cast<unsigned int>(locations.ranges().size()));
+        ASSERT_EQUALS(3, static_cast<unsigned int>(locations.files().size()));
+
+        const char * const expected[] = { "main.cpp:1", "main.cpp:2", "testpreprocessor_a.h:1",
+                                          "testpreprocessor_a.h:2", "testpreprocessor_b.h:1",
+                                          "testpreprocessor_b.h:2", "testpreprocessor_a.h:3",
+                                          "main.cpp:3"
+                                        };
+        for (unsigned int line = 1; line <= 8; ++line) {
+            unsigned int file = 0, fileLine = 0;
+            locations.find(line, file, fileLine);
+            std::ostringstream loc;
+            loc << (file == 0 ? std::string("main.cpp") : locations.files()[file]) << ":" << fileLine;
+            ASSERT_EQUALS(expected[line - 1], loc.str());
+        }
+    }
+
+    void directiveTree()
+    {
+        const char filedata[] = "#ifdef A\n"
+                                "#ifdef B\n"
+                                "a1;\n"
+                                "#else\n"
+                                "c;\n"
+                                "#endif\n"
+                                "#elif X==2\n"
+                                "a2;\n"
+                                "#else\n"
+                                "#define X 2\n"
+                                "#endif\n"
+                                "#if X==2\n"
+                                "b;\n"
+                                "#endif\n";
+
+        // The same tree is used for all configurations
+        Settings settings;
+        const DirectiveTree directives(filedata, &settings);
+        ASSERT_EQUALS("\n\n\n\n\n\n\n\n\n\n\n\nb;\n\n", Preprocessor::getcode(directives, "", "file.c", &settings, this));
+        ASSERT_EQUALS("\n\n\n\nc;\n\n\n\n\n\n\n\n\n\n", Preprocessor::getcode(directives, "A", "file.c", &settings, this));
+        ASSERT_EQUALS("\n\na1;\n\n\n\n\n\n\n\n\n\n\n\n", Preprocessor::getcode(directives, "A;B", "file.c", &settings, this));
+        ASSERT_EQUALS("\n\n\n\n\n\n\na2;\n\n\n\n\nb;\n\n", Preprocessor::getcode(directives, "X=2", "file.c", &settings, this));
+    }
+
+    void configurationObjects()
+    {
+        const char filedata[] = "#ifdef A\n"
+                                "a;\n"
+                                "#ifdef B\n"
+                                "b;\n"
+                                "#endif\n"
+                                "#endif\n"
+                                "#if X==2\n"
+                                "x;\n"
+                                "#endif\n";
+
+        // The configurations are created with their defines
+        Settings settings;
+        Preprocessor preprocessor(&settings, this);
+        std::istringstream istr(filedata);
+        std::string data;
+        std::list<Preprocessor::Configuration> configurations;
+        preprocessor.preprocess(istr, data, configurations, "file.c", std::list<std::string>());
+        ASSERT_EQUALS(3, static_cast<unsigned int>(configurations.size()));
+        std::list<Preprocessor::Configuration>::const_iterator cfg = configurations.begin();
+        ASSERT_EQUALS("", cfg->name);
+        ASSERT_EQUALS(0, static_cast<unsigned int>(cfg->defines.size()));
+        ++cfg;
+        ASSERT_EQUALS("A", cfg->name);
+        ASSERT_EQUALS(1, static_cast<unsigned int>(cfg->defines.count("A")));
+        ++cfg;
+        ASSERT_EQUALS("A;B", cfg->name);
+        ASSERT_EQUALS(2, static_cast<unsigned int>(cfg->defines.size()));
+
+        // The code is the same as for the configuration strings
+        const DirectiveTree directives(data, &settings);
+        for (cfg = configurations.begin(); cfg != configurations.end(); ++cfg)
+            ASSERT_EQUALS(Preprocessor::getcode(directives, cfg->name, "file.c", &settings, this), Preprocessor::getcode(directives, *cfg, "file.c", &settings, this));
+        ASSERT_EQUALS("\na;\n\nb;\n\n\n\n\n\n", Preprocessor::getcode(directives, configurations.back(), "file.c", &settings, this));
+
+        // Configuration string with a value
+        const Preprocessor::Configuration x("A;X=2");
+        ASSERT_EQUALS("A;X=2", x.name);
+        ASSERT_EQUALS(2, static_cast<unsigned int>(x.defines.size()));
+        ASSERT_EQUALS("2", x.defines.find("X")->second);
+        ASSERT_EQUALS("\na;\n\n\n\n\n\nx;\n\n", Preprocessor::getcode(directives, x, "file.c", &settings, this));
     }
 
     void newlines()
@@ -758,6 +931,44 @@ private:
         }
     }
 
+    void match_cfg_def_expressions()
+    {
+        {
+            std::map<std::string, std::string> cfg;
+            cfg["A"] = "";
+            cfg["B"] = "";
+
+            ASSERT_EQUALS(true, Preprocessor::match_cfg_def(cfg, "(defined(A)||defined(C))&&defined(B)"));
+            ASSERT_EQUALS(true, Preprocessor::match_cfg_def(cfg, "defined(A)&&defined(C)||defined(B)"));
+            ASSERT_EQUALS(false, Preprocessor::match_cfg_def(cfg, "defined A&&!(defined B||defined C)"));
+            ASSERT_EQUALS(true, Preprocessor::match_cfg_def(cfg, "(A)&&B"));
+        }
+
+        {
+            std::map<std::string, std::string> cfg;
+            cfg["A"] = "3";
+
+            ASSERT_EQUALS(true, Preprocessor::match_cfg_def(cfg, "A*2==6"));
+            ASSERT_EQUALS(true, Preprocessor::match_cfg_def(cfg, "A>2&&A<4"));
+            ASSERT_EQUALS(true, Preprocessor::match_cfg_def(cfg, "(1<<A)==0x8"));
+            ASSERT_EQUALS(false, Preprocessor::match_cfg_def(cfg, "A-3"));
+            ASSERT_EQUALS(false, Preprocessor::match_cfg_def(cfg, "A/0"));
+            ASSERT_EQUALS(false, Preprocessor::match_cfg_def(cfg, "(-9223372036854775807-1)/-1"));
+            ASSERT_EQUALS(false, Preprocessor::match_cfg_def(cfg, "(-9223372036854775807-1)%-1"));
+        }
+
+        {
+            // values of macros that are not defined are unknown
+            std::map<std::string, std::string> cfg;
+
+            ASSERT_EQUALS(false, Preprocessor::match_cfg_def(cfg, "X==0"));
+            ASSERT_EQUALS(false, Preprocessor::match_cfg_def(cfg, "X!=0"));
+            ASSERT_EQUALS(true, Preprocessor::match_cfg_def(cfg, "X>1||1"));
+            ASSERT_EQUALS(false, Preprocessor::match_cfg_def(cfg, "0&&X"));
+            ASSERT_EQUALS(true, Preprocessor::match_cfg_def(cfg, "!X"));
+        }
+    }
+
 
     void if_cond1()
     {
@@ -1407,6 +1618,21 @@ private:
         ASSERT_EQUALS("\n\n", OurPreprocessor::expandMacros(filedata));
     }
 
+    void macro_simple14()
+    {
+        // Many macros, redefined and undefined macros
+        std::ostringstream filedata;
+        for (int i = 0; i < 200; ++i)
+            filedata << "#define M" << i << "(x) x+" << i << "\n";
+        filedata << "#define M5(x) x-5\n"
+                 << "#undef M7\n"
+                 << "M0(a) M5(a) M7(a) M199(a);\n";
+
+        std::string expected(202, '\n');
+        expected += "a+0 a-5 M7(a) a+199;\n";
+        ASSERT_EQUALS(expected, OurPreprocessor::expandMacros(filedata.str()));
+    }
+
     void macroInMacro()
     {
         {
@@ -1964,28 +2190,37 @@ private:
         }
 
         {
-            const char filedata[] = "#file \"abc.h\"\n"
+            const char filedata[] = "\n"
                                     "#define a\n"
-                                    "\"\n"
-                                    "#endfile\n";
+                                    "\"\n";
+
+            // abc.h is included at line 1
+            SourceLocations locations;
+            locations.add(1, "file.cpp", 1);
+            locations.add(2, "abc.h", 1);
 
             // expand macros..
             errout.str("");
-            const std::string actual(OurPreprocessor::expandMacros(filedata, this));
+            const std::string actual(OurPreprocessor::expandMacros(filedata, this, locations));
 
             ASSERT_EQUALS("", actual);
             ASSERT_EQUALS("[abc.h:2]: (error) No pair for character (\"). Can't process file. File is either invalid or unicode, which is currently not supported.\n", errout.str());
         }
 
         {
-            const char filedata[] = "#file \"abc.h\"\n"
+            const char filedata[] = "\n"
                                     "#define a\n"
-                                    "#endfile\n"
                                     "\"\n";
 
+            // abc.h is included at line 1
+            SourceLocations locations;
+            locations.add(1, "file.cpp", 1);
+            locations.add(2, "abc.h", 1);
+            locations.add(3, "file.cpp", 2);
+
             // expand macros..
             errout.str("");
-            const std::string actual(OurPreprocessor::expandMacros(filedata, this));
+            const std::string actual(OurPreprocessor::expandMacros(filedata, this, locations));
 
             ASSERT_EQUALS("", actual);
             ASSERT_EQUALS("[file.cpp:2]: (error) No pair for character (\"). Can't process file. File is either invalid or unicode, which is currently not supported.\n", errout.str());
@@ -2196,6 +2431,105 @@ private:
         }
     }
 
+    void includeGuard()
+    {
+        ASSERT_EQUALS("A_H", OurPreprocessor::getIncludeGuard("#ifndef A_H\n#define A_H\nint a;\n#endif\n"));
+        ASSERT_EQUALS("A_H", OurPreprocessor::getIncludeGuard("\n#if !defined(A_H)\n\n#define A_H 1\n#ifdef B\n#else\n#endif\n#endif"));
+        ASSERT_EQUALS("#pragma once", OurPreprocessor::getIncludeGuard("\n#pragma once\nint a;\n"));
+
+        // not include guards
+        ASSERT_EQUALS("", OurPreprocessor::getIncludeGuard("int a;\n"));
+        ASSERT_EQUALS("", OurPreprocessor::getIncludeGuard("int a;\n#ifndef A_H\n#define A_H\n#endif\n"));
+        ASSERT_EQUALS("", OurPreprocessor::getIncludeGuard("#ifndef A_H\n#define A_HH\n#endif\n"));
+        ASSERT_EQUALS("", OurPreprocessor::getIncludeGuard("#ifndef A_H\n#define A_H\n#endif\nint a;\n"));
+        ASSERT_EQUALS("", OurPreprocessor::getIncludeGuard("#ifndef A_H\n#define A_H\n#else\nint a;\n#endif\n"));
+        ASSERT_EQUALS("", OurPreprocessor::getIncludeGuard("#ifndef A_H\n#define A_H\n"));
+    }
+
+    void includeGuardedHeaderTwice()
+    {
+        // a.h is included by both b.h and c.h
+        const HeaderFile a("testpreprocessor_a.h", "#ifndef A_H\n#define A_H\nint a;\n#endif\n");
+        const HeaderFile b("testpreprocessor_b.h", "#include \"testpreprocessor_a.h\"\nint b;\n");
+        const HeaderFile c("testpreprocessor_c.h", "#include \"testpreprocessor_a.h\"\nint c;\n");
+
+        const std::string actual(preprocessIncludes("#include \"testpreprocessor_b.h\"\n"
+                                 "#include \"testpreprocessor_c.h\"\n"));
+        ASSERT_EQUALS(1, countOf(actual, "int a;"));
+        ASSERT_EQUALS(1, countOf(actual, "int b;"));
+        ASSERT_EQUALS(1, countOf(actual, "int c;"));
+        ASSERT_EQUALS("", errout.str());
+    }
+
+    void includeGuardedHeaderConditional()
+    {
+        // The first include is conditional => the header is included again
+        const HeaderFile a("testpreprocessor_a.h", "#ifndef A_H\n#define A_H\nint a;\n#endif\n");
+        const HeaderFile b("testpreprocessor_b.h", "#include \"testpreprocessor_a.h\"\n");
+        const HeaderFile c("testpreprocessor_c.h", "#include \"testpreprocessor_a.h\"\n");
+
+        const std::string actual(preprocessIncludes("#ifdef X\n"
+                                 "#include \"testpreprocessor_b.h\"\n"
+                                 "#endif\n"
+                                 "#include \"testpreprocessor_c.h\"\n"));
+        ASSERT_EQUALS(2, countOf(actual, "int a;"));
+
+        Settings settings;
+        ASSERT_EQUALS(1, countOf(Preprocessor::getcode(actual, "", "file.c", &settings, this), "int a;"));
+        ASSERT_EQUALS(1, countOf(Preprocessor::getcode(actual, "X", "file.c", &settings, this), "int a;"));
+    }
+
+    void includeGuardedHeaderUndef()
+    {
+        // The guard is undefined in another header => the header is included again
+        const HeaderFile a("testpreprocessor_a.h", "#ifndef A_H\n#define A_H\nint a;\n#endif\n");
+        const HeaderFile b("testpreprocessor_b.h", "#include \"testpreprocessor_a.h\"\n");
+        const HeaderFile c("testpreprocessor_c.h", "#include \"testpreprocessor_a.h\"\n");
+        const HeaderFile d("testpreprocessor_d.h", "#undef A_H\n");
+
+        const std::string actual(preprocessIncludes("#include \"testpreprocessor_b.h\"\n"
+                                 "#include \"testpreprocessor_d.h\"\n"
+                                 "#include \"testpreprocessor_c.h\"\n"));
+        ASSERT_EQUALS(2, countOf(actual, "int a;"));
+    }
+
+    void includePragmaOnce()
+    {
+        const HeaderFile p("testpreprocessor_p.h", "#pragma once\nint p;\n");
+        const HeaderFile b("testpreprocessor_b.h", "#include \"testpreprocessor_p.h\"\n");
+        const HeaderFile c("testpreprocessor_c.h", "#include \"testpreprocessor_p.h\"\n");
+
+        const std::string actual(preprocessIncludes("#include \"testpreprocessor_b.h\"\n"
+                                 "#include \"testpreprocessor_c.h\"\n"));
+        ASSERT_EQUALS(1, countOf(actual, "int p;"));
+        ASSERT_EQUALS("", errout.str());
+    }
+
+    void missingIncludeLineNumber()
+    {
+        // The lines of the spliced headers are not counted
+        const HeaderFile a("testpreprocessor_a.h", "int a1;\n#include \"testpreprocessor_missing1.h\"\nint a2;\n");
+        const HeaderFile b("testpreprocessor_b.h", "#ifndef B_H\n#define B_H\nint b1;\nint b2;\n#endif\n");
+
+        errout.str("");
+        std::istringstream istr("#include \"testpreprocessor_a.h\"\n"
+                                "#include \"testpreprocessor_missing2.h\"\n"
+                                "\n"
+                                "#include \"testpreprocessor_b.h\"\n"
+                                "#include \"testpreprocessor_b.h\"\n"
+                                "#include \"testpreprocessor_missing3.h\"\n");
+        std::string processedFile;
+        std::list<std::string> configurations;
+        Settings settings;
+        settings.addEnabled("missingInclude");
+        Preprocessor preprocessor(&settings, this);
+        preprocessor.preprocess(istr, processedFile, configurations, "file.c", std::list<std::string>());
+
+        ASSERT_EQUALS("[testpreprocessor_a.h:2]: (information) Include file: \"testpreprocessor_missing1.h\" not found.\n"
+                      "[file.c:2]: (information) Include file: \"testpreprocessor_missing2.h\" not found.\n"
+                      "[file.c:6]: (information) Include file: \"testpreprocessor_missing3.h\" not found.\n", errout.str());
+    }
+
     void ifdef_ifdefined()
     {
         const char filedata[] = "#ifdef ABC\n"
@@ -2362,6 +2696,30 @@ private:
         ASSERT(actual.find("BAR;FOO") != actual.end());
     }
 
+    void redundant_config2()
+    {
+        const char filedata[] = "#ifdef FOO\n"
+                                "#ifdef BAR\n"
+                                "#ifdef FOO\n"
+                                "    a = 1;\n"
+                                "#endif\n"
+                                "#endif\n"
+                                "#endif\n";
+
+        // Preprocess => actual result..
+        std::istringstream istr(filedata);
+        std::map<std::string, std::string> actual;
+        Settings settings;
+        Preprocessor preprocessor(&settings, this);
+        preprocessor.preprocess(istr, actual, "file.c");
+
+        // Compare results..
+        ASSERT_EQUALS(3, (int)actual.size());
+        ASSERT(actual.find("") != actual.end());
+        ASSERT(actual.find("FOO") != actual.end());
+        ASSERT(actual.find("BAR;FOO") != actual.end());
+    }
+
 
     void endfile()
     {
@@ -114,6 +114,7 @@ private:
         TEST_CASE(template_default_parameter);
         TEST_CASE(template_default_type);
         TEST_CASE(template_typename);
+        TEST_CASE(template_instantiation_limit);
 
         TEST_CASE(namespaces);
 
@@ -230,6 +231,7 @@ private:
         TEST_CASE(simplifyTypedef70); // ticket #2348
         TEST_CASE(simplifyTypedef71); // ticket #2348
         TEST_CASE(simplifyTypedef72); // ticket #2375
+        TEST_CASE(simplifyTypedef73); // unused typedefs
 
         TEST_CASE(simplifyTypedefFunction1);
         TEST_CASE(simplifyTypedefFunction2); // ticket #1685
@@ -271,6 +273,7 @@ private:
         TEST_CASE(enum15);
         TEST_CASE(enum16); // ticket #1988
         TEST_CASE(enum17); // ticket #2381 (duplicate enums)
+        TEST_CASE(enum18); // unused enumerators
 
         // remove "std::" on some standard functions
         TEST_CASE(removestd);
@@ -2108,6 +2111,17 @@ private:
         }
     }
 
+    void template_instantiation_limit()
+    {
+        // Recursive template without a specialization that stops the recursion
+        const char code[] = "template <int n> struct A { A<n+1> a; };\n"
+                            "A<0> a;\n";
+        const std::string actual(sizeof_(code));
+        ASSERT_EQUALS("; A<0> a ; struct A<0> {", actual.substr(0, 24));
+        ASSERT_EQUALS("[test.cpp:1]: (information) Template instantiation limit reached when instantiating 'A<100>'. "
+                      "The remaining instantiations are not simplified.\n", errout.str());
+    }
+
     void namespaces()
     {
         {
@@ -4756,6 +4770,17 @@ private:
         }
     }
 
+    void simplifyTypedef73()
+    {
+        // typedefs that are not used are only removed
+        const char code[] = "typedef int A;\n"
+                            "typedef struct { int x; } B;\n"
+                            "typedef unsigned long C;\n"
+                            "C c;\n";
+        ASSERT_EQUALS("; struct B { int x ; } ; unsigned long c ;", tok(code, false));
+        ASSERT_EQUALS("", errout.str());
+    }
+
     void simplifyTypedefFunction1()
     {
         {
@@ -5963,6 +5988,15 @@ private:
         ASSERT_EQUALS("", errout.str());
     }
 
+    void enum18()
+    {
+        // enumerators that are not used are only removed
+        const char code[] = "enum ab { a, b, c };\n"
+                            "int x = c;\n";
+        ASSERT_EQUALS("; int x ; x = 2 ;", tok(code, false));
+        ASSERT_EQUALS("", errout.str());
+    }
+
     void removestd()
     {
         ASSERT_EQUALS("; strcpy ( a , b ) ;", tok("; std::strcpy(a,b);"));
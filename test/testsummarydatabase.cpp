@@ -0,0 +1,112 @@
+/*
+ * Cppcheck - A tool for static C/C++ code analysis
+ * Copyright (C) 2007-2010 Daniel Marjamäki and Cppcheck team.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "testsuite.h"
+#include "summarydatabase.h"
+
+#include <sstream>
+
+class TestSummaryDatabase : public TestFixture
+{
+public:
+    TestSummaryDatabase() : TestFixture("TestSummaryDatabase")
+    { }
+
+private:
+
+    void run()
+    {
+        TEST_CASE(hash);
+        TEST_CASE(find);
+        TEST_CASE(saveAndLoad);
+        TEST_CASE(loadInvalid);
+    }
+
+    void hash()
+    {
+        ASSERT_EQUALS(SummaryDatabase::hash("void f() { }"), SummaryDatabase::hash("void f() { }"));
+        ASSERT(SummaryDatabase::hash("void f() { }") != SummaryDatabase::hash("void g() { }"));
+        ASSERT(SummaryDatabase::hash("") != SummaryDatabase::hash(std::string(1, '\0')));
+    }
+
+    void find()
+    {
+        SummaryDatabase db;
+        ASSERT_EQUALS(false, db.changed());
+
+        SummaryDatabase::Data data;
+        data["Null pointer"].insert("1 f");
+        db.insert("a.c", "123", data);
+        ASSERT_EQUALS(true, db.changed());
+
+        SummaryDatabase::Data data2;
+        ASSERT_EQUALS(true, db.find("a.c", "123", data2));
+        ASSERT_EQUALS(1, (int)data2["Null pointer"].count("1 f"));
+
+        // file has been changed
+        ASSERT_EQUALS(false, db.find("a.c", "456", data2));
+
+        // unknown file
+        ASSERT_EQUALS(false, db.find("b.c", "123", data2));
+    }
+
+    void saveAndLoad()
+    {
+        SummaryDatabase db;
+        SummaryDatabase::Data data;
+        data["Memory leaks (function variables)"].insert("noreturn fatal");
+        data["Memory leaks (function variables)"].insert("alloc create 1");
+        data["Uninitialized variables"].insert("foo");
+        db.insert("dir name/a.c", "12ab-3", data);
+
+        std::ostringstream ostr;
+        db.save(ostr);
+        ASSERT_EQUALS("cppcheck-summaries 1\n"
+                      "file 12ab-3 dir name/a.c\n"
+                      "Memory leaks (function variables)\talloc create 1\n"
+                      "Memory leaks (function variables)\tnoreturn fatal\n"
+                      "Uninitialized variables\tfoo\n", ostr.str());
+
+        SummaryDatabase db2;
+        std::istringstream istr(ostr.str());
+        ASSERT_EQUALS(true, db2.load(istr));
+        ASSERT_EQUALS(false, db2.changed());
+
+        SummaryDatabase::Data data2;
+        ASSERT_EQUALS(true, db2.find("dir name/a.c", "12ab-3", data2));
+        ASSERT_EQUALS(true, data == data2);
+    }
+
+    void loadInvalid()
+    {
+        SummaryDatabase db;
+        std::istringstream istr("void f() { }\n");
+        ASSERT_EQUALS(false, db.load(istr));
+
+        // the entries before the invalid line are not loaded
+        std::istringstream istr2("cppcheck-summaries 1\n"
+                                 "file 123 a.c\n"
+                                 "Null pointer\t1 f\n"
+                                 "void f() { }\n");
+        ASSERT_EQUALS(false, db.load(istr2));
+        SummaryDatabase::Data data;
+        ASSERT_EQUALS(false, db.find("a.c", "123", data));
+    }
+};
+
+REGISTER_TEST(TestSummaryDatabase)
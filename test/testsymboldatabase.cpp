@@ -18,6 +18,7 @@
 
 #include "testsuite.h"
 #include "testutils.h"
+#include <sstream>
 #define private public
 #include "symboldatabase.h"
 
@@ -57,6 +58,8 @@ private:
         TEST_CASE(test_isVariableDeclarationIdentifiesDeclarationWithIndirection);
         TEST_CASE(test_isVariableDeclarationIdentifiesDeclarationWithMultipleIndirection);
 
+        TEST_CASE(callGraph);
+
     }
 
     void test_isVariableDeclarationCanHandleNull()
@@ -177,7 +180,40 @@ private:
         ASSERT_EQUALS("p", vartok->str());
         ASSERT_EQUALS("int", typetok->str());
     }
+
+    void callGraph()
+    {
+        const char code[] = "void a() { exit(0); }\n"
+                            "void b() { a(); if (x) { a(); } }\n"
+                            "class Fred {\n"
+                            "    void f() { b(); }\n"
+                            "};\n";
+        Settings settings;
+        Tokenizer tokenizer(&settings, this);
+        std::istringstream istr(code);
+        tokenizer.tokenize(istr, "test.cpp");
+        const SymbolDatabase *db = tokenizer.getSymbolDatabase();
+
+        const SymbolDatabase::SpaceInfo *a = db->findFunctionScope("a");
+        const SymbolDatabase::SpaceInfo *b = db->findFunctionScope("b");
+        const SymbolDatabase::SpaceInfo *f = db->findFunctionScope("f");
+        ASSERT(a != NULL && b != NULL && f != NULL);
+        ASSERT(NULL == db->findFunctionScope("exit"));
+
+        // calls to a function
+        const std::vector<SymbolDatabase::CallSite> &callsToA = db->getCallSites("a");
+        ASSERT_EQUALS(2, (int)callsToA.size());
+        ASSERT_EQUALS(2, callsToA[0].tok->linenr());
+        ASSERT(b == callsToA[0].caller && b == callsToA[1].caller);
+        ASSERT_EQUALS(1, (int)db->getCallSites("exit").size());
+        ASSERT_EQUALS(0, (int)db->getCallSites("if").size());
+
+        // calls in a function
+        const std::vector<SymbolDatabase::CallSite> &callsInF = db->getCalls(f);
+        ASSERT_EQUALS(1, (int)callsInF.size());
+        ASSERT_EQUALS("b", callsInF[0].tok->str());
+        ASSERT_EQUALS(2, (int)db->getCalls(b).size());
+    }
 };
 
 REGISTER_TEST(TestSymbolDatabase)
-
@@ -80,6 +80,8 @@ private:
         TEST_CASE(no_errors_equal_amount_files);
         TEST_CASE(one_error_less_files);
         TEST_CASE(one_error_several_files);
+        TEST_CASE(errors_several_configurations);
+        TEST_CASE(preprocessor_error);
     }
 
     void deadlock_with_many_errors()
@@ -140,6 +142,33 @@ private:
         oss << "}\n";
         check(2, 20, 20, oss.str());
     }
+
+    void errors_several_configurations()
+    {
+        // The configurations are checked in separate processes and the
+        // results are merged per file
+        std::ostringstream oss;
+        oss << "int main()\n"
+            << "{\n"
+            << "#ifdef A\n"
+            << "  {char *a = malloc(10);}\n"
+            << "#else\n"
+            << "  {char *b = malloc(10);}\n"
+            << "#endif\n"
+            << "}\n";
+        check(2, 2, 2, oss.str());
+        ASSERT(errout.str().find("[file_1.cpp:4]: (error) Memory leak: a") != std::string::npos);
+        ASSERT(errout.str().find("[file_1.cpp:6]: (error) Memory leak: b") != std::string::npos);
+        ASSERT(errout.str().find("[file_2.cpp:4]: (error) Memory leak: a") != std::string::npos);
+        ASSERT(errout.str().find("[file_2.cpp:6]: (error) Memory leak: b") != std::string::npos);
+    }
+
+    void preprocessor_error()
+    {
+        // The file has no configurations to check
+        check(2, 1, 1, "#if (A\nint a;\n#endif\n");
+        ASSERT(errout.str().find("[file_1.cpp:1]: (error) mismatching number of '(' and ')' in this line: (A") != std::string::npos);
+    }
 };
 
 REGISTER_TEST(TestThreadExecutor)
@@ -46,6 +46,8 @@ private:
         TEST_CASE(matchNumeric);
         TEST_CASE(matchBoolean);
         TEST_CASE(matchOr);
+
+        TEST_CASE(numericValue);
     }
 
     void nextprevious()
@@ -222,6 +224,24 @@ private:
         ASSERT_EQUALS(false, Token::Match(logicalOr.tokens(), "%or%"));
         ASSERT_EQUALS(false, Token::Match(bitwiseOr.tokens(), "%oror%"));
     }
+
+    void numericValue()
+    {
+        Token tok(0);
+        tok.str("0x10");
+        ASSERT_EQUALS(false, tok.numericValue().isFloat());
+        ASSERT_EQUALS(16, (int)tok.numericValue().getInt());
+
+        // changing the string invalidates the cached value
+        tok.str("1.5");
+        ASSERT_EQUALS(true, tok.numericValue().isFloat());
+        ASSERT_EQUALS("1.5", MathLib::toString<double>(tok.numericValue().getDouble()));
+
+        // setting the value updates the string
+        tok.numericValue(MathLib::Value(MathLib::bigint(42)));
+        ASSERT_EQUALS("42", tok.str());
+        ASSERT_EQUALS(42, (int)tok.numericValue().getInt());
+    }
 };
 
 REGISTER_TEST(TestToken)
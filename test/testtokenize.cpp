@@ -25,6 +25,7 @@
 #include "tokenize.h"
 #include "token.h"
 #include "settings.h"
+#include "sourcelocations.h"
 #include <cstring>
 
 extern std::ostringstream errout;
@@ -52,6 +53,8 @@ private:
         TEST_CASE(tokenize12);
         TEST_CASE(tokenize13);  // bailout if the code contains "@" - that is not handled well.
         TEST_CASE(tokenize14);  // tokenize "0X10" => 16
+        TEST_CASE(tokenize15);  // splitting of operators, numbers and strings
+        TEST_CASE(tokenize16);  // long names
 
         // don't freak out when the syntax is wrong
         TEST_CASE(wrong_syntax);
@@ -132,6 +135,8 @@ private:
         TEST_CASE(simplifyKnownVariablesBailOutMemberFunction);
         TEST_CASE(simplifyKnownVariablesBailOutConditionalIncrement);
         TEST_CASE(simplifyKnownVariablesBailOutSwitchBreak);	// ticket #2324
+        TEST_CASE(simplifyKnownVariablesChain);
+        TEST_CASE(simplifyKnownVariablesLongFunction);
 
         TEST_CASE(varid1);
         TEST_CASE(varid2);
@@ -182,6 +187,8 @@ private:
         TEST_CASE(varidclass6);
         TEST_CASE(varidclass7);
         TEST_CASE(varidclass8);
+        TEST_CASE(varidLongFunction);
+        TEST_CASE(varOccurrences);
 
         TEST_CASE(file1);
         TEST_CASE(file2);
@@ -489,6 +496,21 @@ private:
         ASSERT_EQUALS("; 16 ;", tokenizeAndStringify(";0X10;"));
     }
 
+    void tokenize15()
+    {
+        ASSERT_EQUALS("x = a ++ + b && c >> 1.5e+3 ;", tokenizeAndStringify("x=a+++b &&c>>1.5e+3;"));
+        ASSERT_EQUALS("s = \"a\\\"b\\\\\" ; c = '\\'' ;", tokenizeAndStringify("s=\"a\\\"b\\\\\";c='\\'';"));
+    }
+
+    void tokenize16()
+    {
+        // names that are longer than 16 characters, and names with characters that are not letters, digits or '_'
+        ASSERT_EQUALS("abcdefghijklmnopqrstuvwxyz_0123456789_ABCDEFGHIJKLMNOPQRSTUVWXYZ = x ;",
+                      tokenizeAndStringify("abcdefghijklmnopqrstuvwxyz_0123456789_ABCDEFGHIJKLMNOPQRSTUVWXYZ=x;"));
+        ASSERT_EQUALS("abcdefghijklmnop$qrstuvwxyz = abcdefghijklmnopqrstuvwxyz`x ;",
+                      tokenizeAndStringify("abcdefghijklmnop$qrstuvwxyz=abcdefghijklmnopqrstuvwxyz`x;"));
+    }
+
     void wrong_syntax()
     {
         {
@@ -2039,6 +2061,36 @@ private:
         ASSERT_EQUALS(expected, tokenizeAndStringify(code,true));
     }
 
+    void simplifyKnownVariablesChain()
+    {
+        // the whole chain is propagated in one pass
+        const char code[] = "int f() {\n"
+                            "    int x0 = 1;\n"
+                            "    int x1 = x0 + 1;\n"
+                            "    int x2 = x1 * 3;\n"
+                            "    return x2;\n"
+                            "}\n";
+        ASSERT_EQUALS("int f ( ) { int x0 ; x0 = 1 ; int x1 ; x1 = 2 ; int x2 ; x2 = 6 ; return 6 ; }",
+                      simplifyKnownVariables(code));
+    }
+
+    void simplifyKnownVariablesLongFunction()
+    {
+        // Generated function with 2000 statements. Each statement uses the
+        // variable assigned in the previous one. This used to take time
+        // proportional to the cube of the function length.
+        std::ostringstream code;
+        code << "int f() {\n"
+             << "    int x0 = 0;\n";
+        for (unsigned int i = 1; i < 2000; ++i)
+            code << "    int x" << i << " = x" << (i - 1) << " + 1;\n";
+        code << "    return x1999;\n"
+             << "}\n";
+
+        const std::string actual(simplifyKnownVariables(code.str().c_str()));
+        ASSERT_EQUALS("x1999 = 1999 ; return 1999 ; }", actual.substr(actual.size() - 30));
+    }
+
     std::string tokenizeDebugListing(const std::string &code, bool simplify = false)
     {
         errout.str("");
@@ -3166,21 +3218,89 @@ private:
     }
 
 
+    void varidLongFunction()
+    {
+        // Generated function with 2000 declarations and a struct member.
+        // The variable ids used to be set by scanning the rest of the
+        // function for each declaration.
+        std::ostringstream code;
+        std::ostringstream expected;
+        code << "void f() {\n"
+             << "    struct S s; s.x = 0;\n";
+        expected << "\n\n##file 0\n"
+                 << "1: void f ( ) {\n"
+                 << "2: struct S s@1 ; s@1 . x@2002 = 0 ;\n";
+        for (unsigned int i = 1; i <= 2000; ++i)
+        {
+            code << "    int x" << i << " = s.x + x" << (i - 1) << ";\n";
+            expected << (i + 2) << ": int x" << i << "@" << (i + 1) << " ; x" << i << "@" << (i + 1) << " = s@1 . x@2002 + x" << (i - 1);
+            if (i > 1)
+                expected << "@" << i;
+            expected << " ;\n";
+        }
+        code << "}\n";
+        expected << "2003: }\n";
+
+        ASSERT_EQUALS(expected.str(), tokenizeDebugListing(code.str()));
+    }
+
+    void varOccurrences()
+    {
+        const char code[] = "void f(int a, int b) {\n"
+                            "    a = g(b);\n"
+                            "    b = a + 1;\n"
+                            "    ++a;\n"
+                            "    h(a, b--);\n"
+                            "}\n";
+
+        errout.str("");
+        Settings settings;
+        Tokenizer tokenizer(&settings, this);
+        std::istringstream istr(code);
+        tokenizer.tokenize(istr, "test.cpp");
+
+        const unsigned int varid = Token::findmatch(tokenizer.tokens(), "a =")->varId();
+        const std::vector<const Token *> &a = tokenizer.getVarOccurrences(varid);
+        ASSERT_EQUALS(5, (int)a.size());
+        ASSERT_EQUALS(1, a[0]->linenr());
+        ASSERT_EQUALS(2, a[1]->linenr());
+        ASSERT_EQUALS(3, a[2]->linenr());
+        ASSERT_EQUALS(4, a[3]->linenr());
+        ASSERT_EQUALS(5, a[4]->linenr());
+
+        const std::vector<const Token *> &b = tokenizer.getVarOccurrences(varid + 1);
+        ASSERT_EQUALS(4, (int)b.size());
+        ASSERT_EQUALS(1, b[0]->linenr());
+        ASSERT_EQUALS(2, b[1]->linenr());
+        ASSERT_EQUALS(3, b[2]->linenr());
+        ASSERT_EQUALS(5, b[3]->linenr());
+        ASSERT_EQUALS(0, (int)tokenizer.getVarOccurrences(0).size());
+
+        ASSERT(Token::findmatch(tokenizer.tokens(), "+ %varid%", varid) == tokenizer.findVarMatch("+ %varid%", varid, 1));
+        ASSERT(NULL == tokenizer.findVarMatch("- %varid%", varid, 1));
+    }
+
+
     void file1()
     {
         const char code[] = "a1\n"
-                            "#file \"b\"\n"
                             "b1\n"
                             "b2\n"
-                            "#endfile\n"
                             "a3\n";
 
+        // b is included at line 2 of a
+        SourceLocations locations;
+        locations.add(1, "a", 1);
+        locations.add(2, "b", 1);
+        locations.add(4, "a", 3);
+
         errout.str("");
 
         Settings settings;
 
         // tokenize..
         Tokenizer tokenizer(&settings, this);
+        tokenizer.setSourceLocations(&locations);
         std::istringstream istr(code);
         tokenizer.tokenize(istr, "a");
 
@@ -3196,27 +3316,32 @@ private:
     void file2()
     {
         const char code[] = "a1\n"
-                            "#file \"b\"\n"
                             "b1\n"
                             "b2\n"
-                            "#file \"c\"\n"
                             "c1\n"
                             "c2\n"
-                            "#endfile\n"
                             "b4\n"
-                            "#endfile\n"
                             "a3\n"
-                            "#file \"d\"\n"
                             "d1\n"
-                            "#endfile\n"
                             "a5\n";
 
+        // b is included at line 2 of a, c at line 3 of b and d at line 4 of a
+        SourceLocations locations;
+        locations.add(1, "a", 1);
+        locations.add(2, "b", 1);
+        locations.add(4, "c", 1);
+        locations.add(6, "b", 4);
+        locations.add(7, "a", 3);
+        locations.add(8, "d", 1);
+        locations.add(9, "a", 5);
+
         errout.str("");
 
         Settings settings;
 
         // tokenize..
         Tokenizer tokenizer(&settings, this);
+        tokenizer.setSourceLocations(&locations);
         std::istringstream istr(code);
         tokenizer.tokenize(istr, "a");
 
@@ -3232,9 +3357,12 @@ private:
 
     void file3()
     {
-        const char code[] = "#file \"c:\\a.h\"\n"
-                            "123\n"
-                            "#endfile\n";
+        const char code[] = "\n"
+                            "123\n";
+
+        SourceLocations locations;
+        locations.add(1, "a.cpp", 1);
+        locations.add(2, "c:\\a.h", 1);
 
         errout.str("");
 
@@ -3242,6 +3370,7 @@ private:
 
         // tokenize..
         Tokenizer tokenizer(&settings, this);
+        tokenizer.setSourceLocations(&locations);
         std::istringstream istr(code);
         tokenizer.tokenize(istr, "a.cpp");
 
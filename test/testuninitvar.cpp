@@ -18,11 +18,82 @@
 
 #include "tokenize.h"
 #include "checkuninitvar.h"
+#include "executionpath.h"
 #include "testsuite.h"
 #include <sstream>
 
 extern std::ostringstream errout;
 
+/** Execution path that counts its instances, used to find leaked execution paths */
+class CountedExecutionPath : public ExecutionPath
+{
+public:
+    CountedExecutionPath(unsigned int id) : ExecutionPath(0, id), assigned(false)
+    {
+        ++instances;
+    }
+
+    CountedExecutionPath(const CountedExecutionPath &c) : ExecutionPath(c), assigned(c.assigned)
+    {
+        ++instances;
+    }
+
+    ~CountedExecutionPath()
+    {
+        --instances;
+    }
+
+    /** number of execution paths that are not deleted */
+    static int instances;
+
+    /** number of execution paths for variables at the end of the function bodies */
+    static unsigned int pathsAtEnd;
+
+private:
+    /** no implementation */
+    void operator=(const CountedExecutionPath &);
+
+    /** is the variable assigned? */
+    bool assigned;
+
+    ExecutionPath *copy()
+    {
+        return new CountedExecutionPath(*this);
+    }
+
+    bool is_equal(const ExecutionPath *e) const
+    {
+        return (assigned == static_cast<const CountedExecutionPath *>(e)->assigned);
+    }
+
+    const Token *parse(const Token &tok, std::list<ExecutionPath *> &checks) const
+    {
+        if (Token::Match(tok.previous(), "[;{}] int %var% ;"))
+            checks.push_back(new CountedExecutionPath(tok.next()->varId()));
+        else if (Token::Match(&tok, "%var% =") && tok.varId())
+        {
+            for (std::list<ExecutionPath *>::const_iterator it = checks.begin(); it != checks.end(); ++it)
+            {
+                if ((*it)->varId == tok.varId())
+                    static_cast<CountedExecutionPath *>(*it)->assigned = true;
+            }
+        }
+        return &tok;
+    }
+
+    void end(const std::list<ExecutionPath *> &checks, const Token *) const
+    {
+        for (std::list<ExecutionPath *>::const_iterator it = checks.begin(); it != checks.end(); ++it)
+        {
+            if ((*it)->varId != 0)
+                ++pathsAtEnd;
+        }
+    }
+};
+
+int CountedExecutionPath::instances = 0;
+unsigned int CountedExecutionPath::pathsAtEnd = 0;
+
 class TestUninitVar : public TestFixture
 {
 public:
@@ -41,6 +112,9 @@ private:
         TEST_CASE(uninitvar_class);     // class/struct
         TEST_CASE(uninitvar_enum);      // enum variables
         TEST_CASE(uninitvar_if);        // handling if
+        TEST_CASE(uninitvar_widen);     // too many execution paths
+        TEST_CASE(uninitvar_timeout);   // the time for the function body is out
+        TEST_CASE(executionPathsDeleted); // no execution paths are leaked
         TEST_CASE(uninitvar_loops);     // handling for/while
         TEST_CASE(uninitvar_switch);    // handling switch
         TEST_CASE(uninitvar_references); // references
@@ -692,7 +766,95 @@ private:
     }
 
 
+    void uninitvar_widen()
+    {
+        // There are too many execution paths after the first "if". The
+        // pointers are not tracked anymore but "x" is.
+        checkUninitVar("void foo(int a)\n"
+                       "{\n"
+                       "    int x;\n"
+                       "    char *p1; char *p2; char *p3;\n"
+                       "    char *p4; char *p5; char *p6;\n"
+                       "    if (a == 1) {\n"
+                       "        p1 = malloc(10); p2 = malloc(10); p3 = malloc(10);\n"
+                       "        p4 = malloc(10); p5 = malloc(10); p6 = malloc(10);\n"
+                       "    }\n"
+                       "    if (a == 2) { foo(); }\n"
+                       "    x++;\n"
+                       "}\n");
+        ASSERT_EQUALS("[test.cpp:11]: (error) Uninitialized variable: x\n", errout.str());
+    }
+
+    /** A clock that advances 10 clocks each time it is read */
+    static std::clock_t fakeClock()
+    {
+        static std::clock_t clocks = 0;
+        clocks += 10;
+        return clocks;
+    }
+
+    void uninitvar_timeout()
+    {
+        // Many conditions before "x" is used
+        std::ostringstream code;
+        code << "void foo(int a)\n"
+             << "{\n"
+             << "    int x;\n";
+        for (unsigned int i = 0; i < 1000; ++i)
+            code << "    if (a == " << i << ") { a = 0; }\n";
+        code << "    x++;\n"
+             << "}\n";
+
+        Settings settings;
+        Tokenizer tokenizer(&settings, this);
+        std::istringstream istr(code.str());
+        tokenizer.tokenize(istr, "test.cpp");
+        tokenizer.simplifyTokenList();
+
+        // No time limit. The execution path for "x" reaches the end
+        CountedExecutionPath c(0);
+        CountedExecutionPath::pathsAtEnd = 0;
+        ExecutionPathBudget budget;
+        checkExecutionPaths(tokenizer.tokens(), &c, &budget);
+        ASSERT(budget.exhausted == 0);
+        ASSERT_EQUALS(1, CountedExecutionPath::pathsAtEnd);
+
+        // The time is out before "x" is used
+        CountedExecutionPath::pathsAtEnd = 0;
+        budget.maxClocks = 5;
+        budget.getClock = fakeClock;
+        checkExecutionPaths(tokenizer.tokens(), &c, &budget);
+        ASSERT(budget.exhausted == 1);
+        ASSERT_EQUALS(0, CountedExecutionPath::pathsAtEnd);
+    }
+
     // handling for/while loops..
+    void executionPathsDeleted()
+    {
+        Settings settings;
+        Tokenizer tokenizer(&settings, this);
+        std::istringstream istr("void foo(int a)\n"
+                                "{\n"
+                                "    int x;\n"
+                                "    if (a == 1) { a = 2; }\n"
+                                "    if (a == 2) { x = 1; }\n"
+                                "    do { a++; } while (a < 10);\n"
+                                "    bar(x);\n"
+                                "}\n");
+        tokenizer.tokenize(istr, "test.cpp");
+        tokenizer.simplifyTokenList();
+
+        // The copies of the startup path and of the execution paths for
+        // "x" that are dropped in the "if" and "do" are deleted
+        CountedExecutionPath::instances = 0;
+        {
+            CountedExecutionPath c(0);
+            checkExecutionPaths(tokenizer.tokens(), &c);
+            ASSERT_EQUALS(1, CountedExecutionPath::instances);
+        }
+        ASSERT_EQUALS(0, CountedExecutionPath::instances);
+    }
+
     void uninitvar_loops()
     {
         // for..
@@ -18,6 +18,7 @@
 
 
 #include "tokenize.h"
+#include "sourcelocations.h"
 #include "checkclass.h"
 #include "testsuite.h"
 
@@ -50,6 +51,7 @@ private:
         TEST_CASE(classInClass);
         TEST_CASE(sameFunctionNames);
         TEST_CASE(incompleteImplementation);
+        TEST_CASE(structInlineFunction);
 
         TEST_CASE(derivedClass);   // skip warning for derived classes. It might be a virtual function.
 
@@ -60,7 +62,7 @@ private:
     }
 
 
-    void check(const char code[])
+    void check(const char code[], const SourceLocations *locations = 0)
     {
         // Clear the error buffer..
         errout.str("");
@@ -70,6 +72,7 @@ private:
 
         // Tokenize..
         Tokenizer tokenizer(&settings, this);
+        tokenizer.setSourceLocations(locations);
         std::istringstream istr(code);
         tokenizer.tokenize(istr, "test.cpp");
         tokenizer.simplifyTokenList();
@@ -99,8 +102,12 @@ private:
 
         ASSERT_EQUALS("[test.cpp:4]: (style) Unused private function 'Fred::f'\n", errout.str());
 
-        check("#file \"p.h\"\n"
-              "class Fred\n"
+        // The class is in p.h
+        SourceLocations locations1;
+        locations1.add(1, "test.cpp", 1);
+        locations1.add(1, "p.h", 1);
+        locations1.add(9, "test.cpp", 2);
+        check("class Fred\n"
               "{\n"
               "private:\n"
               "    unsigned int f();\n"
@@ -108,46 +115,49 @@ private:
               "    Fred();\n"
               "};\n"
               "\n"
-              "#endfile\n"
               "Fred::Fred()\n"
               "{ }\n"
               "\n"
               "unsigned int Fred::f()\n"
-              "{ }\n");
+              "{ }\n", &locations1);
 
         ASSERT_EQUALS("[p.h:4]: (style) Unused private function 'Fred::f'\n", errout.str());
 
-        check("#file \"p.h\"\n"
-              "class Fred\n"
+        SourceLocations locations2;
+        locations2.add(1, "test.cpp", 1);
+        locations2.add(1, "p.h", 1);
+        locations2.add(8, "test.cpp", 2);
+        check("class Fred\n"
               "{\n"
               "private:\n"
               "void f();\n"
               "};\n"
               "\n"
               "\n"
-              "#endfile\n"
               "\n"
               "void Fred::f()\n"
               "{\n"
               "}\n"
-              "\n");
+              "\n", &locations2);
         ASSERT_EQUALS("[p.h:4]: (style) Unused private function 'Fred::f'\n", errout.str());
 
         // Don't warn about include files which implementation we don't see
-        check("#file \"p.h\"\n"
-              "class Fred\n"
+        SourceLocations locations3;
+        locations3.add(1, "test.cpp", 1);
+        locations3.add(1, "p.h", 1);
+        locations3.add(8, "test.cpp", 2);
+        check("class Fred\n"
               "{\n"
               "private:\n"
               "void f();\n"
               "void g() {}\n"
               "};\n"
               "\n"
-              "#endfile\n"
               "\n"
               "int main()\n"
               "{\n"
               "}\n"
-              "\n");
+              "\n", &locations3);
         ASSERT_EQUALS("", errout.str());
     }
 
@@ -353,8 +363,11 @@ private:
     {
         // The implementation for "A::a" is missing - so don't check if
         // "A::b" is used or not
-        check("#file \"test.h\"\n"
-              "class A\n"
+        SourceLocations locations;
+        locations.add(1, "test.cpp", 1);
+        locations.add(1, "test.h", 1);
+        locations.add(9, "test.cpp", 2);
+        check("class A\n"
               "{\n"
               "public:\n"
               "    A()\n"
@@ -362,9 +375,8 @@ private:
               "private:\n"
               "    void b();\n"
               "};\n"
-              "#endfile\n"
               "A::A() { }\n"
-              "void A::b() { }\n");
+              "void A::b() { }\n", &locations);
         ASSERT_EQUALS("", errout.str());
     }
 
@@ -396,6 +408,22 @@ private:
         ASSERT_EQUALS("", errout.str());
     }
 
+    void structInlineFunction()
+    {
+        // private function called from an inline function in a struct
+        check("struct Fred\n"
+              "{\n"
+              "private:\n"
+              "    void f();\n"
+              "public:\n"
+              "    void g() { f(); }\n"
+              "    void h();\n"
+              "};\n"
+              "void Fred::f() { }\n"
+              "void Fred::h() { }\n");
+        ASSERT_EQUALS("", errout.str());
+    }
+
     void template1()
     {
         // ticket #2067 - Template methods do not "use" private ones